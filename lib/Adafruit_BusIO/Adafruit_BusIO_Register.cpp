@@ -19,14 +19,10 @@ Adafruit_BusIO_Register::Adafruit_BusIO_Register(Adafruit_I2CDevice *i2cdevice,
                                                  uint16_t reg_addr,
                                                  uint8_t width,
                                                  uint8_t byteorder,
-                                                 uint8_t address_width) {
-  _i2cdevice = i2cdevice;
-  _spidevice = nullptr;
-  _addrwidth = address_width;
-  _address = reg_addr;
-  _byteorder = byteorder;
-  _width = width;
-}
+                                                 uint8_t address_width)
+    : _reg(BusIO::DynamicBus{i2cdevice, nullptr, nullptr,
+                             ADDRBIT8_HIGH_TOREAD, nullptr},
+           reg_addr, width, byteorder, address_width) {}
 
 /*!
  *    @brief  Create a register we access over an SPI Device (which defines the
@@ -47,15 +43,9 @@ Adafruit_BusIO_Register::Adafruit_BusIO_Register(Adafruit_SPIDevice *spidevice,
                                                  Adafruit_BusIO_SPIRegType type,
                                                  uint8_t width,
                                                  uint8_t byteorder,
-                                                 uint8_t address_width) {
-  _spidevice = spidevice;
-  _spiregtype = type;
-  _i2cdevice = nullptr;
-  _addrwidth = address_width;
-  _address = reg_addr;
-  _byteorder = byteorder;
-  _width = width;
-}
+                                                 uint8_t address_width)
+    : _reg(BusIO::DynamicBus{nullptr, spidevice, nullptr, type, nullptr},
+           reg_addr, width, byteorder, address_width) {}
 
 /*!
  *    @brief  Create a register we access over an I2C or SPI Device. This is a
@@ -78,15 +68,9 @@ Adafruit_BusIO_Register::Adafruit_BusIO_Register(Adafruit_SPIDevice *spidevice,
 Adafruit_BusIO_Register::Adafruit_BusIO_Register(
     Adafruit_I2CDevice *i2cdevice, Adafruit_SPIDevice *spidevice,
     Adafruit_BusIO_SPIRegType type, uint16_t reg_addr, uint8_t width,
-    uint8_t byteorder, uint8_t address_width) {
-  _spidevice = spidevice;
-  _i2cdevice = i2cdevice;
-  _spiregtype = type;
-  _addrwidth = address_width;
-  _address = reg_addr;
-  _byteorder = byteorder;
-  _width = width;
-}
+    uint8_t byteorder, uint8_t address_width)
+    : _reg(BusIO::DynamicBus{i2cdevice, spidevice, nullptr, type, nullptr},
+           reg_addr, width, byteorder, address_width) {}
 
 /*!
  * @brief Create a register we access over a GenericDevice
@@ -98,15 +82,24 @@ Adafruit_BusIO_Register::Adafruit_BusIO_Register(
  */
 Adafruit_BusIO_Register::Adafruit_BusIO_Register(
     Adafruit_GenericDevice *genericdevice, uint16_t reg_addr, uint8_t width,
-    uint8_t byteorder, uint8_t address_width) {
-  _i2cdevice = nullptr;
-  _spidevice = nullptr;
-  _genericdevice = genericdevice;
-  _addrwidth = address_width;
-  _address = reg_addr;
-  _byteorder = byteorder;
-  _width = width;
-}
+    uint8_t byteorder, uint8_t address_width)
+    : _reg(BusIO::DynamicBus{nullptr, nullptr, genericdevice,
+                             ADDRBIT8_HIGH_TOREAD, nullptr},
+           reg_addr, width, byteorder, address_width) {}
+
+/*!
+ * @brief Create a register served from a RegisterBlock cache
+ * @param block Block covering this register
+ * @param reg_addr Register address we will read/write
+ * @param width Width of the register in bytes (1-4)
+ * @param byteorder Byte order of register data (LSBFIRST or MSBFIRST)
+ */
+Adafruit_BusIO_Register::Adafruit_BusIO_Register(
+    Adafruit_BusIO_RegisterBlock *block, uint16_t reg_addr, uint8_t width,
+    uint8_t byteorder)
+    : _reg(BusIO::DynamicBus{nullptr, nullptr, nullptr, ADDRBIT8_HIGH_TOREAD,
+                             block},
+           reg_addr, width, byteorder) {}
 
 /*!
  *    @brief  Write a buffer of data to the register location
@@ -116,39 +109,7 @@ Adafruit_BusIO_Register::Adafruit_BusIO_Register(
  * uncheckable)
  */
 bool Adafruit_BusIO_Register::write(uint8_t *buffer, uint8_t len) {
-  uint8_t addrbuffer[2] = {(uint8_t)(_address & 0xFF),
-                           (uint8_t)(_address >> 8)};
-  if (_i2cdevice) {
-    return _i2cdevice->write(buffer, len, true, addrbuffer, _addrwidth);
-  }
-  if (_spidevice) {
-    if (_spiregtype == ADDRESSED_OPCODE_BIT0_LOW_TO_WRITE) {
-      // very special case!
-      // pass the special opcode address which we set as the high byte of the
-      // regaddr
-      addrbuffer[0] =
-          (uint8_t)(_address >> 8) & ~0x01; // set bottom bit low to write
-      // the 'actual' reg addr is the second byte then
-      addrbuffer[1] = (uint8_t)(_address & 0xFF);
-      // the address appears to be a byte longer
-      return _spidevice->write(buffer, len, addrbuffer, _addrwidth + 1);
-    }
-    if (_spiregtype == ADDRBIT8_HIGH_TOREAD) {
-      addrbuffer[0] &= ~0x80;
-    }
-    if (_spiregtype == ADDRBIT8_HIGH_TOWRITE) {
-      addrbuffer[0] |= 0x80;
-    }
-    if (_spiregtype == AD8_HIGH_TOREAD_AD7_HIGH_TOINC) {
-      addrbuffer[0] &= ~0x80;
-      addrbuffer[0] |= 0x40;
-    }
-    return _spidevice->write(buffer, len, addrbuffer, _addrwidth);
-  }
-  if (_genericdevice) {
-    return _genericdevice->writeRegister(addrbuffer, _addrwidth, buffer, len);
-  }
-  return false;
+  return _reg.write(buffer, len);
 }
 
 /*!
@@ -159,25 +120,7 @@ bool Adafruit_BusIO_Register::write(uint8_t *buffer, uint8_t len) {
  * uncheckable)
  */
 bool Adafruit_BusIO_Register::write(uint32_t value, uint8_t numbytes) {
-  if (numbytes == 0) {
-    numbytes = _width;
-  }
-  if (numbytes > 4) {
-    return false;
-  }
-
-  // store a copy
-  _cached = value;
-
-  for (int i = 0; i < numbytes; i++) {
-    if (_byteorder == LSBFIRST) {
-      _buffer[i] = value & 0xFF;
-    } else {
-      _buffer[numbytes - i - 1] = value & 0xFF;
-    }
-    value >>= 8;
-  }
-  return write(_buffer, numbytes);
+  return _reg.write(value, numbytes);
 }
 
 /*!
@@ -186,29 +129,40 @@ bool Adafruit_BusIO_Register::write(uint32_t value, uint8_t numbytes) {
  *    @return Returns 0xFFFFFFFF on failure, value otherwise
  */
 uint32_t Adafruit_BusIO_Register::read(void) {
-  if (!read(_buffer, _width)) {
-    return -1;
-  }
+  return _reg.read();
+}
 
-  uint32_t value = 0;
+/*!
+ *    @brief  Read cached data from last time we wrote to this register
+ *    @return Returns 0xFFFFFFFF on failure, value otherwise
+ */
+uint32_t Adafruit_BusIO_Register::readCached(void) {
+  return _reg.readCached();
+}
 
-  for (int i = 0; i < _width; i++) {
-    value <<= 8;
-    if (_byteorder == LSBFIRST) {
-      value |= _buffer[_width - i - 1];
-    } else {
-      value |= _buffer[i];
-    }
-  }
+/*!
+ *    @brief  Read data from the device even in write-through mode
+ *    @return Returns 0xFFFFFFFF on failure, value otherwise
+ */
+uint32_t Adafruit_BusIO_Register::readUncached(void) {
+  return _reg.readUncached();
+}
 
-  return value;
+/*!
+ *    @brief  Turn the write-through cache on or off. When on, read() returns
+ * the last value written or read without touching the bus, so a
+ * RegisterBits::write() costs one bus write instead of a read and a write.
+ * Only use it for registers that nothing but the host changes
+ *    @param  enable True to serve reads from the cache
+ */
+void Adafruit_BusIO_Register::setWriteThrough(bool enable) {
+  _reg.setWriteThrough(enable);
 }
 
 /*!
- *    @brief  Read cached data from last time we wrote to this register
- *    @return Returns 0xFFFFFFFF on failure, value otherwise
+ *    @brief  Make the next read() go to the device
  */
-uint32_t Adafruit_BusIO_Register::readCached(void) { return _cached; }
+void Adafruit_BusIO_Register::invalidate(void) { _reg.invalidate(); }
 
 /*!
    @brief Read a number of bytes from a register into a buffer
@@ -217,39 +171,7 @@ uint32_t Adafruit_BusIO_Register::readCached(void) { return _cached; }
    @return true on successful read, otherwise false
 */
 bool Adafruit_BusIO_Register::read(uint8_t *buffer, uint8_t len) {
-  uint8_t addrbuffer[2] = {(uint8_t)(_address & 0xFF),
-                           (uint8_t)(_address >> 8)};
-  if (_i2cdevice) {
-    return _i2cdevice->write_then_read(addrbuffer, _addrwidth, buffer, len);
-  }
-  if (_spidevice) {
-    if (_spiregtype == ADDRESSED_OPCODE_BIT0_LOW_TO_WRITE) {
-      // very special case!
-      // pass the special opcode address which we set as the high byte of the
-      // regaddr
-      addrbuffer[0] =
-          (uint8_t)(_address >> 8) | 0x01; // set bottom bit high to read
-      // the 'actual' reg addr is the second byte then
-      addrbuffer[1] = (uint8_t)(_address & 0xFF);
-      // the address appears to be a byte longer
-      return _spidevice->write_then_read(addrbuffer, _addrwidth + 1, buffer,
-                                         len);
-    }
-    if (_spiregtype == ADDRBIT8_HIGH_TOREAD) {
-      addrbuffer[0] |= 0x80;
-    }
-    if (_spiregtype == ADDRBIT8_HIGH_TOWRITE) {
-      addrbuffer[0] &= ~0x80;
-    }
-    if (_spiregtype == AD8_HIGH_TOREAD_AD7_HIGH_TOINC) {
-      addrbuffer[0] |= 0x80 | 0x40;
-    }
-    return _spidevice->write_then_read(addrbuffer, _addrwidth, buffer, len);
-  }
-  if (_genericdevice) {
-    return _genericdevice->readRegister(addrbuffer, _addrwidth, buffer, len);
-  }
-  return false;
+  return _reg.read(buffer, len);
 }
 
 /*!
@@ -259,20 +181,7 @@ bool Adafruit_BusIO_Register::read(uint8_t *buffer, uint8_t len) {
  * uncheckable)
  */
 bool Adafruit_BusIO_Register::read(uint16_t *value) {
-  if (!read(_buffer, 2)) {
-    return false;
-  }
-
-  if (_byteorder == LSBFIRST) {
-    *value = _buffer[1];
-    *value <<= 8;
-    *value |= _buffer[0];
-  } else {
-    *value = _buffer[0];
-    *value <<= 8;
-    *value |= _buffer[1];
-  }
-  return true;
+  return _reg.read(value);
 }
 
 /*!
@@ -282,12 +191,7 @@ bool Adafruit_BusIO_Register::read(uint16_t *value) {
  * uncheckable)
  */
 bool Adafruit_BusIO_Register::read(uint8_t *value) {
-  if (!read(_buffer, 1)) {
-    return false;
-  }
-
-  *value = _buffer[0];
-  return true;
+  return _reg.read(value);
 }
 
 /*!
@@ -357,20 +261,28 @@ bool Adafruit_BusIO_RegisterBits::write(uint32_t data) {
  *    @brief  The width of the register data, helpful for doing calculations
  *    @returns The data width used when initializing the register
  */
-uint8_t Adafruit_BusIO_Register::width(void) { return _width; }
+uint8_t Adafruit_BusIO_Register::width(void) { return _reg.width(); }
+
+/*!
+ *    @brief  The register address
+ *    @returns The address used for bus access
+ */
+uint16_t Adafruit_BusIO_Register::address(void) { return _reg.address(); }
 
 /*!
  *    @brief  Set the default width of data
  *    @param width the default width of data read from register
  */
-void Adafruit_BusIO_Register::setWidth(uint8_t width) { _width = width; }
+void Adafruit_BusIO_Register::setWidth(uint8_t width) {
+  _reg.setWidth(width);
+}
 
 /*!
  *    @brief  Set register address
  *    @param address the address from register
  */
 void Adafruit_BusIO_Register::setAddress(uint16_t address) {
-  _address = address;
+  _reg.setAddress(address);
 }
 
 /*!
@@ -378,7 +290,208 @@ void Adafruit_BusIO_Register::setAddress(uint16_t address) {
  *    @param address_width the width for register address
  */
 void Adafruit_BusIO_Register::setAddressWidth(uint16_t address_width) {
-  _addrwidth = address_width;
+  _reg.setAddressWidth(address_width);
+}
+
+/*!
+ *    @brief  Read from whichever device is set, I2C first
+ *    @param  address Register address
+ *    @param  addrwidth Width of the register address in bytes
+ *    @param  data Buffer to read into
+ *    @param  len Number of bytes to read
+ *    @return True on success, false if no device is set
+ */
+bool BusIO::DynamicBus::read(uint16_t address, uint8_t addrwidth,
+                             uint8_t *data, size_t len) {
+  if (block) {
+    return block->read(address, data, len);
+  }
+  if (i2c) {
+    return I2CBus{i2c}.read(address, addrwidth, data, len);
+  }
+  if (spi) {
+    uint8_t addrbuffer[2];
+    spiAddress(spiregtype, address, addrwidth, addrbuffer, true);
+    return spi->write_then_read(addrbuffer, addrwidth, data, len);
+  }
+  if (generic) {
+    return GenericBus<Adafruit_GenericDevice>{generic}.read(address, addrwidth,
+                                                            data, len);
+  }
+  return false;
+}
+
+/*!
+ *    @brief  Write to whichever device is set, I2C first
+ *    @param  address Register address
+ *    @param  addrwidth Width of the register address in bytes
+ *    @param  data Data to write
+ *    @param  len Number of bytes to write
+ *    @return True on success, false if no device is set
+ */
+bool BusIO::DynamicBus::write(uint16_t address, uint8_t addrwidth,
+                              const uint8_t *data, size_t len) {
+  if (block) {
+    return block->write(address, data, len);
+  }
+  if (i2c) {
+    return I2CBus{i2c}.write(address, addrwidth, data, len);
+  }
+  if (spi) {
+    uint8_t addrbuffer[2];
+    spiAddress(spiregtype, address, addrwidth, addrbuffer, false);
+    return spi->write(data, len, addrbuffer, addrwidth);
+  }
+  if (generic) {
+    return GenericBus<Adafruit_GenericDevice>{generic}.write(address, addrwidth,
+                                                             data, len);
+  }
+  return false;
+}
+
+/*!
+ *    @brief  Create a cache for a range of registers
+ *    @param  first Register at the start of the range, it defines the bus
+ * and addressing. It is copied, and must not itself live on a block
+ *    @param  len Number of bytes in the range, up to 64
+ */
+Adafruit_BusIO_RegisterBlock::Adafruit_BusIO_RegisterBlock(
+    Adafruit_BusIO_Register *first, uint8_t len)
+    : _window(*first) {
+  _start = first->address();
+  _len = len > sizeof(_cache) ? sizeof(_cache) : len;
+}
+
+/*!
+ *    @brief  Read the whole range from the device in one transaction.
+ * Pending writes are kept and stay dirty
+ *    @return True on success
+ */
+bool Adafruit_BusIO_RegisterBlock::fetch(void) {
+  uint8_t buffer[sizeof(_cache)];
+  _window.setAddress(_start);
+  _transactions++;
+  if (!_window.read(buffer, _len)) {
+    return false;
+  }
+  for (uint8_t i = 0; i < _len; i++) {
+    if (!(_dirty & (1ULL << i))) {
+      _cache[i] = buffer[i];
+    }
+  }
+  _valid = mask(_start, _len);
+  return true;
+}
+
+/*!
+ *    @brief  Write every run of changed bytes, one transaction per run
+ *    @return True if all writes succeeded, failed runs stay dirty
+ */
+bool Adafruit_BusIO_RegisterBlock::flush(void) {
+  bool ok = true;
+  uint8_t i = 0;
+  while (i < _len) {
+    if (!(_dirty & (1ULL << i))) {
+      i++;
+      continue;
+    }
+    uint8_t run = i;
+    while (i < _len && (_dirty & (1ULL << i))) {
+      i++;
+    }
+    _window.setAddress(_start + run);
+    _transactions++;
+    if (_window.write(_cache + run, i - run)) {
+      _dirty &= ~mask(_start + run, i - run);
+    } else {
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+/*!
+ *    @brief  Forget the whole cache, the next reads go to the device.
+ * Pending writes are kept
+ */
+void Adafruit_BusIO_RegisterBlock::invalidate(void) { _valid = _dirty; }
+
+/*!
+ *    @brief  Forget part of the cache, e.g. a volatile status register
+ *    @param  address First register to forget
+ *    @param  len Number of bytes
+ */
+void Adafruit_BusIO_RegisterBlock::invalidate(uint16_t address, uint8_t len) {
+  _valid &= ~mask(address, len) | _dirty;
+}
+
+/*!
+ *    @brief  Whether the block covers a register range
+ *    @param  address First register
+ *    @param  len Number of bytes
+ *    @return True if the whole range is inside the block
+ */
+bool Adafruit_BusIO_RegisterBlock::contains(uint16_t address, uint8_t len) {
+  return address >= _start && (address + len) <= (_start + _len);
+}
+
+/*!
+ *    @brief  Read bytes from the cache, going to the device for bytes that
+ * are not cached
+ *    @param  address First register
+ *    @param  buffer Buffer to read into
+ *    @param  len Number of bytes
+ *    @return True on success, false if outside the block or the bus failed
+ */
+bool Adafruit_BusIO_RegisterBlock::read(uint16_t address, uint8_t *buffer,
+                                        uint8_t len) {
+  if (!contains(address, len)) {
+    return false;
+  }
+  uint64_t want = mask(address, len);
+  uint8_t offset = address - _start;
+
+  if ((_valid & want) != want) {
+    uint8_t fresh[sizeof(_cache)];
+    _window.setAddress(address);
+    _transactions++;
+    if (!_window.read(fresh, len)) {
+      return false;
+    }
+    for (uint8_t i = 0; i < len; i++) {
+      if (!(_dirty & (1ULL << (offset + i)))) {
+        _cache[offset + i] = fresh[i];
+      }
+    }
+    _valid |= want;
+  }
+
+  memcpy(buffer, _cache + offset, len);
+  return true;
+}
+
+/*!
+ *    @brief  Stage bytes in the cache, they reach the device on flush()
+ *    @param  address First register
+ *    @param  buffer Data to write
+ *    @param  len Number of bytes
+ *    @return True if the range is inside the block
+ */
+bool Adafruit_BusIO_RegisterBlock::write(uint16_t address,
+                                         const uint8_t *buffer, uint8_t len) {
+  if (!contains(address, len)) {
+    return false;
+  }
+  memcpy(_cache + (address - _start), buffer, len);
+  _valid |= mask(address, len);
+  _dirty |= mask(address, len);
+  return true;
+}
+
+uint64_t Adafruit_BusIO_RegisterBlock::mask(uint16_t address, uint8_t len) {
+  uint8_t offset = address - _start;
+  uint64_t bits = (len >= 64) ? ~0ULL : ((1ULL << len) - 1);
+  return bits << offset;
 }
 
 #endif // SPI exists
@@ -37,9 +37,294 @@ typedef enum _Adafruit_BusIO_SPIRegType {
 
 } Adafruit_BusIO_SPIRegType;
 
+class Adafruit_BusIO_RegisterBlock;
+
+namespace BusIO {
+
+/*!
+ * @brief Register transport over an Adafruit_I2CDevice
+ */
+struct I2CBus {
+  Adafruit_I2CDevice *dev; ///< Underlying I2C device
+
+  /*! @brief Read a register @param address Register address
+      @param addrwidth Address width in bytes @param data Destination
+      @param len Byte count @return true on success */
+  bool read(uint16_t address, uint8_t addrwidth, uint8_t *data, size_t len) {
+    uint8_t addrbuffer[2] = {(uint8_t)(address & 0xFF),
+                             (uint8_t)(address >> 8)};
+    return dev->write_then_read(addrbuffer, addrwidth, data, len);
+  }
+  /*! @brief Write a register @param address Register address
+      @param addrwidth Address width in bytes @param data Source
+      @param len Byte count @return true on success */
+  bool write(uint16_t address, uint8_t addrwidth, const uint8_t *data,
+             size_t len) {
+    uint8_t addrbuffer[2] = {(uint8_t)(address & 0xFF),
+                             (uint8_t)(address >> 8)};
+    return dev->write(data, len, true, addrbuffer, addrwidth);
+  }
+};
+
+/*!
+ * @brief Build the SPI address bytes for a register access
+ * @param type How the device marks reads and writes
+ * @param address Register address
+ * @param addrwidth Address width, updated for opcode-addressed devices
+ * @param addrbuffer Destination for the address bytes
+ * @param reading true for a read, false for a write
+ */
+inline void spiAddress(Adafruit_BusIO_SPIRegType type, uint16_t address,
+                       uint8_t &addrwidth, uint8_t *addrbuffer, bool reading) {
+  addrbuffer[0] = (uint8_t)(address & 0xFF);
+  addrbuffer[1] = (uint8_t)(address >> 8);
+  switch (type) {
+  case ADDRESSED_OPCODE_BIT0_LOW_TO_WRITE:
+    // very special case! the opcode is the high byte of the regaddr, the
+    // 'actual' reg addr is the second byte and the address is a byte longer
+    addrbuffer[0] = reading ? ((uint8_t)(address >> 8) | 0x01)
+                            : ((uint8_t)(address >> 8) & ~0x01);
+    addrbuffer[1] = (uint8_t)(address & 0xFF);
+    addrwidth++;
+    break;
+  case ADDRBIT8_HIGH_TOREAD:
+    if (reading)
+      addrbuffer[0] |= 0x80;
+    else
+      addrbuffer[0] &= ~0x80;
+    break;
+  case ADDRBIT8_HIGH_TOWRITE:
+    if (reading)
+      addrbuffer[0] &= ~0x80;
+    else
+      addrbuffer[0] |= 0x80;
+    break;
+  case AD8_HIGH_TOREAD_AD7_HIGH_TOINC:
+    if (reading) {
+      addrbuffer[0] |= 0x80 | 0x40;
+    } else {
+      addrbuffer[0] &= ~0x80;
+      addrbuffer[0] |= 0x40;
+    }
+    break;
+  }
+}
+
+/*!
+ * @brief Register transport over an Adafruit_SPIDevice, the read/write
+ * address convention is fixed at compile time
+ */
+template <Adafruit_BusIO_SPIRegType type> struct SPIBus {
+  Adafruit_SPIDevice *dev; ///< Underlying SPI device
+
+  /*! @brief Read a register @param address Register address
+      @param addrwidth Address width in bytes @param data Destination
+      @param len Byte count @return true on success */
+  bool read(uint16_t address, uint8_t addrwidth, uint8_t *data, size_t len) {
+    uint8_t addrbuffer[2];
+    spiAddress(type, address, addrwidth, addrbuffer, true);
+    return dev->write_then_read(addrbuffer, addrwidth, data, len);
+  }
+  /*! @brief Write a register @param address Register address
+      @param addrwidth Address width in bytes @param data Source
+      @param len Byte count @return true on success */
+  bool write(uint16_t address, uint8_t addrwidth, const uint8_t *data,
+             size_t len) {
+    uint8_t addrbuffer[2];
+    spiAddress(type, address, addrwidth, addrbuffer, false);
+    return dev->write(data, len, addrbuffer, addrwidth);
+  }
+};
+
+/*!
+ * @brief Register transport over a GenericDevice, e.g.
+ * GenericDevice<MyPolicy> or Adafruit_GenericDevice
+ */
+template <class Device> struct GenericBus {
+  Device *dev; ///< Underlying device
+
+  /*! @brief Read a register @param address Register address
+      @param addrwidth Address width in bytes @param data Destination
+      @param len Byte count @return true on success */
+  bool read(uint16_t address, uint8_t addrwidth, uint8_t *data, size_t len) {
+    uint8_t addrbuffer[2] = {(uint8_t)(address & 0xFF),
+                             (uint8_t)(address >> 8)};
+    return dev->readRegister(addrbuffer, addrwidth, data, len);
+  }
+  /*! @brief Write a register @param address Register address
+      @param addrwidth Address width in bytes @param data Source
+      @param len Byte count @return true on success */
+  bool write(uint16_t address, uint8_t addrwidth, const uint8_t *data,
+             size_t len) {
+    uint8_t addrbuffer[2] = {(uint8_t)(address & 0xFF),
+                             (uint8_t)(address >> 8)};
+    return dev->writeRegister(addrbuffer, addrwidth, data, len);
+  }
+};
+
+/*!
+ * @brief Transport picked at run time from whichever device pointer is set,
+ * the behaviour of Adafruit_BusIO_Register
+ */
+struct DynamicBus {
+  Adafruit_I2CDevice *i2c;              ///< I2C device or nullptr
+  Adafruit_SPIDevice *spi;              ///< SPI device or nullptr
+  Adafruit_GenericDevice *generic;      ///< Generic device or nullptr
+  Adafruit_BusIO_SPIRegType spiregtype; ///< SPI address convention
+  Adafruit_BusIO_RegisterBlock *block;  ///< Cache in front of a bus or nullptr
+
+  bool read(uint16_t address, uint8_t addrwidth, uint8_t *data, size_t len);
+  bool write(uint16_t address, uint8_t addrwidth, const uint8_t *data,
+             size_t len);
+};
+
+/*!
+ * @brief A device register whose transport is resolved at compile time
+ */
+template <class Bus> class Register {
+public:
+  /*!
+   * @brief Create a register on a bus
+   * @param bus Transport to use
+   * @param reg_addr Register address, 8 or 16 bits
+   * @param width Width of the register data in bytes (1-4)
+   * @param byteorder Byte order of register data (LSBFIRST or MSBFIRST)
+   * @param address_width Width of the register address in bytes (1 or 2)
+   */
+  Register(const Bus &bus, uint16_t reg_addr, uint8_t width = 1,
+           uint8_t byteorder = LSBFIRST, uint8_t address_width = 1)
+      : _bus(bus), _address(reg_addr), _width(width),
+        _addrwidth(address_width), _byteorder(byteorder) {}
+
+  /*! @brief Read bytes from the register @param buffer Destination
+      @param len Byte count @return true on success */
+  bool read(uint8_t *buffer, uint8_t len) {
+    return _bus.read(_address, _addrwidth, buffer, len);
+  }
+
+  /*! @brief Write bytes to the register. This drops the write-through
+      cache, use write(value) to keep it
+      @param buffer Source @param len Byte count @return true on success */
+  bool write(const uint8_t *buffer, uint8_t len) {
+    _cachevalid = false;
+    return _bus.write(_address, _addrwidth, buffer, len);
+  }
+
+  /*! @brief Read the register as one value. In write-through mode a known
+      value is returned from the cache without bus traffic
+      @return Value, 0xFFFFFFFF on failure */
+  uint32_t read(void) {
+    if (_writethrough && _cachevalid) {
+      return _cached;
+    }
+    return readUncached();
+  }
+
+  /*! @brief Read the register as one value from the device, refreshing the
+      write-through cache
+      @return Value, 0xFFFFFFFF on failure */
+  uint32_t readUncached(void) {
+    if (!read(_buffer, _width)) {
+      _cachevalid = false;
+      return -1;
+    }
+    uint32_t value = 0;
+    for (int i = 0; i < _width; i++) {
+      value <<= 8;
+      if (_byteorder == LSBFIRST) {
+        value |= _buffer[_width - i - 1];
+      } else {
+        value |= _buffer[i];
+      }
+    }
+    if (_writethrough) {
+      _cached = value;
+      _cachevalid = true;
+    }
+    return value;
+  }
+
+  /*! @brief Read 1 byte @param value Destination @return true on success */
+  bool read(uint8_t *value) { return read(value, 1); }
+
+  /*! @brief Read 2 bytes in register byte order @param value Destination
+      @return true on success */
+  bool read(uint16_t *value) {
+    if (!read(_buffer, 2)) {
+      return false;
+    }
+    if (_byteorder == LSBFIRST) {
+      *value = (uint16_t)_buffer[1] << 8 | _buffer[0];
+    } else {
+      *value = (uint16_t)_buffer[0] << 8 | _buffer[1];
+    }
+    return true;
+  }
+
+  /*! @brief Write up to 4 bytes @param value Data to write
+      @param numbytes How many bytes, 0 for the register width
+      @return true on success */
+  bool write(uint32_t value, uint8_t numbytes = 0) {
+    if (numbytes == 0) {
+      numbytes = _width;
+    }
+    if (numbytes > 4) {
+      return false;
+    }
+    _cached = value; // store a copy
+    for (int i = 0; i < numbytes; i++) {
+      if (_byteorder == LSBFIRST) {
+        _buffer[i] = value & 0xFF;
+      } else {
+        _buffer[numbytes - i - 1] = value & 0xFF;
+      }
+      value >>= 8;
+    }
+    bool ok = _bus.write(_address, _addrwidth, _buffer, numbytes);
+    _cachevalid = _writethrough && ok && numbytes == _width;
+    return ok;
+  }
+
+  /*! @brief Value of the last write @return Cached value */
+  uint32_t readCached(void) { return _cached; }
+
+  /*! @brief Serve read() from the last written or read value. Only for
+      registers the host owns exclusively, the device must never change them
+      @param enable true to turn write-through caching on */
+  void setWriteThrough(bool enable) {
+    _writethrough = enable;
+    _cachevalid = false;
+  }
+  /*! @brief Force the next read() to go to the device */
+  void invalidate(void) { _cachevalid = false; }
+  /*! @brief Register data width @return Width in bytes */
+  uint8_t width(void) { return _width; }
+  /*! @brief Set the data width @param width Width in bytes */
+  void setWidth(uint8_t width) { _width = width; }
+  /*! @brief Register address @return Address */
+  uint16_t address(void) { return _address; }
+  /*! @brief Set the register address @param address New address */
+  void setAddress(uint16_t address) { _address = address; }
+  /*! @brief Set the address width @param address_width Width in bytes */
+  void setAddressWidth(uint16_t address_width) { _addrwidth = address_width; }
+  /*! @brief The transport in use @return Reference to the bus */
+  Bus &bus(void) { return _bus; }
+
+private:
+  Bus _bus;
+  uint16_t _address;
+  uint8_t _width, _addrwidth, _byteorder;
+  uint8_t _buffer[4]; // we won't support anything larger than uint32 for
+                      // non-buffered read
+  uint32_t _cached = 0;
+  bool _writethrough = false, _cachevalid = false;
+};
+
+} // namespace BusIO
+
 /*!
  * @brief The class which defines a device register (a location to read/write
- * data from)
+ * data from). A thin wrapper over BusIO::Register picking the bus at run time
  */
 class Adafruit_BusIO_Register {
 public:
@@ -63,15 +348,24 @@ public:
                           uint8_t byteorder = LSBFIRST,
                           uint8_t address_width = 1);
 
+  Adafruit_BusIO_Register(Adafruit_BusIO_RegisterBlock *block,
+                          uint16_t reg_addr, uint8_t width = 1,
+                          uint8_t byteorder = LSBFIRST);
+
   bool read(uint8_t *buffer, uint8_t len);
   bool read(uint8_t *value);
   bool read(uint16_t *value);
   uint32_t read(void);
   uint32_t readCached(void);
+  uint32_t readUncached(void);
   bool write(uint8_t *buffer, uint8_t len);
   bool write(uint32_t value, uint8_t numbytes = 0);
 
+  void setWriteThrough(bool enable);
+  void invalidate(void);
+
   uint8_t width(void);
+  uint16_t address(void);
 
   void setWidth(uint8_t width);
   void setAddress(uint16_t address);
@@ -81,15 +375,7 @@ public:
   void println(Stream *s = &Serial);
 
 private:
-  Adafruit_I2CDevice *_i2cdevice;
-  Adafruit_SPIDevice *_spidevice;
-  Adafruit_GenericDevice *_genericdevice;
-  Adafruit_BusIO_SPIRegType _spiregtype;
-  uint16_t _address;
-  uint8_t _width, _addrwidth, _byteorder;
-  uint8_t _buffer[4]; // we won't support anything larger than uint32 for
-                      // non-buffered read
-  uint32_t _cached = 0;
+  BusIO::Register<BusIO::DynamicBus> _reg;
 };
 
 /*!
@@ -108,5 +394,46 @@ private:
   uint8_t _bits, _shift;
 };
 
+/*!
+ * @brief A cached copy of a contiguous range of registers.
+ *
+ * fetch() reads the whole range in one transaction. Registers created on the
+ * block (and RegisterBits on those) are then read from the cache, and their
+ * writes are collected until flush() sends each run of changed bytes as one
+ * burst. Bytes that were never fetched or were invalidated are read from the
+ * device on access, so call invalidate() before reading volatile registers
+ * such as STATUS. The device must auto-increment the register address.
+ */
+class Adafruit_BusIO_RegisterBlock {
+public:
+  Adafruit_BusIO_RegisterBlock(Adafruit_BusIO_Register *first, uint8_t len);
+
+  bool fetch(void);
+  bool flush(void);
+  void invalidate(void);
+  void invalidate(uint16_t address, uint8_t len = 1);
+
+  bool contains(uint16_t address, uint8_t len = 1);
+  bool read(uint16_t address, uint8_t *buffer, uint8_t len);
+  bool write(uint16_t address, const uint8_t *buffer, uint8_t len);
+
+  /*!   @brief  Whether writes are waiting for flush()
+   *    @return True if any byte is dirty */
+  bool dirty(void) { return _dirty != 0; }
+  /*!   @brief  Bus transactions issued by the block so far
+   *    @return Transaction count */
+  uint32_t transactions(void) { return _transactions; }
+
+private:
+  uint64_t mask(uint16_t address, uint8_t len);
+
+  Adafruit_BusIO_Register _window; ///< Moves over the range for bus access
+  uint16_t _start;
+  uint8_t _len;
+  uint8_t _cache[64];
+  uint64_t _valid = 0, _dirty = 0; ///< One bit per cached byte
+  uint32_t _transactions = 0;
+};
+
 #endif // SPI exists
 #endif // BusIO_Register_h
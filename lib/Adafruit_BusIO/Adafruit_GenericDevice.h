@@ -15,42 +15,155 @@ typedef bool (*busio_genericdevice_writereg_t)(void *obj, uint8_t *addr_buf,
                                                const uint8_t *data,
                                                uint16_t datalen);
 
+namespace BusIO {
+
 /*!
- * @brief Class for communicating with a device via generic read/write functions
+ * @brief Transport policy that calls through C function pointers, resolved at
+ * run time. This is what Adafruit_GenericDevice uses.
  */
-class Adafruit_GenericDevice {
+class CallbackPolicy {
 public:
-  Adafruit_GenericDevice(
-      void *obj, busio_genericdevice_read_t read_func,
-      busio_genericdevice_write_t write_func,
-      busio_genericdevice_readreg_t readreg_func = nullptr,
-      busio_genericdevice_writereg_t writereg_func = nullptr);
+  /*!
+   * @brief Store the callbacks
+   * @param obj Pointer handed back to every callback
+   * @param read_func Raw read
+   * @param write_func Raw write
+   * @param readreg_func Register read, optional
+   * @param writereg_func Register write, optional
+   */
+  CallbackPolicy(void *obj, busio_genericdevice_read_t read_func,
+                 busio_genericdevice_write_t write_func,
+                 busio_genericdevice_readreg_t readreg_func = nullptr,
+                 busio_genericdevice_writereg_t writereg_func = nullptr)
+      : _obj(obj), _read_func(read_func), _write_func(write_func),
+        _readreg_func(readreg_func), _writereg_func(writereg_func) {}
 
-  bool begin(void);
-  void end(void);
+  /*! @brief Raw read @param buffer Destination @param len Byte count
+      @return true on success */
+  bool read(uint8_t *buffer, size_t len) {
+    return _read_func(_obj, buffer, len);
+  }
+  /*! @brief Raw write @param buffer Source @param len Byte count
+      @return true on success */
+  bool write(const uint8_t *buffer, size_t len) {
+    return _write_func(_obj, buffer, len);
+  }
+  /*! @brief Register read @param addr_buf Address @param addrsiz Address
+      width @param buf Destination @param bufsiz Byte count
+      @return true on success, false if no register callback was given */
+  bool readRegister(const uint8_t *addr_buf, uint8_t addrsiz, uint8_t *buf,
+                    uint16_t bufsiz) {
+    if (!_readreg_func)
+      return false;
+    return _readreg_func(_obj, (uint8_t *)addr_buf, addrsiz, buf, bufsiz);
+  }
+  /*! @brief Register write @param addr_buf Address @param addrsiz Address
+      width @param buf Source @param bufsiz Byte count
+      @return true on success, false if no register callback was given */
+  bool writeRegister(const uint8_t *addr_buf, uint8_t addrsiz,
+                     const uint8_t *buf, uint16_t bufsiz) {
+    if (!_writereg_func)
+      return false;
+    return _writereg_func(_obj, (uint8_t *)addr_buf, addrsiz, buf, bufsiz);
+  }
 
-  bool read(uint8_t *buffer, size_t len);
-  bool write(const uint8_t *buffer, size_t len);
-  bool readRegister(uint8_t *addr_buf, uint8_t addrsiz, uint8_t *buf,
-                    uint16_t bufsiz);
-  bool writeRegister(uint8_t *addr_buf, uint8_t addrsiz, const uint8_t *buf,
-                     uint16_t bufsiz);
+private:
+  void *_obj;                                   ///< Callback context
+  busio_genericdevice_read_t _read_func;        ///< Raw read
+  busio_genericdevice_write_t _write_func;      ///< Raw write
+  busio_genericdevice_readreg_t _readreg_func;  ///< Register read
+  busio_genericdevice_writereg_t _writereg_func; ///< Register write
+};
 
-protected:
-  /*! @brief Function pointer for reading raw data from the device */
-  busio_genericdevice_read_t _read_func;
-  /*! @brief Function pointer for writing raw data to the device */
-  busio_genericdevice_write_t _write_func;
-  /*! @brief Function pointer for reading a 'register' from the device */
-  busio_genericdevice_readreg_t _readreg_func;
-  /*! @brief Function pointer for writing a 'register' to the device */
-  busio_genericdevice_writereg_t _writereg_func;
+/*!
+ * @brief Device reached through a transport policy known at compile time.
+ *
+ * Policy provides read(), write(), readRegister() and writeRegister() with
+ * the signatures of CallbackPolicy. With a policy whose members are inline
+ * the whole access path can be inlined, instead of going through void* and
+ * function pointers.
+ */
+template <class Policy> class GenericDevice {
+public:
+  /*! @brief Create the device @param policy Transport to use */
+  GenericDevice(const Policy &policy = Policy())
+      : _policy(policy), _begun(false) {}
+
+  /*! @brief Simple begin function (doesn't do much at this time)
+      @return true always */
+  bool begin(void) {
+    _begun = true;
+    return true;
+  }
+
+  /*!
+  @brief Marks the device as no longer in use.
+  @note: If the transport is a Serial object, this does NOT disable serial
+  communication or release the RX/TX pins. That must be done manually by
+  calling Serial.end().
+  */
+  void end(void) { _begun = false; }
+
+  /*! @brief Read data into a buffer
+     @param buffer Pointer to buffer to read data into
+     @param len Number of bytes to read
+     @return true if read was successful, otherwise false */
+  bool read(uint8_t *buffer, size_t len) {
+    return _begun && _policy.read(buffer, len);
+  }
+
+  /*! @brief Write a buffer of data
+     @param buffer Pointer to buffer of data to write
+     @param len Number of bytes to write
+     @return true if write was successful, otherwise false */
+  bool write(const uint8_t *buffer, size_t len) {
+    return _begun && _policy.write(buffer, len);
+  }
 
+  /*! @brief Read from a register location
+     @param addr_buf Buffer containing register address
+     @param addrsiz Size of register address in bytes
+     @param buf Buffer to store read data
+     @param bufsiz Size of data to read in bytes
+     @return true if read was successful, otherwise false */
+  bool readRegister(const uint8_t *addr_buf, uint8_t addrsiz, uint8_t *buf,
+                    uint16_t bufsiz) {
+    return _begun && _policy.readRegister(addr_buf, addrsiz, buf, bufsiz);
+  }
+
+  /*! @brief Write to a register location
+     @param addr_buf Buffer containing register address
+     @param addrsiz Size of register address in bytes
+     @param buf Buffer containing data to write
+     @param bufsiz Size of data to write in bytes
+     @return true if write was successful, otherwise false */
+  bool writeRegister(const uint8_t *addr_buf, uint8_t addrsiz,
+                     const uint8_t *buf, uint16_t bufsiz) {
+    return _begun && _policy.writeRegister(addr_buf, addrsiz, buf, bufsiz);
+  }
+
+  /*! @brief The transport in use @return Reference to the policy */
+  Policy &policy(void) { return _policy; }
+
+protected:
+  Policy _policy; ///< Transport
   bool _begun; ///< whether we have initialized yet (in case the function needs
                ///< to do something)
+};
 
-private:
-  void *_obj; ///< Pointer to object instance
+} // namespace BusIO
+
+/*!
+ * @brief Class for communicating with a device via generic read/write functions
+ */
+class Adafruit_GenericDevice
+    : public BusIO::GenericDevice<BusIO::CallbackPolicy> {
+public:
+  Adafruit_GenericDevice(
+      void *obj, busio_genericdevice_read_t read_func,
+      busio_genericdevice_write_t write_func,
+      busio_genericdevice_readreg_t readreg_func = nullptr,
+      busio_genericdevice_writereg_t writereg_func = nullptr);
 };
 
 #endif // ADAFRUIT_GENERICDEVICE_H
@@ -70,6 +70,17 @@ Adafruit_SPIDevice::Adafruit_SPIDevice(int8_t cspin, int8_t sckpin,
   clkPinMask = digitalPinToBitMask(sckpin);
 #endif
 
+#ifndef BUSIO_NO_SWSPI_KERNELS
+  // the kernels need MOSI, and on ESP32 only bank 0 (GPIO0-31) is handled
+  _swKernel = (mosipin != -1);
+#if defined(BUSIO_ESP32_FAST_GPIO)
+  _swKernel = _swKernel && (sckpin < 32) && (mosipin < 32) && (misopin < 32);
+  clkPinMask = 1UL << (sckpin & 31);
+  mosiPinMask = 1UL << (mosipin & 31);
+  misoPinMask = 1UL << (misopin & 31);
+#endif
+#endif
+
   _freq = freq;
   _dataOrder = dataOrder;
   _dataMode = dataMode;
@@ -150,6 +161,60 @@ void Adafruit_SPIDevice::transfer(uint8_t *buffer, size_t len) {
   //
   // SOFTWARE SPI
   //
+  if (len == 0)
+    return; // both bit loops start from buffer[0]
+#ifndef BUSIO_NO_SWSPI_KERNELS
+  // Unthrottled clock: use a loop specialised for the mode and bit order
+  if (_swKernel && ((1000000 / _freq) / 2) == 0) {
+    bool lsb = (_dataOrder == SPI_BITORDER_LSBFIRST);
+    bool miso = (_miso != -1);
+    switch (_dataMode) {
+    case SPI_MODE0:
+      if (lsb)
+        miso ? transferKernel<false, false, true, true>(buffer, len)
+             : transferKernel<false, false, true, false>(buffer, len);
+      else
+        miso ? transferKernel<false, false, false, true>(buffer, len)
+             : transferKernel<false, false, false, false>(buffer, len);
+      return;
+    case SPI_MODE1:
+      if (lsb)
+        miso ? transferKernel<false, true, true, true>(buffer, len)
+             : transferKernel<false, true, true, false>(buffer, len);
+      else
+        miso ? transferKernel<false, true, false, true>(buffer, len)
+             : transferKernel<false, true, false, false>(buffer, len);
+      return;
+    case SPI_MODE2:
+      if (lsb)
+        miso ? transferKernel<true, false, true, true>(buffer, len)
+             : transferKernel<true, false, true, false>(buffer, len);
+      else
+        miso ? transferKernel<true, false, false, true>(buffer, len)
+             : transferKernel<true, false, false, false>(buffer, len);
+      return;
+    default: // SPI_MODE3
+      if (lsb)
+        miso ? transferKernel<true, true, true, true>(buffer, len)
+             : transferKernel<true, true, true, false>(buffer, len);
+      else
+        miso ? transferKernel<true, true, false, true>(buffer, len)
+             : transferKernel<true, true, false, false>(buffer, len);
+      return;
+    }
+  }
+#endif
+
+  transferGeneric(buffer, len);
+}
+
+/*!
+ *    @brief  Bit-banged transfer for any mode and clock, checks the bit order
+ * and mode for every bit
+ *    @param  buffer The buffer to send and receive at the same time
+ *    @param  len    The number of bytes to transfer
+ */
+void Adafruit_SPIDevice::transferGeneric(uint8_t *buffer, size_t len) {
   uint8_t startbit;
   if (_dataOrder == SPI_BITORDER_LSBFIRST) {
     startbit = 0x1;
@@ -264,6 +329,117 @@ void Adafruit_SPIDevice::transfer(uint8_t *buffer, size_t len) {
   return;
 }
 
+#ifndef BUSIO_NO_SWSPI_KERNELS
+/*!
+ *    @brief  Drive the software SPI clock pin
+ *    @param  high True for a high level
+ */
+inline void Adafruit_SPIDevice::swClock(bool high) {
+#if defined(BUSIO_ESP32_FAST_GPIO)
+  REG_WRITE(high ? GPIO_OUT_W1TS_REG : GPIO_OUT_W1TC_REG, clkPinMask);
+#elif defined(BUSIO_USE_FAST_PINIO)
+  if (high)
+    *clkPort = *clkPort | clkPinMask;
+  else
+    *clkPort = *clkPort & ~clkPinMask;
+#else
+  digitalWrite(_sck, high);
+#endif
+}
+
+/*!
+ *    @brief  Drive the software SPI MOSI pin
+ *    @param  high True for a high level
+ */
+inline void Adafruit_SPIDevice::swMosi(bool high) {
+#if defined(BUSIO_ESP32_FAST_GPIO)
+  REG_WRITE(high ? GPIO_OUT_W1TS_REG : GPIO_OUT_W1TC_REG, mosiPinMask);
+#elif defined(BUSIO_USE_FAST_PINIO)
+  if (high)
+    *mosiPort = *mosiPort | mosiPinMask;
+  else
+    *mosiPort = *mosiPort & ~mosiPinMask;
+#else
+  digitalWrite(_mosi, high);
+#endif
+}
+
+/*!
+ *    @brief  Sample the software SPI MISO pin
+ *    @return True if MISO is high
+ */
+inline bool Adafruit_SPIDevice::swMiso(void) {
+#if defined(BUSIO_ESP32_FAST_GPIO)
+  return REG_READ(GPIO_IN_REG) & misoPinMask;
+#elif defined(BUSIO_USE_FAST_PINIO)
+  return *misoPort & misoPinMask;
+#else
+  return digitalRead(_miso);
+#endif
+}
+
+/*!
+ *    @brief  Clock out and sample a single bit, all mode checks are resolved
+ * at compile time
+ *    @param  send The byte being sent
+ *    @param  reply The byte being received, updated in place
+ *    @param  bit The mask of the bit to transfer
+ *    @param  lastmosi Last level driven on MOSI, updated in place
+ */
+template <bool cpol, bool cpha, bool hasMiso>
+inline void Adafruit_SPIDevice::transferBit(uint8_t send, uint8_t &reply,
+                                            uint8_t bit, bool &lastmosi) {
+  bool towrite = send & bit;
+  if (!cpha) {
+    // data valid before the leading edge, sampled on it
+    if (towrite != lastmosi) {
+      swMosi(towrite);
+      lastmosi = towrite;
+    }
+    swClock(!cpol);
+    if (hasMiso && swMiso())
+      reply |= bit;
+    swClock(cpol);
+  } else {
+    // data changes on the leading edge, sampled on the trailing one
+    swClock(!cpol);
+    if (towrite != lastmosi) {
+      swMosi(towrite);
+      lastmosi = towrite;
+    }
+    swClock(cpol);
+    if (hasMiso && swMiso())
+      reply |= bit;
+  }
+}
+
+/*!
+ *    @brief  Software SPI transfer with no bit delay, specialised per mode,
+ * bit order and MISO presence. Kept out of line and with the bit loop
+ * rolled: unrolled, or all inlined into transfer(), MISO transfers ran a
+ * third slower than the generic loop in tools/spi_bench
+ *    @param  buffer The buffer to send and receive at the same time
+ *    @param  len    The number of bytes to transfer
+ */
+template <bool cpol, bool cpha, bool lsbfirst, bool hasMiso>
+void Adafruit_SPIDevice::transferKernel(uint8_t *buffer, size_t len) {
+  bool lastmosi = !(buffer[0] & (lsbfirst ? 0x01 : 0x80));
+
+  for (size_t i = 0; i < len; i++) {
+    uint8_t send = buffer[i];
+    uint8_t reply = 0;
+
+    for (uint8_t bit = lsbfirst ? 0x01 : 0x80; bit;
+         bit = lsbfirst ? bit << 1 : bit >> 1)
+      transferBit<cpol, cpha, hasMiso>(send, reply, bit, lastmosi);
+
+    if (hasMiso) {
+      buffer[i] = reply;
+    }
+  }
+}
+#endif
+
 /*!
  *    @brief  Transfer (send/receive) one byte over hard/soft SPI, without
  * transaction management
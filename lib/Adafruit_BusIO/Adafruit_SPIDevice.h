@@ -91,6 +91,13 @@ typedef uint32_t BusIO_PortMask;
 #undef BUSIO_USE_FAST_PINIO
 #endif
 
+// ESP32 family: drive software SPI pins through the atomic W1TS/W1TC
+// registers instead of read-modify-write on the output register
+#if defined(ARDUINO_ARCH_ESP32) && defined(BUSIO_USE_FAST_PINIO)
+#include "soc/gpio_reg.h"
+#define BUSIO_ESP32_FAST_GPIO
+#endif
+
 /**! The class which defines how we will talk to this device over SPI **/
 class Adafruit_SPIDevice {
 public:
@@ -138,6 +145,19 @@ private:
   uint8_t _dataMode;
   void setChipSelect(int value);
 
+  void transferGeneric(uint8_t *buffer, size_t len);
+#ifndef BUSIO_NO_SWSPI_KERNELS
+  template <bool cpol, bool cpha, bool lsbfirst, bool hasMiso>
+  __attribute__((noinline)) void transferKernel(uint8_t *buffer, size_t len);
+  template <bool cpol, bool cpha, bool hasMiso>
+  inline void transferBit(uint8_t send, uint8_t &reply, uint8_t bit,
+                          bool &lastmosi);
+  inline void swClock(bool high);
+  inline void swMosi(bool high);
+  inline bool swMiso(void);
+  bool _swKernel = false; ///< Pins can be driven by the specialised kernels
+#endif
+
   int8_t _cs, _sck, _mosi, _miso;
 #ifdef BUSIO_USE_FAST_PINIO
   BusIO_PortReg *mosiPort, *clkPort, *misoPort, *csPort;
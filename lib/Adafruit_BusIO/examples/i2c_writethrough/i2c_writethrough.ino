@@ -0,0 +1,53 @@
+// Write-through cached registers: configuration registers that only the host
+// changes can be edited field by field with one bus write per change.
+// Shown on the feedback control register of a DRV2605 haptic driver.
+
+#include <Adafruit_BusIO_Register.h>
+#include <Adafruit_I2CDevice.h>
+
+#define I2C_ADDRESS 0x5A
+Adafruit_I2CDevice i2c_dev = Adafruit_I2CDevice(I2C_ADDRESS);
+
+Adafruit_BusIO_Register feedback_reg = Adafruit_BusIO_Register(&i2c_dev, 0x1A);
+Adafruit_BusIO_RegisterBits loop_gain =
+    Adafruit_BusIO_RegisterBits(&feedback_reg, 2, 2);
+Adafruit_BusIO_RegisterBits brake_factor =
+    Adafruit_BusIO_RegisterBits(&feedback_reg, 3, 4);
+
+void setup() {
+  while (!Serial) {
+    delay(10);
+  }
+  Serial.begin(115200);
+  Serial.println("I2C write-through register test");
+
+  if (!i2c_dev.begin()) {
+    Serial.print("Did not find device at 0x");
+    Serial.println(i2c_dev.address(), HEX);
+    while (1)
+      ;
+  }
+
+  feedback_reg.setWriteThrough(true);
+
+  // the first read goes to the device and fills the cache
+  Serial.print("Feedback register = 0x");
+  Serial.println(feedback_reg.read(), HEX);
+
+  // each field change is now a single write, no read-back
+  uint32_t start = micros();
+  for (uint8_t gain = 0; gain < 4; gain++) {
+    loop_gain.write(gain);
+    brake_factor.write(gain + 1);
+  }
+  Serial.print("8 field writes took ");
+  Serial.print(micros() - start);
+  Serial.println(" us");
+
+  Serial.print("Cached = 0x");
+  Serial.print(feedback_reg.read(), HEX);
+  Serial.print(", device = 0x");
+  Serial.println(feedback_reg.readUncached(), HEX);
+}
+
+void loop() {}
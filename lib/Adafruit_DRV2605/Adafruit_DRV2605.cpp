@@ -35,6 +35,23 @@
 
 #include <Adafruit_DRV2605.h>
 
+#include "DRV2605_RegisterMap.h"
+
+/// I2C clocks tried by autotuneClock(), slowest first
+static const uint32_t drv2605_clocks[] = {100000, 400000, 1000000};
+/// Number of entries in drv2605_clocks
+#define DRV2605_CLOCK_COUNT (sizeof(drv2605_clocks) / sizeof(drv2605_clocks[0]))
+
+/*!
+  @brief Read-modify-write of one register field on the device
+  @param drv Driver to use
+  @param value New field value
+*/
+template <class F>
+static void updateField(Adafruit_DRV2605 *drv, typename F::type value) {
+  drv->writeRegister8(F::reg, F::with(drv->readRegister8(F::reg), value));
+}
+
 /*========================================================================*/
 /*                            CONSTRUCTORS                                */
 /*========================================================================*/
@@ -61,6 +78,23 @@ bool Adafruit_DRV2605::begin(TwoWire *theWire) {
   if (i2c_dev)
     delete i2c_dev;
   i2c_dev = new Adafruit_I2CDevice(DRV2605_ADDR, theWire);
+  generic_dev = NULL;
+  return init();
+}
+
+/**************************************************************************/
+/*!
+  @brief Setup using a GenericDevice transport instead of I2C, for example a
+  DRV2605_Sim model on a host.
+  @param theDevice Pointer to a GenericDevice implementing register access
+  @return Return value from init()
+*/
+/**************************************************************************/
+bool Adafruit_DRV2605::begin(Adafruit_GenericDevice *theDevice) {
+  if (i2c_dev)
+    delete i2c_dev;
+  i2c_dev = NULL;
+  generic_dev = theDevice;
   return init();
 }
 
@@ -71,7 +105,7 @@ bool Adafruit_DRV2605::begin(TwoWire *theWire) {
 */
 /**************************************************************************/
 bool Adafruit_DRV2605::init() {
-  if (!i2c_dev->begin())
+  if (generic_dev ? !generic_dev->begin() : !i2c_dev->begin())
     return false;
   // uint8_t id = readRegister8(DRV2605_REG_STATUS);
   // Serial.print("Status 0x"); Serial.println(id, HEX);
@@ -93,11 +127,9 @@ bool Adafruit_DRV2605::init() {
   // ERM open loop
 
   // turn off N_ERM_LRA
-  writeRegister8(DRV2605_REG_FEEDBACK,
-                 readRegister8(DRV2605_REG_FEEDBACK) & 0x7F);
+  updateField<DRV2605::Feedback::ErmLra>(this, DRV2605::Actuator::ERM);
   // turn on ERM_OPEN_LOOP
-  writeRegister8(DRV2605_REG_CONTROL3,
-                 readRegister8(DRV2605_REG_CONTROL3) | 0x20);
+  updateField<DRV2605::Control3::ErmOpenLoop>(this, true);
 
   return true;
 }
@@ -164,6 +196,32 @@ void Adafruit_DRV2605::setMode(uint8_t mode) {
   writeRegister8(DRV2605_REG_MODE, mode);
 }
 
+/**************************************************************************/
+/*!
+  @brief Enter or leave software standby.
+  @param enable true to enter standby, false to return to the ready state.
+
+    The mode bits are kept, so playback resumes in the same mode after wake.
+  All register contents are retained while in standby (datasheet 7.4.1.1).
+*/
+/**************************************************************************/
+void Adafruit_DRV2605::standby(bool enable) {
+  uint8_t mode =
+      readRegister8(DRV2605_REG_MODE) & DRV2605::Mode::Select::mask;
+  DRV2605::Mode::Standby::set(mode, enable);
+  writeRegister8(DRV2605_REG_MODE, mode);
+}
+
+/**************************************************************************/
+/*!
+  @brief Check whether the device is in software standby.
+  @return true if the STANDBY bit of the mode register is set.
+*/
+/**************************************************************************/
+bool Adafruit_DRV2605::isStandby(void) {
+  return DRV2605::Mode::Standby::get(readRegister8(DRV2605_REG_MODE));
+}
+
 /**************************************************************************/
 /*!
   @brief Set the realtime value when in RTP mode, used to directly drive the
@@ -184,7 +242,11 @@ void Adafruit_DRV2605::setRealtimeValue(uint8_t rtp) {
 /**************************************************************************/
 uint8_t Adafruit_DRV2605::readRegister8(uint8_t reg) {
   uint8_t buffer[1] = {reg};
-  i2c_dev->write_then_read(buffer, 1, buffer, 1);
+  if (generic_dev) {
+    generic_dev->readRegister(buffer, 1, buffer, 1);
+    return buffer[0];
+  }
+  busResult(i2c_dev->write_then_read(buffer, 1, buffer, 1));
   return buffer[0];
 }
 
@@ -197,7 +259,49 @@ uint8_t Adafruit_DRV2605::readRegister8(uint8_t reg) {
 /**************************************************************************/
 void Adafruit_DRV2605::writeRegister8(uint8_t reg, uint8_t val) {
   uint8_t buffer[2] = {reg, val};
-  i2c_dev->write(buffer, 2);
+  if (generic_dev) {
+    generic_dev->writeRegister(buffer, 1, buffer + 1, 1);
+    return;
+  }
+  busResult(i2c_dev->write(buffer, 2));
+}
+
+/**************************************************************************/
+/*!
+  @brief Write consecutive registers in a single bus transaction.
+  @param reg The first register to write.
+  @param buffer Values for reg, reg + 1, ... (the chip auto-increments).
+  @param len Number of registers to write.
+  @return True on success.
+*/
+/**************************************************************************/
+bool Adafruit_DRV2605::writeRegisters(uint8_t reg, const uint8_t *buffer,
+                                      uint8_t len) {
+  if (generic_dev) {
+    return generic_dev->writeRegister(&reg, 1, buffer, len);
+  }
+  bool ok = i2c_dev->write(buffer, len, true, &reg, 1);
+  busResult(ok);
+  return ok;
+}
+
+/**************************************************************************/
+/*!
+  @brief Read consecutive registers in a single bus transaction.
+  @param reg The first register to read.
+  @param buffer Destination for reg, reg + 1, ...
+  @param len Number of registers to read.
+  @return True on success.
+*/
+/**************************************************************************/
+bool Adafruit_DRV2605::readRegisters(uint8_t reg, uint8_t *buffer,
+                                     uint8_t len) {
+  if (generic_dev) {
+    return generic_dev->readRegister(&reg, 1, buffer, len);
+  }
+  bool ok = i2c_dev->write_then_read(&reg, 1, buffer, len);
+  busResult(ok);
+  return ok;
 }
 
 /**************************************************************************/
@@ -206,8 +310,7 @@ void Adafruit_DRV2605::writeRegister8(uint8_t reg, uint8_t val) {
 */
 /**************************************************************************/
 void Adafruit_DRV2605::useERM() {
-  writeRegister8(DRV2605_REG_FEEDBACK,
-                 readRegister8(DRV2605_REG_FEEDBACK) & 0x7F);
+  updateField<DRV2605::Feedback::ErmLra>(this, DRV2605::Actuator::ERM);
 }
 
 /**************************************************************************/
@@ -216,6 +319,117 @@ void Adafruit_DRV2605::useERM() {
 */
 /**************************************************************************/
 void Adafruit_DRV2605::useLRA() {
-  writeRegister8(DRV2605_REG_FEEDBACK,
-                 readRegister8(DRV2605_REG_FEEDBACK) | 0x80);
+  updateField<DRV2605::Feedback::ErmLra>(this, DRV2605::Actuator::LRA);
+}
+
+/**************************************************************************/
+/*!
+  @brief Change the I2C clock used to talk to the driver.
+  @param clk SCL frequency in Hz.
+  @return True if the platform supports changing the I2C clock.
+*/
+/**************************************************************************/
+bool Adafruit_DRV2605::setClock(uint32_t clk) {
+  if (!i2c_dev || !i2c_dev->setSpeed(clk))
+    return false;
+  _clock = clk;
+  _nacks = 0;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+  @brief Check that the bus is reliable at a given clock.
+  @param clk SCL frequency in Hz to test.
+  @param rounds Number of write/readback patterns to verify.
+  @return True if every pattern was written and read back intact.
+
+    WAVESEQ8 is used as a scratch register, its value is restored afterwards.
+  The clock is left at clk on success and restored on failure.
+*/
+/**************************************************************************/
+bool Adafruit_DRV2605::probeClock(uint32_t clk, uint8_t rounds) {
+  if (!i2c_dev)
+    return false;
+  uint32_t oldclk = _clock;
+  uint8_t reg = DRV2605_REG_WAVESEQ8;
+  uint8_t saved[2] = {reg, 0};
+
+  if (!i2c_dev->write_then_read(saved, 1, saved + 1, 1))
+    return false;
+  if (!setClock(clk))
+    return false;
+
+  bool ok = true;
+  for (uint8_t i = 0; ok && i < rounds; i++) {
+    // alternating bits, walking ones and their inverse
+    uint8_t pattern = (i & 1) ? 0xAA : 0x55;
+    if (i >= 2)
+      pattern = (uint8_t)((i & 1) ? ~(1 << (i % 8)) : (1 << (i % 8)));
+
+    uint8_t buffer[2] = {reg, pattern};
+    uint8_t readback = ~pattern;
+    ok = i2c_dev->write(buffer, 2) &&
+         i2c_dev->write_then_read(buffer, 1, &readback, 1) &&
+         readback == pattern;
+  }
+
+  if (!ok)
+    setClock(oldclk);
+  i2c_dev->write(saved, 2);
+  return ok;
+}
+
+/**************************************************************************/
+/*!
+  @brief Find the fastest reliable I2C clock for the driver.
+  @param maxclk Highest clock in Hz allowed to be tried. Defaults to the
+  400 kHz fast-mode limit of the datasheet; pass DRV2605_I2C_FAST_MODE_PLUS
+  to also probe 1 MHz, which is out of spec and may pass readback on one
+  board while failing on the next.
+  @param rounds Number of write/readback patterns per clock step.
+  @return The clock selected, in Hz. It is already applied.
+
+    Steps through 100 kHz, 400 kHz and 1 MHz up to maxclk and stops at the
+  first step that fails verification.
+*/
+/**************************************************************************/
+uint32_t Adafruit_DRV2605::autotuneClock(uint32_t maxclk, uint8_t rounds) {
+  uint32_t best = drv2605_clocks[0];
+  setClock(best);
+
+  for (uint8_t i = 0; i < DRV2605_CLOCK_COUNT; i++) {
+    if (drv2605_clocks[i] > maxclk)
+      break;
+    if (!probeClock(drv2605_clocks[i], rounds))
+      break;
+    best = drv2605_clocks[i];
+  }
+
+  setClock(best);
+  return best;
+}
+
+/**************************************************************************/
+/*!
+  @brief Track bus failures, lowering the clock after repeated NACKs.
+  @param ok Whether the last transfer succeeded.
+*/
+/**************************************************************************/
+void Adafruit_DRV2605::busResult(bool ok) {
+  if (ok) {
+    _nacks = 0;
+    return;
+  }
+  if (++_nacks < DRV2605_I2C_NACK_LIMIT)
+    return;
+
+  for (int8_t i = DRV2605_CLOCK_COUNT - 1; i >= 0; i--) {
+    if (drv2605_clocks[i] < _clock) {
+      setClock(drv2605_clocks[i]);
+      _fallbacks++;
+      return;
+    }
+  }
+  _nacks = 0; // already at the slowest clock
 }
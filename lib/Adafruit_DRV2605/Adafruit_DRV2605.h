@@ -28,6 +28,7 @@
 #include "WProgram.h"
 #endif
 
+#include <Adafruit_GenericDevice.h>
 #include <Adafruit_I2CDevice.h>
 
 #define DRV2605_ADDR 0x5A ///< Device I2C address
@@ -42,6 +43,8 @@
 #define DRV2605_MODE_REALTIME 0x05    ///< Real-time playback (RTP) mode
 #define DRV2605_MODE_DIAGNOS 0x06     ///< Diagnostics mode
 #define DRV2605_MODE_AUTOCAL 0x07     ///< Auto calibration mode
+#define DRV2605_MODE_STANDBY 0x40     ///< Software standby bit of mode register
+#define DRV2605_MODE_DEVRESET 0x80    ///< Device reset bit of mode register
 
 #define DRV2605_REG_RTPIN 0x02    ///< Real-time playback input register
 #define DRV2605_REG_LIBRARY 0x03  ///< Waveform library selection register
@@ -79,9 +82,17 @@
 #define DRV2605_REG_CONTROL2 0x1C ///< Control2 Register
 #define DRV2605_REG_CONTROL3 0x1D ///< Control3 Register
 #define DRV2605_REG_CONTROL4 0x1E ///< Control4 Register
+#define DRV2605_REG_OLLRAPERIOD 0x20 ///< LRA open-loop period register
 #define DRV2605_REG_VBAT 0x21     ///< Vbat voltage-monitor register
 #define DRV2605_REG_LRARESON 0x22 ///< LRA resonance-period register
 
+#define DRV2605_I2C_NACK_LIMIT                                                 \
+  3 ///< Consecutive bus failures before falling back to a slower clock
+#define DRV2605_I2C_FAST_MODE                                                  \
+  400000 ///< Fast-mode SCL limit from the datasheet, the autotune default
+#define DRV2605_I2C_FAST_MODE_PLUS                                             \
+  1000000 ///< Out-of-spec SCL, only probed when passed to autotuneClock()
+
 /**************************************************************************/
 /*!
   @brief The DRV2605 driver class.
@@ -91,23 +102,46 @@ class Adafruit_DRV2605 {
 public:
   Adafruit_DRV2605(void);
   bool begin(TwoWire *theWire = &Wire);
+  bool begin(Adafruit_GenericDevice *theDevice);
 
   bool init();
   void writeRegister8(uint8_t reg, uint8_t val);
   uint8_t readRegister8(uint8_t reg);
+  bool writeRegisters(uint8_t reg, const uint8_t *buffer, uint8_t len);
+  bool readRegisters(uint8_t reg, uint8_t *buffer, uint8_t len);
   void setWaveform(uint8_t slot, uint8_t w);
   void selectLibrary(uint8_t lib);
   void go(void);
   void stop(void);
   void setMode(uint8_t mode);
   void setRealtimeValue(uint8_t rtp);
+  void standby(bool enable = true);
+  bool isStandby(void);
   // Select ERM (Eccentric Rotating Mass) or LRA (Linear Resonant Actuator)
   // vibration motor The default is ERM, which is more common
   void useERM();
   void useLRA();
 
+  bool setClock(uint32_t clk);
+  uint32_t autotuneClock(uint32_t maxclk = DRV2605_I2C_FAST_MODE,
+                         uint8_t rounds = 16);
+  bool probeClock(uint32_t clk, uint8_t rounds = 16);
+  /*!   @brief  Current I2C SCL clock used for the device
+   *    @return Clock in Hz */
+  uint32_t clock(void) { return _clock; }
+  /*!   @brief  How many times the clock was lowered after repeated NACKs
+   *    @return Fallback counter */
+  uint16_t clockFallbacks(void) { return _fallbacks; }
+
 private:
+  void busResult(bool ok);
+
   Adafruit_I2CDevice *i2c_dev = NULL; ///< Pointer to I2C bus interface
+  Adafruit_GenericDevice *generic_dev =
+      NULL; ///< Non-I2C transport, e.g. a simulated driver
+  uint32_t _clock = 100000;           ///< Current SCL clock, Hz
+  uint8_t _nacks = 0;                 ///< Consecutive failed transfers
+  uint16_t _fallbacks = 0;            ///< Automatic clock downgrades
 };
 
 #endif
@@ -0,0 +1,301 @@
+/*!
+ * @file DRV2605_RegisterMap.h
+ *
+ * Compile-time map of the DRV2605L registers and their bitfields.
+ *
+ * Every field is a type carrying its register address, shift and width, so
+ * reading or changing a field compiles to the same shift-and-mask code as a
+ * handwritten `(reg & ~mask) | (value << shift)`, with no tables in flash
+ * (tools/field_size compares the two at -Os).
+ * Accessors only work on register bytes (a shadow copy or a settings image);
+ * moving those bytes over the bus is left to the caller.
+ *
+ * Field names follow the DRV2605L datasheet (SLOS854), section 8.6.
+ */
+
+#ifndef DRV2605_REGISTERMAP_H
+#define DRV2605_REGISTERMAP_H
+
+#include <stdint.h>
+
+namespace DRV2605 {
+
+/*!
+ * @brief One bitfield of a DRV2605 register
+ * @tparam Reg Register address
+ * @tparam Shift Position of the least significant bit of the field
+ * @tparam Width Field width in bits
+ * @tparam T Value type: uint8_t, bool or an enum of the field's codes
+ */
+template <uint8_t Reg, uint8_t Shift, uint8_t Width, typename T = uint8_t>
+struct Field {
+  static_assert(Shift + Width <= 8, "field must fit into one register");
+
+  typedef T type;                                        ///< Value type
+  static constexpr uint8_t reg = Reg;                    ///< Register address
+  static constexpr uint8_t shift = Shift;                ///< Lowest bit
+  static constexpr uint8_t width = Width;                ///< Width in bits
+  static constexpr uint8_t maxValue = (1u << Width) - 1; ///< Largest raw value
+  static constexpr uint8_t mask = maxValue << Shift;     ///< Field bits
+
+  /*!
+   * @brief Extract the field from a register value
+   * @param value Register value
+   * @return Field value
+   */
+  static constexpr T get(uint8_t value) {
+    return static_cast<T>((value & mask) >> Shift);
+  }
+
+  /*!
+   * @brief Register value with the field replaced
+   * @param value Register value
+   * @param field New field value, extra high bits are dropped
+   * @return Updated register value
+   */
+  static constexpr uint8_t with(uint8_t value, T field) {
+    return (value & ~mask) | ((static_cast<uint8_t>(field) << Shift) & mask);
+  }
+
+  /*!
+   * @brief Replace the field in a register byte in place
+   * @param value Register byte to update
+   * @param field New field value
+   */
+  static void set(uint8_t &value, T field) { value = with(value, field); }
+};
+
+/*!
+ * @brief Field description for run-time use, e.g. a list of editable fields
+ */
+struct FieldRef {
+  const char *name; ///< Datasheet name
+  uint8_t reg;      ///< Register address
+  uint8_t shift;    ///< Lowest bit of the field
+  uint8_t width;    ///< Width in bits
+
+  /*!   @brief  Largest raw value of the field
+   *    @return (1 << width) - 1 */
+  constexpr uint8_t maxValue() const { return (1u << width) - 1; }
+  /*!   @brief  Extract the field from a register value
+   *    @param value Register value
+   *    @return Raw field value */
+  constexpr uint8_t get(uint8_t value) const {
+    return (value >> shift) & maxValue();
+  }
+  /*!   @brief  Register value with the field replaced
+   *    @param value Register value
+   *    @param field New raw field value
+   *    @return Updated register value */
+  constexpr uint8_t with(uint8_t value, uint8_t field) const {
+    return (value & ~(maxValue() << shift)) |
+           ((field & maxValue()) << shift);
+  }
+};
+
+/*!
+ * @brief Run-time description of a compile-time field
+ * @tparam F Field type
+ * @param name Name to show
+ * @return Field description
+ */
+template <class F> constexpr FieldRef fieldRef(const char *name) {
+  return {name, F::reg, F::shift, F::width};
+}
+
+/*!
+ * @brief Shadow copy of a contiguous range of registers
+ *
+ * Holds the last known register values; fields are read and changed here
+ * and the caller decides when and how the bytes go to the device.
+ *
+ * @tparam First Address of the first register
+ * @tparam Length Number of registers
+ */
+template <uint8_t First, uint8_t Length> struct RegisterWindow {
+  static constexpr uint8_t first = First;   ///< First register address
+  static constexpr uint8_t length = Length; ///< Number of registers
+
+  uint8_t bytes[Length]; ///< Register values, bytes[0] is register First
+
+  /*!   @brief  Whether a register lies in the window
+   *    @param reg Register address
+   *    @return true if bytes[] holds it */
+  static constexpr bool contains(uint8_t reg) {
+    return reg >= First && reg < First + Length;
+  }
+
+  /*!   @brief  Value of a register in the window
+   *    @param reg Register address, must be in the window
+   *    @return Reference to the shadow byte */
+  uint8_t &operator[](uint8_t reg) { return bytes[reg - First]; }
+  /*!   @brief  Value of a register in the window
+   *    @param reg Register address, must be in the window
+   *    @return Shadow byte */
+  uint8_t operator[](uint8_t reg) const { return bytes[reg - First]; }
+
+  /*!   @brief  Read a field from the shadow
+   *    @tparam F Field type of a register in the window
+   *    @return Field value */
+  template <class F> typename F::type get() const {
+    static_assert(contains(F::reg), "register outside the window");
+    return F::get(bytes[F::reg - First]);
+  }
+
+  /*!   @brief  Change a field in the shadow only
+   *    @tparam F Field type of a register in the window
+   *    @param value New field value */
+  template <class F> void set(typename F::type value) {
+    static_assert(contains(F::reg), "register outside the window");
+    F::set(bytes[F::reg - First], value);
+  }
+};
+
+/*! @brief Operating modes, MODE[2:0] */
+enum class OperatingMode : uint8_t {
+  InternalTrigger = 0,
+  ExternalEdge = 1,
+  ExternalLevel = 2,
+  PwmAnalog = 3,
+  AudioToVibe = 4,
+  RealTime = 5,
+  Diagnostics = 6,
+  AutoCalibration = 7
+};
+
+/*! @brief Actuator type, N_ERM_LRA */
+enum class Actuator : uint8_t { ERM = 0, LRA = 1 };
+
+/*! @brief Input of the PWM/Analog mode, N_PWM_ANALOG */
+enum class InputMode : uint8_t { PWM = 0, Analog = 1 };
+
+/// Register 0x00
+namespace Status {
+typedef Field<0x00, 5, 3> DeviceId;         ///< 3 - DRV2605, 7 - DRV2605L
+typedef Field<0x00, 3, 1, bool> DiagResult; ///< Diagnostics or autocal fail
+typedef Field<0x00, 1, 1, bool> OverTemp;   ///< Over-temperature detected
+typedef Field<0x00, 0, 1, bool> OcDetect;   ///< Over-current detected
+} // namespace Status
+
+/// Register 0x01
+namespace Mode {
+typedef Field<0x01, 7, 1, bool> DevReset;        ///< Device reset, self-clears
+typedef Field<0x01, 6, 1, bool> Standby;         ///< Software standby
+typedef Field<0x01, 0, 3, OperatingMode> Select; ///< Operating mode
+} // namespace Mode
+
+/// Register 0x02
+namespace RealTimePlayback {
+typedef Field<0x02, 0, 8> Input; ///< RTP_INPUT amplitude
+} // namespace RealTimePlayback
+
+/// Register 0x03
+namespace Library {
+typedef Field<0x03, 4, 1, bool> HiZ; ///< Output high impedance
+typedef Field<0x03, 0, 3> Select;    ///< Waveform library, 1-5 ERM, 6 LRA
+} // namespace Library
+
+/// Registers 0x04-0x0B
+namespace WaveSequence {
+/*! @brief One waveform sequencer slot
+ *  @tparam N Slot number 0-7 */
+template <uint8_t N> struct Slot {
+  static_assert(N < 8, "eight sequencer slots");
+  typedef Field<0x04 + N, 7, 1, bool> Wait; ///< Delay instead of an effect
+  typedef Field<0x04 + N, 0, 7> Effect;     ///< Effect, or delay x 10 ms
+};
+} // namespace WaveSequence
+
+/// Register 0x0C
+namespace Go {
+typedef Field<0x0C, 0, 1, bool> Start; ///< Start / still running
+} // namespace Go
+
+/// Registers 0x0D-0x10
+namespace TimeOffset {
+typedef Field<0x0D, 0, 8> Overdrive;  ///< ODT, signed
+typedef Field<0x0E, 0, 8> SustainPos; ///< SPT, signed
+typedef Field<0x0F, 0, 8> SustainNeg; ///< SNT, signed
+typedef Field<0x10, 0, 8> Brake;      ///< BRT, signed
+} // namespace TimeOffset
+
+/// Registers 0x11-0x15
+namespace AudioToVibe {
+typedef Field<0x11, 2, 2> PeakTime;   ///< ATH_PEAK_TIME
+typedef Field<0x11, 0, 2> FilterFreq; ///< ATH_FILTER
+typedef Field<0x12, 0, 8> MinInput;   ///< ATH_MIN_INPUT
+typedef Field<0x13, 0, 8> MaxInput;   ///< ATH_MAX_INPUT
+typedef Field<0x14, 0, 8> MinDrive;   ///< ATH_MIN_DRIVE
+typedef Field<0x15, 0, 8> MaxDrive;   ///< ATH_MAX_DRIVE
+} // namespace AudioToVibe
+
+/// Registers 0x16-0x19
+namespace Calibration {
+typedef Field<0x16, 0, 8> RatedVoltage;   ///< RATED_VOLTAGE
+typedef Field<0x17, 0, 8> OverdriveClamp; ///< OD_CLAMP
+typedef Field<0x18, 0, 8> Compensation;   ///< A_CAL_COMP
+typedef Field<0x19, 0, 8> BackEmf;        ///< A_CAL_BEMF
+} // namespace Calibration
+
+/// Register 0x1A
+namespace Feedback {
+typedef Field<0x1A, 7, 1, Actuator> ErmLra; ///< N_ERM_LRA
+typedef Field<0x1A, 4, 3> BrakeFactor;      ///< FB_BRAKE_FACTOR
+typedef Field<0x1A, 2, 2> LoopGain;         ///< LOOP_GAIN
+typedef Field<0x1A, 0, 2> BemfGain;         ///< BEMF_GAIN
+} // namespace Feedback
+
+/// Register 0x1B
+namespace Control1 {
+typedef Field<0x1B, 7, 1, bool> StartupBoost; ///< STARTUP_BOOST
+typedef Field<0x1B, 5, 1, bool> AcCouple;     ///< AC_COUPLE
+typedef Field<0x1B, 0, 5> DriveTime;          ///< DRIVE_TIME
+} // namespace Control1
+
+/// Register 0x1C
+namespace Control2 {
+typedef Field<0x1C, 7, 1, bool> BidirInput;      ///< BIDIR_INPUT
+typedef Field<0x1C, 6, 1, bool> BrakeStabilizer; ///< BRAKE_STABILIZER
+typedef Field<0x1C, 4, 2> SampleTime;            ///< SAMPLE_TIME
+typedef Field<0x1C, 2, 2> BlankingTime;          ///< BLANKING_TIME[1:0]
+typedef Field<0x1C, 0, 2> IdissTime;             ///< IDISS_TIME[1:0]
+} // namespace Control2
+
+/// Register 0x1D
+namespace Control3 {
+typedef Field<0x1D, 6, 2> NoiseGateThreshold;      ///< NG_THRESH
+typedef Field<0x1D, 5, 1, bool> ErmOpenLoop;       ///< ERM_OPEN_LOOP
+typedef Field<0x1D, 4, 1, bool> SupplyCompDisable; ///< SUPPLY_COMP_DIS
+typedef Field<0x1D, 3, 1, bool> RtpUnsigned;       ///< DATA_FORMAT_RTP
+typedef Field<0x1D, 2, 1, bool> LraDriveMode;      ///< LRA_DRIVE_MODE
+typedef Field<0x1D, 1, 1, InputMode> PwmAnalog;    ///< N_PWM_ANALOG
+typedef Field<0x1D, 0, 1, bool> LraOpenLoop;       ///< LRA_OPEN_LOOP
+} // namespace Control3
+
+/// Register 0x1E
+namespace Control4 {
+typedef Field<0x1E, 6, 2> ZeroCrossTime;    ///< ZC_DET_TIME
+typedef Field<0x1E, 4, 2> AutoCalTime;      ///< AUTO_CAL_TIME
+typedef Field<0x1E, 2, 1, bool> OtpStatus;  ///< OTP_STATUS
+typedef Field<0x1E, 0, 1, bool> OtpProgram; ///< OTP_PROGRAM
+} // namespace Control4
+
+/// Register 0x1F
+namespace Control5 {
+typedef Field<0x1F, 6, 2> AutoOpenLoopCount;         ///< AUTO_OL_CNT
+typedef Field<0x1F, 5, 1, bool> LraAutoOpenLoop;     ///< LRA_AUTO_OPEN_LOOP
+typedef Field<0x1F, 4, 1, bool> PlaybackInterval1ms; ///< PLAYBACK_INTERVAL
+typedef Field<0x1F, 2, 2> BlankingTimeHigh;          ///< BLANKING_TIME[3:2]
+typedef Field<0x1F, 0, 2> IdissTimeHigh;             ///< IDISS_TIME[3:2]
+} // namespace Control5
+
+/// Registers 0x20-0x22
+namespace Period {
+typedef Field<0x20, 0, 7> OpenLoopLra; ///< OL_LRA_PERIOD, 98.46 us steps
+typedef Field<0x21, 0, 8> Vbat;        ///< VBAT, 5.6 V full scale
+typedef Field<0x22, 0, 8> LraPeriod;   ///< LRA_PERIOD, 98.46 us steps
+} // namespace Period
+
+} // namespace DRV2605
+
+#endif
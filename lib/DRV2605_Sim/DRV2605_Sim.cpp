@@ -0,0 +1,453 @@
+/*!
+ * @file DRV2605_Sim.cpp
+ *
+ * Behavioural model of the DRV2605L haptic driver, see DRV2605_Sim.h
+ */
+
+#include "DRV2605_Sim.h"
+
+#include <Adafruit_DRV2605.h>
+
+#define SIM_VBAT_FULLSCALE 5.6f  ///< VBAT register full scale, volts
+#define SIM_LRA_PERIOD_US 98.46f ///< LRA_PERIOD register LSB, microseconds
+#define SIM_DIAG_US 100000UL     ///< Duration of a diagnostics run
+
+/// Power-on register values, datasheet table 6
+static const uint8_t sim_defaults[DRV2605_SIM_REGCOUNT] = {
+    SIM_STATUS_DEVICE_ID, // 0x00 STATUS
+    0x40,                 // 0x01 MODE: standby
+    0x00,                 // 0x02 RTP input
+    0x01,                 // 0x03 library
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 0x04-0x0B sequence
+    0x00,                                           // 0x0C GO
+    0x00, 0x00, 0x00, 0x00,                         // 0x0D-0x10 offsets
+    0x05, 0x19, 0xFF, 0x19, 0xFF,                   // 0x11-0x15 audio
+    0x3E,                                           // 0x16 rated voltage
+    0x8C,                                           // 0x17 OD clamp
+    0x0C,                                           // 0x18 A_CAL_COMP
+    0x6C,                                           // 0x19 A_CAL_BEMF
+    0x36,                                           // 0x1A feedback
+    0x93,                                           // 0x1B control1
+    0xF5,                                           // 0x1C control2
+    0xA0,                                           // 0x1D control3
+    0x20,                                           // 0x1E control4
+    0x80,                                           // 0x1F control5
+    0x33,                                           // 0x20 OL_LRA_PERIOD
+    0x00,                                           // 0x21 VBAT
+    0x00,                                           // 0x22 LRA period
+};
+
+/*========================================================================*/
+/*                            CONSTRUCTORS                                */
+/*========================================================================*/
+
+/*!
+ * @brief Create a simulated driver in its power-on state with a default LRA
+ */
+DRV2605_Sim::DRV2605_Sim(void)
+    : _device(this, readCallback, writeCallback, readRegCallback,
+              writeRegCallback) {
+  _motor.resonanceHz = 235;
+  _motor.driftHzPerC = -0.25f;
+  _motor.supplyV = 5.0f;
+  _motor.sagV = 0.35f;
+  _motor.heatCPerSec = 20.0f;
+  _motor.coolPerSec = 0.1f;
+  _motor.overTempC = 60;
+  _motor.calComp = 0x0D;
+  _motor.calBemf = 0x6D;
+  _motor.bemfGain = 2;
+  _motor.connected = true;
+  _motor.shorted = false;
+
+  _device.begin();
+  _last_micros = micros();
+  reset();
+}
+
+/*========================================================================*/
+/*                           PUBLIC FUNCTIONS                             */
+/*========================================================================*/
+
+/*!
+ * @brief Return all registers to power-on values, like MODE.DEV_RESET
+ */
+void DRV2605_Sim::reset(void) {
+  memcpy(_regs, sim_defaults, sizeof(_regs));
+  _busy_until_us = 0;
+  _pointer = 0;
+}
+
+/*!
+ * @brief Replace the motor and supply model
+ * @param motor New parameters
+ */
+void DRV2605_Sim::setMotor(const DRV2605_SimMotor &motor) { _motor = motor; }
+
+/*!
+ * @brief The GenericDevice to hand to drivers, already begun
+ * @return Pointer to the device backed by this model
+ */
+Adafruit_GenericDevice *DRV2605_Sim::device(void) { return &_device; }
+
+/*!
+ * @brief Read consecutive registers, the address auto-increments
+ * @param reg First register
+ * @param data Buffer for the values
+ * @param len Number of registers
+ * @return true always, like an I2C device that ACKs everything
+ */
+bool DRV2605_Sim::readRegisters(uint8_t reg, uint8_t *data, uint16_t len) {
+  update();
+  for (uint16_t i = 0; i < len; i++)
+    data[i] = readRegister(reg + i);
+  _pointer = reg + len;
+  _transactions++;
+  _bytes += len;
+  return true;
+}
+
+/*!
+ * @brief Write consecutive registers, the address auto-increments
+ * @param reg First register
+ * @param data Values to write
+ * @param len Number of registers
+ * @return true always
+ */
+bool DRV2605_Sim::writeRegisters(uint8_t reg, const uint8_t *data,
+                                 uint16_t len) {
+  update();
+  for (uint16_t i = 0; i < len; i++)
+    writeRegister(reg + i, data[i]);
+  _pointer = reg + len;
+  _transactions++;
+  _bytes += len;
+  return true;
+}
+
+/*!
+ * @brief Look at a register without side effects or bus accounting
+ * @param reg Register address
+ * @return Register value, 0 for unmapped addresses
+ */
+uint8_t DRV2605_Sim::peek(uint8_t reg) {
+  update();
+  return reg < DRV2605_SIM_REGCOUNT ? _regs[reg] : 0;
+}
+
+/*!
+ * @brief Advance the model to the current micros(). Register accesses do this
+ * on their own, call it when only time passes
+ */
+void DRV2605_Sim::update(void) {
+  uint32_t m = micros();
+  uint64_t prev = _now_us;
+  _now_us += (uint32_t)(m - _last_micros); // wrap-safe delta
+  _last_micros = m;
+
+  uint64_t driven = 0;
+  if ((_regs[DRV2605_REG_GO] & 0x01) && _busy_mode == DRV2605_MODE_INTTRIG) {
+    uint64_t end = _now_us < _busy_until_us ? _now_us : _busy_until_us;
+    driven = end > prev ? end - prev : 0;
+  }
+  _active_us += driven;
+
+  float dt = (_now_us - prev) / 1e6f;
+  _heatC += _motor.heatCPerSec * driveLevel() * (driven / 1e6f);
+  _heatC -= _heatC * _motor.coolPerSec * dt;
+  if (_heatC < 0)
+    _heatC = 0;
+
+  if (_heatC > _motor.overTempC) {
+    _regs[DRV2605_REG_STATUS] |= SIM_STATUS_OVER_TEMP;
+    if (_regs[DRV2605_REG_GO] & 0x01)
+      _busy_until_us = _now_us; // thermal shutdown ends playback
+  }
+
+  if ((_regs[DRV2605_REG_GO] & 0x01) && _now_us >= _busy_until_us)
+    finishGo();
+}
+
+/*!
+ * @brief Whether GO is still set
+ * @return true while playback, calibration or diagnostics run
+ */
+bool DRV2605_Sim::busy(void) {
+  update();
+  return _regs[DRV2605_REG_GO] & 0x01;
+}
+
+/*!
+ * @brief Raise latched fault bits in STATUS, e.g. SIM_STATUS_OC_DETECT
+ * @param bits STATUS bits to set, cleared again when STATUS is read
+ */
+void DRV2605_Sim::injectStatus(uint8_t bits) {
+  _regs[DRV2605_REG_STATUS] |= bits & 0x0F;
+}
+
+/*!
+ * @brief Approximate length of a ROM library effect
+ * @param effect Effect number 1-123
+ * @return Duration in milliseconds, 0 for unknown effects
+ */
+uint16_t DRV2605_Sim::effectDurationMs(uint8_t effect) {
+  if (effect == 0 || effect > 123)
+    return 0;
+  if (effect <= 9 || (effect >= 17 && effect <= 26))
+    return 60; // single clicks and ticks
+  if (effect <= 13)
+    return 180; // double and triple clicks
+  if (effect == 14)
+    return 400; // strong buzz
+  if (effect == 15)
+    return 750; // 750 ms alert
+  if (effect == 16)
+    return 1000; // 1000 ms alert
+  if (effect <= 36)
+    return 150; // short double clicks
+  if (effect <= 46)
+    return 250; // long double clicks
+  if (effect <= 51)
+    return 400; // buzz
+  if (effect <= 57)
+    return 600; // pulsing
+  if (effect <= 63)
+    return 50; // transition clicks
+  if (effect <= 69)
+    return 500; // transition hum
+  if (effect <= 117) {
+    static const uint16_t ramps[] = {1200, 700, 350}; // long, medium, short
+    return ramps[((effect - 70) / 2) % 3];
+  }
+  if (effect == 118)
+    return 5000; // long buzz meant to be stopped by the host
+  return 500;    // smooth hum
+}
+
+/*========================================================================*/
+/*                          GENERICDEVICE GLUE                            */
+/*========================================================================*/
+
+/*!
+ * @brief Raw read callback, continues from the last register pointer
+ * @param obj The DRV2605_Sim instance
+ * @param buffer Buffer to read into
+ * @param len Number of bytes
+ * @return true on success
+ */
+bool DRV2605_Sim::readCallback(void *obj, uint8_t *buffer, size_t len) {
+  DRV2605_Sim *sim = (DRV2605_Sim *)obj;
+  return sim->readRegisters(sim->_pointer, buffer, len);
+}
+
+/*!
+ * @brief Raw write callback, first byte is the register address
+ * @param obj The DRV2605_Sim instance
+ * @param buffer Address followed by data
+ * @param len Number of bytes
+ * @return true on success
+ */
+bool DRV2605_Sim::writeCallback(void *obj, const uint8_t *buffer, size_t len) {
+  DRV2605_Sim *sim = (DRV2605_Sim *)obj;
+  if (len == 0)
+    return true;
+  sim->_pointer = buffer[0];
+  if (len == 1)
+    return true; // address only, a read follows
+  return sim->writeRegisters(buffer[0], buffer + 1, len - 1);
+}
+
+/*!
+ * @brief Register read callback
+ * @param obj The DRV2605_Sim instance
+ * @param addr_buf Register address
+ * @param addrsiz Address width, must be 1
+ * @param data Buffer to read into
+ * @param datalen Number of bytes
+ * @return true on success
+ */
+bool DRV2605_Sim::readRegCallback(void *obj, uint8_t *addr_buf,
+                                  uint8_t addrsiz, uint8_t *data,
+                                  uint16_t datalen) {
+  if (addrsiz != 1)
+    return false;
+  return ((DRV2605_Sim *)obj)->readRegisters(addr_buf[0], data, datalen);
+}
+
+/*!
+ * @brief Register write callback
+ * @param obj The DRV2605_Sim instance
+ * @param addr_buf Register address
+ * @param addrsiz Address width, must be 1
+ * @param data Values to write
+ * @param datalen Number of bytes
+ * @return true on success
+ */
+bool DRV2605_Sim::writeRegCallback(void *obj, uint8_t *addr_buf,
+                                   uint8_t addrsiz, const uint8_t *data,
+                                   uint16_t datalen) {
+  if (addrsiz != 1)
+    return false;
+  return ((DRV2605_Sim *)obj)->writeRegisters(addr_buf[0], data, datalen);
+}
+
+/*========================================================================*/
+/*                          PRIVATE FUNCTIONS                             */
+/*========================================================================*/
+
+void DRV2605_Sim::writeRegister(uint8_t reg, uint8_t val) {
+  switch (reg) {
+  case DRV2605_REG_STATUS:
+  case DRV2605_REG_VBAT:
+  case DRV2605_REG_LRARESON:
+    return; // read-only
+
+  case DRV2605_REG_MODE:
+    if (val & DRV2605_MODE_DEVRESET) {
+      reset();
+      return;
+    }
+    // standby or a mode change aborts whatever is running
+    if ((_regs[DRV2605_REG_GO] & 0x01) &&
+        ((val & DRV2605_MODE_STANDBY) || (val & 0x07) != _busy_mode))
+      _regs[DRV2605_REG_GO] = 0;
+    _regs[reg] = val & 0x47;
+    return;
+
+  case DRV2605_REG_GO:
+    if (val & 0x01)
+      startGo();
+    else
+      _regs[reg] = 0; // cancel, no results are produced
+    return;
+
+  default:
+    if (reg < DRV2605_SIM_REGCOUNT)
+      _regs[reg] = val;
+  }
+}
+
+uint8_t DRV2605_Sim::readRegister(uint8_t reg) {
+  switch (reg) {
+  case DRV2605_REG_STATUS: {
+    uint8_t status = _regs[reg];
+    _regs[reg] &= ~(SIM_STATUS_OVER_TEMP | SIM_STATUS_OC_DETECT);
+    return status;
+  }
+  case DRV2605_REG_VBAT: {
+    float v = _motor.supplyV;
+    if (_regs[DRV2605_REG_GO] & 0x01)
+      v -= _motor.sagV * driveLevel();
+    int code = (int)(v * 255 / SIM_VBAT_FULLSCALE + 0.5f);
+    return constrain(code, 0, 255);
+  }
+  default:
+    return reg < DRV2605_SIM_REGCOUNT ? _regs[reg] : 0;
+  }
+}
+
+void DRV2605_Sim::startGo(void) {
+  uint8_t mode = _regs[DRV2605_REG_MODE];
+  if (mode & DRV2605_MODE_STANDBY)
+    return; // GO is ignored in standby
+  mode &= 0x07;
+
+  uint32_t duration;
+  switch (mode) {
+  case DRV2605_MODE_INTTRIG:
+    if (_motor.shorted) {
+      _regs[DRV2605_REG_STATUS] |= SIM_STATUS_OC_DETECT;
+      return;
+    }
+    duration = sequenceUs();
+    break;
+  case DRV2605_MODE_DIAGNOS:
+    duration = SIM_DIAG_US;
+    break;
+  case DRV2605_MODE_AUTOCAL: {
+    static const uint32_t caltime_ms[] = {150, 250, 500, 1000};
+    duration = caltime_ms[(_regs[DRV2605_REG_CONTROL4] >> 4) & 0x03] * 1000UL;
+    break;
+  }
+  default:
+    return; // GO has no meaning in the other modes
+  }
+
+  _regs[DRV2605_REG_GO] = 0x01;
+  _busy_mode = mode;
+  _busy_until_us = _now_us + duration;
+  _gos++;
+}
+
+void DRV2605_Sim::finishGo(void) {
+  _regs[DRV2605_REG_GO] = 0;
+  bool lra = _regs[DRV2605_REG_FEEDBACK] & 0x80;
+  bool motor_ok = _motor.connected && !_motor.shorted;
+
+  switch (_busy_mode) {
+  case DRV2605_MODE_INTTRIG:
+    if (lra && motor_ok) {
+      float period = 1e6f / (resonanceHz() * SIM_LRA_PERIOD_US);
+      _regs[DRV2605_REG_LRARESON] = constrain((int)(period + 0.5f), 0, 255);
+    }
+    break;
+
+  case DRV2605_MODE_DIAGNOS:
+    if (motor_ok)
+      _regs[DRV2605_REG_STATUS] &= ~SIM_STATUS_DIAG_RESULT;
+    else
+      _regs[DRV2605_REG_STATUS] |= SIM_STATUS_DIAG_RESULT;
+    if (_motor.shorted)
+      _regs[DRV2605_REG_STATUS] |= SIM_STATUS_OC_DETECT;
+    break;
+
+  case DRV2605_MODE_AUTOCAL:
+    if (!motor_ok || _regs[DRV2605_REG_RATEDV] == 0) {
+      _regs[DRV2605_REG_STATUS] |= SIM_STATUS_DIAG_RESULT;
+      break;
+    }
+    _regs[DRV2605_REG_STATUS] &= ~SIM_STATUS_DIAG_RESULT;
+    _regs[DRV2605_REG_AUTOCALCOMP] = _motor.calComp;
+    _regs[DRV2605_REG_AUTOCALEMP] = _motor.calBemf;
+    _regs[DRV2605_REG_FEEDBACK] =
+        (_regs[DRV2605_REG_FEEDBACK] & ~0x03) | (_motor.bemfGain & 0x03);
+    if (lra) {
+      float period = 1e6f / (resonanceHz() * SIM_LRA_PERIOD_US);
+      _regs[DRV2605_REG_LRARESON] = constrain((int)(period + 0.5f), 0, 255);
+    }
+    break;
+  }
+}
+
+/* Playback time of WAVESEQ1-8 including wait slots and time offsets */
+uint32_t DRV2605_Sim::sequenceUs(void) {
+  int32_t offset_ms = 5 * ((int8_t)_regs[DRV2605_REG_OVERDRIVE] +
+                           (int8_t)_regs[DRV2605_REG_SUSTAINPOS] +
+                           (int8_t)_regs[DRV2605_REG_SUSTAINNEG] +
+                           (int8_t)_regs[DRV2605_REG_BREAK]);
+  uint32_t total_ms = 0;
+
+  for (uint8_t slot = 0; slot < 8; slot++) {
+    uint8_t w = _regs[DRV2605_REG_WAVESEQ1 + slot];
+    if (w == 0)
+      break;
+    if (w & 0x80) {
+      total_ms += (w & 0x7F) * 10; // wait slot
+      continue;
+    }
+    int32_t ms = effectDurationMs(w) + offset_ms;
+    total_ms += ms > 0 ? ms : 0;
+  }
+  return total_ms * 1000UL;
+}
+
+/* Relative drive strength 0..1 from rated voltage and overdrive clamp */
+float DRV2605_Sim::driveLevel(void) {
+  return (_regs[DRV2605_REG_RATEDV] / 255.0f) *
+         (0.5f + _regs[DRV2605_REG_CLAMPV] / 510.0f);
+}
+
+/* Resonance shifted by heating */
+float DRV2605_Sim::resonanceHz(void) {
+  return _motor.resonanceHz + _motor.driftHzPerC * _heatC;
+}
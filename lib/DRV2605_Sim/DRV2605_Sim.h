@@ -0,0 +1,123 @@
+/*!
+ * @file DRV2605_Sim.h
+ *
+ * Behavioural model of the DRV2605L haptic driver for off-hardware testing.
+ *
+ * The model plugs into Adafruit_GenericDevice through its read/write
+ * callbacks and follows the register map of the real part: mode changes,
+ * software standby and reset, GO auto-clear after effect-specific playback
+ * times, auto-calibration and diagnostics results, STATUS bits and the
+ * VBAT/LRA period readbacks. Time comes from micros(), which on the host
+ * stand-in (tools/host) is a virtual clock, so hours of stand operation run
+ * in seconds.
+ *
+ * Effect durations are approximations of the ROM library, good enough for
+ * scheduling and timeout logic, not for waveform studies.
+ */
+
+#ifndef DRV2605_SIM_H
+#define DRV2605_SIM_H
+
+#include <Adafruit_GenericDevice.h>
+#include <Arduino.h>
+
+#define DRV2605_SIM_REGCOUNT 0x23 ///< Registers 0x00-0x22
+
+#define SIM_STATUS_DEVICE_ID 0xE0   ///< DEVICE_ID = 7, DRV2605L
+#define SIM_STATUS_DIAG_RESULT 0x08 ///< Diagnostics/calibration failed
+#define SIM_STATUS_OVER_TEMP 0x02   ///< Over temperature, latched
+#define SIM_STATUS_OC_DETECT 0x01   ///< Over current, latched
+
+/*!
+ * @brief Physical parameters of the simulated motor and supply
+ */
+typedef struct {
+  float resonanceHz;  ///< LRA resonance at room temperature
+  float driftHzPerC;  ///< Resonance shift per degree of heating
+  float supplyV;      ///< Supply voltage when idle
+  float sagV;         ///< Supply drop while driving at full scale
+  float heatCPerSec;  ///< Heating while driving at full scale
+  float coolPerSec;   ///< Fraction of the heating lost per second
+  float overTempC;    ///< Heating above ambient that trips OVER_TEMP
+  uint8_t calComp;    ///< Auto-calibration compensation result
+  uint8_t calBemf;    ///< Auto-calibration back-EMF result
+  uint8_t bemfGain;   ///< Auto-calibration BEMF_GAIN result (0-3)
+  bool connected;     ///< Motor present across OUT+/OUT-
+  bool shorted;       ///< Output short, trips OC_DETECT on playback
+} DRV2605_SimMotor;
+
+/*!
+ * @brief Register-level simulated DRV2605L
+ */
+class DRV2605_Sim {
+public:
+  DRV2605_Sim(void);
+
+  void reset(void);
+  void setMotor(const DRV2605_SimMotor &motor);
+  /*!   @brief  Motor model in use
+   *    @return Reference to the motor parameters */
+  DRV2605_SimMotor &motor(void) { return _motor; }
+
+  Adafruit_GenericDevice *device(void);
+
+  bool readRegisters(uint8_t reg, uint8_t *data, uint16_t len);
+  bool writeRegisters(uint8_t reg, const uint8_t *data, uint16_t len);
+  uint8_t peek(uint8_t reg);
+
+  void update(void);
+  bool busy(void);
+  void injectStatus(uint8_t bits);
+
+  static uint16_t effectDurationMs(uint8_t effect);
+
+  /*!   @brief  Register transactions served so far
+   *    @return Transaction count */
+  uint32_t transactions(void) { return _transactions; }
+  /*!   @brief  Data bytes moved so far, excluding address bytes
+   *    @return Byte count */
+  uint32_t bytes(void) { return _bytes; }
+  /*!   @brief  Number of accepted GO commands
+   *    @return GO count */
+  uint32_t goCount(void) { return _gos; }
+  /*!   @brief  Total time the output was driven
+   *    @return Microseconds of playback */
+  uint64_t activeUs(void) { return _active_us; }
+  /*!   @brief  Simulated time since construction
+   *    @return Microseconds */
+  uint64_t nowUs(void) { return _now_us; }
+
+  static bool readCallback(void *obj, uint8_t *buffer, size_t len);
+  static bool writeCallback(void *obj, const uint8_t *buffer, size_t len);
+  static bool readRegCallback(void *obj, uint8_t *addr_buf, uint8_t addrsiz,
+                              uint8_t *data, uint16_t datalen);
+  static bool writeRegCallback(void *obj, uint8_t *addr_buf, uint8_t addrsiz,
+                               const uint8_t *data, uint16_t datalen);
+
+private:
+  void writeRegister(uint8_t reg, uint8_t val);
+  uint8_t readRegister(uint8_t reg);
+  void startGo(void);
+  void finishGo(void);
+  uint32_t sequenceUs(void);
+  float driveLevel(void);
+  float resonanceHz(void);
+
+  DRV2605_SimMotor _motor;
+  Adafruit_GenericDevice _device;
+  uint8_t _regs[DRV2605_SIM_REGCOUNT];
+  uint8_t _pointer = 0; ///< Register pointer for raw read/write
+
+  uint64_t _now_us = 0;
+  uint32_t _last_micros = 0;
+  uint64_t _busy_until_us = 0;
+  uint8_t _busy_mode = 0; ///< Mode that started the running operation
+  float _heatC = 0;       ///< Heating above ambient
+
+  uint32_t _transactions = 0;
+  uint32_t _bytes = 0;
+  uint32_t _gos = 0;
+  uint64_t _active_us = 0;
+};
+
+#endif // DRV2605_SIM_H
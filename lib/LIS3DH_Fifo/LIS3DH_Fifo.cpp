@@ -0,0 +1,217 @@
+/*!
+ * @file LIS3DH_Fifo.cpp
+ *
+ * Streaming LIS3DH driver, see LIS3DH_Fifo.h
+ */
+
+#include "LIS3DH_Fifo.h"
+
+/// CTRL_REG1 ODR field per rate, datasheet table 31
+static const uint8_t rateOdr[] = {0x90, 0x80, 0x90};
+/// Output data rate per rate, Hz
+static const uint16_t rateHzTable[] = {1344, 1600, 5376};
+/// mg per digit, normal (10 bit) and low-power (8 bit) mode, datasheet table 4
+static const uint8_t sensitivity[2][4] = {{4, 8, 16, 48}, {16, 32, 64, 192}};
+
+/*========================================================================*/
+/*                            CONSTRUCTORS                                */
+/*========================================================================*/
+
+/*!
+ * @brief Free the transport created by begin()
+ */
+LIS3DH_Fifo::~LIS3DH_Fifo(void) {
+  if (i2c_dev)
+    delete i2c_dev;
+  if (spi_dev)
+    delete spi_dev;
+}
+
+/*========================================================================*/
+/*                           PUBLIC FUNCTIONS                             */
+/*========================================================================*/
+
+/*!
+ * @brief Set up over I2C and check WHO_AM_I
+ * @param addr I2C address, LIS3DH_DEFAULT_ADDR or 0x19
+ * @param theWire The Wire object to use
+ * @return true if a LIS3DH answered
+ */
+bool LIS3DH_Fifo::begin(uint8_t addr, TwoWire *theWire) {
+  if (i2c_dev)
+    delete i2c_dev;
+  i2c_dev = new Adafruit_I2CDevice(addr, theWire);
+  if (!i2c_dev->begin())
+    return false;
+  // Every burst is one write_then_read, it must fit the Wire buffer
+  _burstSamples = i2c_dev->maxBufferSize() / 6;
+  if (_burstSamples > LIS3DH_FIFO_DEPTH)
+    _burstSamples = LIS3DH_FIFO_DEPTH;
+  return probe();
+}
+
+/*!
+ * @brief Set up over hardware SPI (mode 3) and check WHO_AM_I
+ * @param csPin Chip select pin
+ * @param theSPI The SPI bus to use
+ * @return true if a LIS3DH answered
+ */
+bool LIS3DH_Fifo::begin(int8_t csPin, SPIClass *theSPI) {
+  if (spi_dev)
+    delete spi_dev;
+  spi_dev = new Adafruit_SPIDevice(csPin, LIS3DH_SPI_HZ, SPI_BITORDER_MSBFIRST,
+                                   SPI_MODE3, theSPI);
+  if (!spi_dev->begin())
+    return false;
+  _burstSamples = LIS3DH_FIFO_DEPTH;
+  return probe();
+}
+
+/*!
+ * @brief Set up using a GenericDevice transport, for example LIS3DH_Sim
+ * @param theDevice Device implementing register access; bit 7 of the
+ *        register address asks for auto-increment as on I2C
+ * @return true if a LIS3DH answered
+ */
+bool LIS3DH_Fifo::begin(Adafruit_GenericDevice *theDevice) {
+  generic_dev = theDevice;
+  if (!generic_dev->begin())
+    return false;
+  _burstSamples = LIS3DH_FIFO_DEPTH;
+  return probe();
+}
+
+/*!
+ * @brief Start sampling all three axes into the FIFO in stream mode
+ * @param rate Output data rate; the LP rates give 8-bit samples
+ * @param range Full scale
+ * @return true if every register write was acknowledged
+ */
+bool LIS3DH_Fifo::configure(lis3dh_fifo_rate_t rate,
+                            lis3dh_fifo_range_t range) {
+  bool lowPower = rate != LIS3DH_RATE_1344_HZ;
+  _rate = rate;
+  _shift = lowPower ? 8 : 6;
+  _mgPerDigit = sensitivity[lowPower][range];
+
+  // Stop, set the scale with BDU, then FIFO: bypass first to clear it
+  bool ok = writeRegister(LIS3DH_REG_CTRL1, 0);
+  ok = ok && writeRegister(LIS3DH_REG_CTRL4, LIS3DH_CTRL4_BDU | (range << 4));
+  ok = ok && writeRegister(LIS3DH_REG_CTRL5, LIS3DH_CTRL5_FIFO_EN);
+  ok = ok && writeRegister(LIS3DH_REG_FIFOCTRL, 0);
+  ok = ok && writeRegister(LIS3DH_REG_FIFOCTRL, LIS3DH_FIFOCTRL_STREAM);
+  ok = ok && writeRegister(LIS3DH_REG_CTRL1,
+                           rateOdr[rate] | (lowPower ? LIS3DH_CTRL1_LPEN : 0) |
+                               LIS3DH_CTRL1_XYZ);
+  return ok;
+}
+
+/*!
+ * @brief Output data rate set by configure()
+ * @return Samples per second
+ */
+uint16_t LIS3DH_Fifo::rateHz(void) { return rateHzTable[_rate]; }
+
+/*!
+ * @brief Number of unread samples in the FIFO
+ * @param full Set to whether the FIFO is full (the next sample overwrites)
+ * @return 0-32
+ */
+uint8_t LIS3DH_Fifo::available(bool *full) {
+  uint8_t src = 0;
+  readRegisters(LIS3DH_REG_FIFOSRC, &src, 1);
+  bool isFull = src & LIS3DH_FIFOSRC_OVRN;
+  if (full)
+    *full = isFull;
+  return isFull ? LIS3DH_FIFO_DEPTH : (src & LIS3DH_FIFOSRC_FSS);
+}
+
+/*!
+ * @brief Move what the FIFO holds into a buffer with as few burst reads as
+ * the transport allows
+ * @param out Samples in mg, oldest first
+ * @param maxSamples Room in out
+ * @return Number of samples written
+ */
+uint16_t LIS3DH_Fifo::drain(LIS3DH_Sample *out, uint16_t maxSamples) {
+  bool full;
+  uint16_t pending = available(&full);
+  if (full)
+    _overruns++;
+  if (pending > maxSamples)
+    pending = maxSamples;
+
+  uint8_t raw[6 * LIS3DH_FIFO_DEPTH];
+  uint16_t done = 0;
+  while (done < pending) {
+    uint16_t n = pending - done;
+    if (n > _burstSamples)
+      n = _burstSamples;
+    if (!readRegisters(LIS3DH_REG_OUT_X_L, raw, n * 6))
+      break;
+    _bursts++;
+
+    // Left-justified two's complement, low byte first
+    for (uint16_t i = 0; i < n; i++) {
+      const uint8_t *p = raw + 6 * i;
+      LIS3DH_Sample &s = out[done + i];
+      s.x = ((int16_t)(p[0] | (p[1] << 8)) >> _shift) * _mgPerDigit;
+      s.y = ((int16_t)(p[2] | (p[3] << 8)) >> _shift) * _mgPerDigit;
+      s.z = ((int16_t)(p[4] | (p[5] << 8)) >> _shift) * _mgPerDigit;
+    }
+    done += n;
+  }
+  _samples += done;
+  return done;
+}
+
+/*========================================================================*/
+/*                          PRIVATE FUNCTIONS                             */
+/*========================================================================*/
+
+/*!
+ * @brief Check WHO_AM_I and reset the counters
+ * @return true if the part is a LIS3DH
+ */
+bool LIS3DH_Fifo::probe(void) {
+  _overruns = 0;
+  _bursts = 0;
+  _samples = 0;
+  uint8_t id = 0;
+  return readRegisters(LIS3DH_REG_WHOAMI, &id, 1) && id == LIS3DH_WHOAMI;
+}
+
+/*!
+ * @brief Read consecutive registers in one transaction
+ * @param reg First register
+ * @param buffer Buffer for the values
+ * @param len Number of bytes
+ * @return true on success
+ */
+bool LIS3DH_Fifo::readRegisters(uint8_t reg, uint8_t *buffer, uint16_t len) {
+  uint8_t addr = reg;
+  if (spi_dev) {
+    addr |= LIS3DH_SPI_READ | (len > 1 ? LIS3DH_SPI_AUTOINC : 0);
+    return spi_dev->write_then_read(&addr, 1, buffer, len);
+  }
+  if (len > 1)
+    addr |= LIS3DH_I2C_AUTOINC;
+  if (generic_dev)
+    return generic_dev->readRegister(&addr, 1, buffer, len);
+  return i2c_dev && i2c_dev->write_then_read(&addr, 1, buffer, len);
+}
+
+/*!
+ * @brief Write one register
+ * @param reg Register address
+ * @param value Value to write
+ * @return true on success
+ */
+bool LIS3DH_Fifo::writeRegister(uint8_t reg, uint8_t value) {
+  if (generic_dev)
+    return generic_dev->writeRegister(&reg, 1, &value, 1);
+  uint8_t buffer[2] = {reg, value};
+  if (spi_dev)
+    return spi_dev->write(buffer, 2);
+  return i2c_dev && i2c_dev->write(buffer, 2);
+}
@@ -0,0 +1,126 @@
+/*!
+ * @file LIS3DH_Fifo.h
+ *
+ * Streaming driver for the ST LIS3DH accelerometer built around its 32-level
+ * hardware FIFO.
+ *
+ * The sensor runs in FIFO stream mode: it keeps the newest 32 samples and
+ * the host drains them with one FIFO_SRC read and one burst read of the
+ * output registers. With auto-increment the LIS3DH wraps from OUT_Z_H back
+ * to OUT_X_L while the FIFO is on, so a single transaction moves as many
+ * samples as the bus buffer holds. At 1.6 kHz the FIFO holds 20 ms; draining
+ * every few milliseconds loses nothing.
+ *
+ * Transport is an Adafruit_I2CDevice, an Adafruit_SPIDevice or any
+ * Adafruit_GenericDevice (for example the LIS3DH_Sim model).
+ */
+
+#ifndef LIS3DH_FIFO_H
+#define LIS3DH_FIFO_H
+
+#include <Adafruit_GenericDevice.h>
+#include <Adafruit_I2CDevice.h>
+#include <Adafruit_SPIDevice.h>
+#include <Arduino.h>
+
+#define LIS3DH_DEFAULT_ADDR 0x18 ///< SDO/SA0 low; 0x19 with SDO high
+#define LIS3DH_FIFO_DEPTH 32     ///< Samples in the hardware FIFO
+#define LIS3DH_SPI_HZ 5000000UL  ///< SPI clock, the part allows 10 MHz
+
+#define LIS3DH_REG_WHOAMI 0x0F   ///< WHO_AM_I, reads LIS3DH_WHOAMI
+#define LIS3DH_REG_CTRL1 0x20    ///< ODR, LPen, axis enables
+#define LIS3DH_REG_CTRL4 0x23    ///< BDU, full scale, HR
+#define LIS3DH_REG_CTRL5 0x24    ///< BOOT, FIFO_EN
+#define LIS3DH_REG_OUT_X_L 0x28  ///< First output register
+#define LIS3DH_REG_FIFOCTRL 0x2E ///< FIFO mode and watermark
+#define LIS3DH_REG_FIFOSRC 0x2F  ///< FIFO level and flags
+
+#define LIS3DH_WHOAMI 0x33           ///< WHO_AM_I value
+#define LIS3DH_FIFOSRC_OVRN 0x40     ///< FIFO full, the next sample overwrites
+#define LIS3DH_FIFOSRC_EMPTY 0x20    ///< FIFO empty
+#define LIS3DH_FIFOSRC_FSS 0x1F      ///< Unread samples
+#define LIS3DH_FIFOCTRL_STREAM 0x80  ///< FM = 10, stream mode
+#define LIS3DH_CTRL5_FIFO_EN 0x40    ///< FIFO enable
+#define LIS3DH_CTRL4_BDU 0x80        ///< Block data update
+#define LIS3DH_CTRL4_HR 0x08         ///< High resolution (12 bit)
+#define LIS3DH_CTRL1_LPEN 0x08       ///< Low-power mode (8 bit)
+#define LIS3DH_CTRL1_XYZ 0x07        ///< All three axes on
+#define LIS3DH_I2C_AUTOINC 0x80      ///< Sub-address auto-increment over I2C
+#define LIS3DH_SPI_READ 0x80         ///< SPI read bit
+#define LIS3DH_SPI_AUTOINC 0x40      ///< SPI address auto-increment
+
+/*!
+ * @brief Output data rates usable for vibration capture
+ */
+typedef enum {
+  LIS3DH_RATE_1344_HZ,    ///< Normal mode, 10 bit
+  LIS3DH_RATE_1600_HZ_LP, ///< Low-power mode, 8 bit
+  LIS3DH_RATE_5376_HZ_LP, ///< Low-power mode, 8 bit
+} lis3dh_fifo_rate_t;
+
+/*!
+ * @brief Full-scale ranges
+ */
+typedef enum {
+  LIS3DH_RANGE_2_G,  ///< +-2 g
+  LIS3DH_RANGE_4_G,  ///< +-4 g
+  LIS3DH_RANGE_8_G,  ///< +-8 g
+  LIS3DH_RANGE_16_G, ///< +-16 g
+} lis3dh_fifo_range_t;
+
+/*!
+ * @brief One acceleration sample in milli-g
+ */
+typedef struct {
+  int16_t x; ///< X axis, mg
+  int16_t y; ///< Y axis, mg
+  int16_t z; ///< Z axis, mg
+} LIS3DH_Sample;
+
+/*!
+ * @brief LIS3DH in FIFO stream mode, drained with burst reads
+ */
+class LIS3DH_Fifo {
+public:
+  ~LIS3DH_Fifo(void);
+
+  bool begin(uint8_t addr = LIS3DH_DEFAULT_ADDR, TwoWire *theWire = &Wire);
+  bool begin(int8_t csPin, SPIClass *theSPI);
+  bool begin(Adafruit_GenericDevice *theDevice);
+
+  bool configure(lis3dh_fifo_rate_t rate, lis3dh_fifo_range_t range);
+  uint16_t rateHz(void);
+
+  uint8_t available(bool *full = NULL);
+  uint16_t drain(LIS3DH_Sample *out, uint16_t maxSamples);
+
+  /*!   @brief  Drains that found the FIFO full, samples may be lost
+   *    @return Count since begin() */
+  uint32_t overruns(void) { return _overruns; }
+  /*!   @brief  Burst transactions on the output registers
+   *    @return Count since begin() */
+  uint32_t bursts(void) { return _bursts; }
+  /*!   @brief  Samples drained
+   *    @return Count since begin() */
+  uint32_t samples(void) { return _samples; }
+
+private:
+  bool probe(void);
+  bool readRegisters(uint8_t reg, uint8_t *buffer, uint16_t len);
+  bool writeRegister(uint8_t reg, uint8_t value);
+
+  Adafruit_I2CDevice *i2c_dev = NULL;         ///< I2C transport
+  Adafruit_SPIDevice *spi_dev = NULL;         ///< SPI transport
+  Adafruit_GenericDevice *generic_dev = NULL; ///< Any other transport
+
+  lis3dh_fifo_rate_t _rate = LIS3DH_RATE_1600_HZ_LP;
+  uint8_t _shift = 8;       ///< Right shift of the left-justified output
+  uint8_t _mgPerDigit = 32; ///< Sensitivity after the shift
+  uint16_t _burstSamples = LIS3DH_FIFO_DEPTH; ///< Samples per transaction
+
+  uint32_t _overruns = 0;
+  uint32_t _bursts = 0;
+  uint32_t _samples = 0;
+};
+
+#endif // LIS3DH_FIFO_H
@@ -0,0 +1,333 @@
+/*!
+ * @file LIS3DH_Sim.cpp
+ *
+ * Register-level model of the LIS3DH FIFO, see LIS3DH_Sim.h
+ */
+
+#include "LIS3DH_Sim.h"
+
+/// mg per digit, normal (10 bit) and low-power (8 bit) mode, datasheet table 4
+static const uint8_t sim_sensitivity[2][4] = {{4, 8, 16, 48},
+                                              {16, 32, 64, 192}};
+
+/*========================================================================*/
+/*                            CONSTRUCTORS                                */
+/*========================================================================*/
+
+/*!
+ * @brief Create a powered-down LIS3DH with an empty FIFO
+ */
+LIS3DH_Sim::LIS3DH_Sim(void)
+    : _device(this, readCallback, writeCallback, readRegCallback,
+              writeRegCallback) {
+  memset(_regs, 0, sizeof(_regs));
+  _regs[LIS3DH_REG_WHOAMI] = LIS3DH_WHOAMI;
+  _regs[LIS3DH_REG_CTRL1] = 0x07; // power-down, axes enabled
+  _device.begin();
+  _last_micros = micros();
+}
+
+/*========================================================================*/
+/*                           PUBLIC FUNCTIONS                             */
+/*========================================================================*/
+
+/*!
+ * @brief The GenericDevice to hand to LIS3DH_Fifo, already begun
+ * @return Pointer to the device backed by this model
+ */
+Adafruit_GenericDevice *LIS3DH_Sim::device(void) { return &_device; }
+
+/*!
+ * @brief Samples to replay, at the configured output data rate
+ * @param samples Acceleration in mg; must outlive the model
+ * @param count Number of samples
+ */
+void LIS3DH_Sim::setRecording(const LIS3DH_Sample *samples, size_t count) {
+  _recording = samples;
+  _count = count;
+  _playing = false;
+}
+
+/*!
+ * @brief Start the recording with the next sample the sensor takes
+ */
+void LIS3DH_Sim::play(void) {
+  update();
+  _index = 0;
+  _playing = _count > 0;
+}
+
+/*!
+ * @brief What the host reads back for an acceleration in the current mode
+ * @param mg Acceleration
+ * @return Acceleration after quantisation and clipping, mg
+ */
+int16_t LIS3DH_Sim::quantize(int16_t mg) {
+  uint8_t scale = (_regs[LIS3DH_REG_CTRL4] >> 4) & 0x03;
+  int16_t step = sim_sensitivity[lowPower()][scale];
+  int16_t limit = lowPower() ? 127 : 511;
+  // The part truncates towards minus infinity like an arithmetic shift
+  int32_t digits = mg >= 0 ? mg / step : -((-mg + step - 1) / step);
+  if (digits > limit)
+    digits = limit;
+  if (digits < -limit - 1)
+    digits = -limit - 1;
+  return digits * step;
+}
+
+/*!
+ * @brief Advance the model to the current micros(), taking every sample due
+ */
+void LIS3DH_Sim::update(void) {
+  uint32_t m = micros();
+  _now_us += (uint32_t)(m - _last_micros); // wrap-safe delta
+  _last_micros = m;
+
+  uint32_t rate = rateHz();
+  if (rate == 0) {
+    _next_sample_ns = _now_us * 1000;
+    return;
+  }
+  uint64_t period = 1000000000ULL / rate;
+  while (_next_sample_ns <= _now_us * 1000) {
+    produce();
+    _next_sample_ns += period;
+  }
+}
+
+/*!
+ * @brief Read consecutive registers
+ * @param reg First register
+ * @param data Buffer for the values
+ * @param len Number of registers
+ * @param autoinc Whether the address advances (bit 7 of the sub-address)
+ * @return true always
+ */
+bool LIS3DH_Sim::readRegisters(uint8_t reg, uint8_t *data, uint16_t len,
+                               bool autoinc) {
+  update();
+  for (uint16_t i = 0; i < len; i++) {
+    data[i] = readRegister(reg);
+    if (!autoinc)
+      continue;
+    // With the FIFO on, the output block wraps so bursts drain it
+    if (reg == LIS3DH_REG_OUT_X_L + 5 && fifoOn())
+      reg = LIS3DH_REG_OUT_X_L;
+    else
+      reg = (reg + 1) & (LIS3DH_SIM_REGCOUNT - 1);
+  }
+  _pointer = reg;
+  _transactions++;
+  _bytes += len;
+  return true;
+}
+
+/*!
+ * @brief Write consecutive registers
+ * @param reg First register
+ * @param data Values to write
+ * @param len Number of registers
+ * @param autoinc Whether the address advances
+ * @return true always
+ */
+bool LIS3DH_Sim::writeRegisters(uint8_t reg, const uint8_t *data,
+                                uint16_t len, bool autoinc) {
+  update();
+  for (uint16_t i = 0; i < len; i++) {
+    if (reg == LIS3DH_REG_WHOAMI || reg == LIS3DH_REG_FIFOSRC ||
+        (reg >= LIS3DH_REG_OUT_X_L && reg < LIS3DH_REG_OUT_X_L + 6)) {
+      // Read-only
+    } else {
+      _regs[reg] = data[i];
+    }
+    // Bypass mode empties the FIFO
+    if (reg == LIS3DH_REG_FIFOCTRL && (data[i] & 0xC0) == 0) {
+      _level = 0;
+      _head = 0;
+    }
+    if (autoinc)
+      reg = (reg + 1) & (LIS3DH_SIM_REGCOUNT - 1);
+  }
+  // A new rate starts from now, not from the last power-down
+  _next_sample_ns = _now_us * 1000;
+  _pointer = reg;
+  _transactions++;
+  _bytes += len;
+  return true;
+}
+
+/*========================================================================*/
+/*                          PRIVATE FUNCTIONS                             */
+/*========================================================================*/
+
+/*!
+ * @brief Output data rate from CTRL_REG1
+ * @return Hz, 0 in power-down or for rates too slow to matter here
+ */
+uint32_t LIS3DH_Sim::rateHz(void) {
+  switch (_regs[LIS3DH_REG_CTRL1] >> 4) {
+  case 0x5:
+    return 100;
+  case 0x6:
+    return 200;
+  case 0x7:
+    return 400;
+  case 0x8:
+    return lowPower() ? 1600 : 0;
+  case 0x9:
+    return lowPower() ? 5376 : 1344;
+  default:
+    return 0;
+  }
+}
+
+/*!
+ * @brief Whether CTRL_REG1.LPen selects 8-bit low-power mode
+ * @return true in low-power mode
+ */
+bool LIS3DH_Sim::lowPower(void) {
+  return _regs[LIS3DH_REG_CTRL1] & LIS3DH_CTRL1_LPEN;
+}
+
+/*!
+ * @brief Whether samples go through the FIFO
+ * @return true with FIFO_EN set and a mode other than bypass
+ */
+bool LIS3DH_Sim::fifoOn(void) {
+  return (_regs[LIS3DH_REG_CTRL5] & LIS3DH_CTRL5_FIFO_EN) &&
+         (_regs[LIS3DH_REG_FIFOCTRL] & 0xC0);
+}
+
+/*!
+ * @brief Take one sample: next recorded value or rest, into the FIFO
+ */
+void LIS3DH_Sim::produce(void) {
+  LIS3DH_Sample mg = _rest;
+  if (_playing) {
+    mg = _recording[_index++];
+    if (_index >= _count)
+      _playing = false;
+  }
+  _produced++;
+
+  uint8_t shift = lowPower() ? 8 : 6;
+  uint8_t scale = (_regs[LIS3DH_REG_CTRL4] >> 4) & 0x03;
+  int16_t step = sim_sensitivity[lowPower()][scale];
+  int16_t raw[3] = {(int16_t)((quantize(mg.x) / step) * (1 << shift)),
+                    (int16_t)((quantize(mg.y) / step) * (1 << shift)),
+                    (int16_t)((quantize(mg.z) / step) * (1 << shift))};
+
+  if (!fifoOn()) {
+    memcpy(_out, raw, sizeof(_out));
+    return;
+  }
+  if (_level == LIS3DH_FIFO_DEPTH) {
+    // Stream mode: the oldest sample is overwritten
+    _head = (_head + 1) % LIS3DH_FIFO_DEPTH;
+    _level--;
+    _dropped++;
+  }
+  memcpy(_fifo[(_head + _level) % LIS3DH_FIFO_DEPTH], raw, sizeof(raw));
+  _level++;
+  if (_level > _maxLevel)
+    _maxLevel = _level;
+}
+
+/*!
+ * @brief One register read with the side effects of the real part
+ * @param reg Register address
+ * @return Register value
+ */
+uint8_t LIS3DH_Sim::readRegister(uint8_t reg) {
+  if (reg == LIS3DH_REG_FIFOSRC) {
+    if (_level == 0)
+      return LIS3DH_FIFOSRC_EMPTY;
+    if (_level == LIS3DH_FIFO_DEPTH)
+      return LIS3DH_FIFOSRC_OVRN | (LIS3DH_FIFO_DEPTH - 1);
+    return _level;
+  }
+  if (reg < LIS3DH_REG_OUT_X_L || reg >= LIS3DH_REG_OUT_X_L + 6)
+    return _regs[reg];
+
+  uint8_t offset = reg - LIS3DH_REG_OUT_X_L;
+  if (fifoOn() && _level > 0) {
+    int16_t value = _fifo[_head][offset / 2];
+    // Reading OUT_Z_H finishes the sample
+    if (offset == 5) {
+      memcpy(_out, _fifo[_head], sizeof(_out));
+      _head = (_head + 1) % LIS3DH_FIFO_DEPTH;
+      _level--;
+    }
+    return offset & 1 ? (uint16_t)value >> 8 : value & 0xFF;
+  }
+  // Empty FIFO or no FIFO: the last sample stays in the output registers
+  int16_t value = _out[offset / 2];
+  return offset & 1 ? (uint16_t)value >> 8 : value & 0xFF;
+}
+
+/*========================================================================*/
+/*                          GENERICDEVICE GLUE                            */
+/*========================================================================*/
+
+/*!
+ * @brief Raw read callback, continues from the last register pointer
+ * @param obj The LIS3DH_Sim instance
+ * @param buffer Buffer to read into
+ * @param len Number of bytes
+ * @return true on success
+ */
+bool LIS3DH_Sim::readCallback(void *obj, uint8_t *buffer, size_t len) {
+  LIS3DH_Sim *sim = (LIS3DH_Sim *)obj;
+  return sim->readRegisters(sim->_pointer, buffer, len, true);
+}
+
+/*!
+ * @brief Raw write callback, first byte is the sub-address
+ * @param obj The LIS3DH_Sim instance
+ * @param buffer Sub-address followed by data
+ * @param len Number of bytes
+ * @return true on success
+ */
+bool LIS3DH_Sim::writeCallback(void *obj, const uint8_t *buffer, size_t len) {
+  LIS3DH_Sim *sim = (LIS3DH_Sim *)obj;
+  if (len == 0)
+    return true;
+  sim->_pointer = buffer[0] & 0x7F;
+  if (len == 1)
+    return true; // address only, a read follows
+  return sim->writeRegisters(buffer[0] & 0x7F, buffer + 1, len - 1,
+                             buffer[0] & 0x80);
+}
+
+/*!
+ * @brief Register read callback, bit 7 of the sub-address auto-increments
+ * @param obj The LIS3DH_Sim instance
+ * @param addr_buf Sub-address
+ * @param addrsiz Sub-address length, 1
+ * @param data Buffer to read into
+ * @param datalen Number of bytes
+ * @return true on success
+ */
+bool LIS3DH_Sim::readRegCallback(void *obj, uint8_t *addr_buf, uint8_t addrsiz,
+                                 uint8_t *data, uint16_t datalen) {
+  (void)addrsiz;
+  return ((LIS3DH_Sim *)obj)
+      ->readRegisters(addr_buf[0] & 0x7F, data, datalen, addr_buf[0] & 0x80);
+}
+
+/*!
+ * @brief Register write callback, bit 7 of the sub-address auto-increments
+ * @param obj The LIS3DH_Sim instance
+ * @param addr_buf Sub-address
+ * @param addrsiz Sub-address length, 1
+ * @param data Values to write
+ * @param datalen Number of bytes
+ * @return true on success
+ */
+bool LIS3DH_Sim::writeRegCallback(void *obj, uint8_t *addr_buf,
+                                  uint8_t addrsiz, const uint8_t *data,
+                                  uint16_t datalen) {
+  (void)addrsiz;
+  return ((LIS3DH_Sim *)obj)
+      ->writeRegisters(addr_buf[0] & 0x7F, data, datalen, addr_buf[0] & 0x80);
+}
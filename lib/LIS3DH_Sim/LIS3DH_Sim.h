@@ -0,0 +1,109 @@
+/*!
+ * @file LIS3DH_Sim.h
+ *
+ * Register-level model of the LIS3DH accelerometer FIFO for off-hardware
+ * testing of LIS3DH_Fifo and everything downstream of it.
+ *
+ * Samples come from a recording in mg, replayed at the configured output
+ * data rate from micros() (the virtual clock on the host stand-in), and are
+ * quantised and clipped the way the real part does for the selected mode and
+ * full scale. The 32-level FIFO follows bypass and stream mode, FIFO_SRC
+ * reports level and full, and burst reads of the output registers pop one
+ * sample per six bytes, wrapping from OUT_Z_H back to OUT_X_L. The model
+ * counts samples the FIFO overwrote, which the real part cannot tell the
+ * host exactly.
+ */
+
+#ifndef LIS3DH_SIM_H
+#define LIS3DH_SIM_H
+
+#include <Adafruit_GenericDevice.h>
+#include <Arduino.h>
+#include <LIS3DH_Fifo.h>
+
+#define LIS3DH_SIM_REGCOUNT 0x40 ///< Registers 0x00-0x3F
+
+/*!
+ * @brief Register-level simulated LIS3DH
+ */
+class LIS3DH_Sim {
+public:
+  LIS3DH_Sim(void);
+
+  Adafruit_GenericDevice *device(void);
+
+  void setRecording(const LIS3DH_Sample *samples, size_t count);
+  /*!   @brief  Output before play() and after the recording ends
+   *    @param sample Acceleration in mg, gravity only by default */
+  void setRest(const LIS3DH_Sample &sample) { _rest = sample; }
+  void play(void);
+  /*!   @brief  Whether the recording is being replayed
+   *    @return true from play() to the last recorded sample */
+  bool playing(void) { return _playing; }
+
+  int16_t quantize(int16_t mg);
+  void update(void);
+
+  bool readRegisters(uint8_t reg, uint8_t *data, uint16_t len, bool autoinc);
+  bool writeRegisters(uint8_t reg, const uint8_t *data, uint16_t len,
+                      bool autoinc);
+
+  /*!   @brief  Samples produced at the output data rate
+   *    @return Count since construction */
+  uint32_t produced(void) { return _produced; }
+  /*!   @brief  Samples overwritten in the FIFO before the host read them
+   *    @return Count since construction */
+  uint32_t dropped(void) { return _dropped; }
+  /*!   @brief  Deepest the FIFO got
+   *    @return 0-32 */
+  uint8_t maxLevel(void) { return _maxLevel; }
+  /*!   @brief  Restart maxLevel() from the current FIFO level */
+  void resetMaxLevel(void) { _maxLevel = _level; }
+  /*!   @brief  Register transactions served so far
+   *    @return Transaction count */
+  uint32_t transactions(void) { return _transactions; }
+  /*!   @brief  Data bytes moved so far, excluding address bytes
+   *    @return Byte count */
+  uint32_t bytes(void) { return _bytes; }
+
+  static bool readCallback(void *obj, uint8_t *buffer, size_t len);
+  static bool writeCallback(void *obj, const uint8_t *buffer, size_t len);
+  static bool readRegCallback(void *obj, uint8_t *addr_buf, uint8_t addrsiz,
+                              uint8_t *data, uint16_t datalen);
+  static bool writeRegCallback(void *obj, uint8_t *addr_buf, uint8_t addrsiz,
+                               const uint8_t *data, uint16_t datalen);
+
+private:
+  uint32_t rateHz(void);
+  bool lowPower(void);
+  bool fifoOn(void);
+  void produce(void);
+  uint8_t readRegister(uint8_t reg);
+
+  Adafruit_GenericDevice _device;
+  uint8_t _regs[LIS3DH_SIM_REGCOUNT];
+  uint8_t _pointer = 0; ///< Register pointer for raw read/write
+
+  const LIS3DH_Sample *_recording = NULL;
+  size_t _count = 0;
+  size_t _index = 0;
+  bool _playing = false;
+  LIS3DH_Sample _rest = {0, 0, 1000};
+
+  int16_t _fifo[LIS3DH_FIFO_DEPTH][3]; ///< Left-justified raw samples
+  uint8_t _head = 0;
+  uint8_t _level = 0;
+  int16_t _out[3] = {0, 0, 0}; ///< Output registers outside FIFO mode
+
+  uint64_t _now_us = 0;
+  uint32_t _last_micros = 0;
+  uint64_t _next_sample_ns = 0;
+
+  uint32_t _produced = 0;
+  uint32_t _dropped = 0;
+  uint8_t _maxLevel = 0;
+  uint32_t _transactions = 0;
+  uint32_t _bytes = 0;
+};
+
+#endif // LIS3DH_SIM_H
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+
+// Перевод сырых значений регистров DRV2605L в физические единицы
+// (целочисленно, по формулам из datasheet)
+
+// VBAT (0x21): Vdd = raw * 5.6 В / 255
+inline uint16_t vbatMillivolts(uint8_t raw) {
+  return (uint32_t)raw * 5600 / 255;
+}
+
+// LRA_PERIOD (0x22): период = raw * 98.46 мкс, результат в десятых мкс
+inline uint32_t lraPeriodUs10(uint8_t raw) {
+  return (uint32_t)raw * 9846 / 10;
+}
+
+// Резонансная частота LRA в десятых Гц, 0 - период ещё не измерен.
+// raw = 1 даёт 10156.4 Гц - в uint16_t не помещается
+inline uint32_t lraHz10(uint8_t raw) {
+  if (raw == 0) return 0;
+  return 1000000000UL / ((uint32_t)raw * 9846);
+}
+
+// OL_LRA_PERIOD (0x20): тот же шаг 98.46 мкс, 7 бит.
+// Ближайший код для частоты в Гц (округление, а не отбрасывание)
+inline uint8_t olLraPeriodFromHz(uint16_t hz) {
+  if (hz == 0) return 0x7F;
+  uint32_t code = (200000000UL / ((uint32_t)hz * 9846) + 1) / 2;
+  if (code < 1) code = 1;
+  if (code > 0x7F) code = 0x7F;
+  return code;
+}
@@ -0,0 +1,144 @@
+#include "FixedFft.h"
+
+#include <math.h>
+
+int16_t FixedFft::_quarterSine[FixedFft::MAX_SIZE / 4 + 1];
+bool FixedFft::_tableReady = false;
+
+namespace {
+
+// Граница модуля компоненты: a + w*b не выходит за int16 после сдвига
+const int32_t STAGE_LIMIT[] = {13573, 27146};  // 32767 / (1 + sqrt(2)), вдвое больше
+
+int32_t maxComponent(const int16_t *re, const int16_t *im, uint16_t size) {
+  int32_t result = 0;
+  for (uint16_t i = 0; i < size; i++) {
+    int32_t r = re[i] < 0 ? -re[i] : re[i];
+    int32_t m = im[i] < 0 ? -im[i] : im[i];
+    if (r > result) result = r;
+    if (m > result) result = m;
+  }
+  return result;
+}
+
+}  // namespace
+
+uint32_t FixedFft::squareRoot(uint64_t value) {
+  uint64_t root = 0;
+  uint64_t bit = 1ULL << 62;
+  while (bit > value) bit >>= 2;
+  while (bit) {
+    if (value >= root + bit) {
+      value -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return root;
+}
+
+void FixedFft::initTable() {
+  // Один раз: софтверная плавающая точка здесь не страшна
+  for (uint16_t i = 0; i <= MAX_SIZE / 4; i++) {
+    _quarterSine[i] = lround(32767.0 * sin(2 * M_PI * i / MAX_SIZE));
+  }
+  _tableReady = true;
+}
+
+int16_t FixedFft::sine(uint16_t index) {
+  if (!_tableReady) initTable();
+  index &= MAX_SIZE - 1;
+  if (index >= MAX_SIZE / 2) return -sine(index - MAX_SIZE / 2);
+  return index <= MAX_SIZE / 4 ? _quarterSine[index] : _quarterSine[MAX_SIZE / 2 - index];
+}
+
+uint8_t FixedFft::transform(int16_t *re, int16_t *im, uint8_t log2Size) {
+  if (!_tableReady) initTable();
+  uint16_t size = 1 << log2Size;
+
+  // Бит-реверсная перестановка
+  for (uint16_t i = 1, j = 0; i < size; i++) {
+    uint16_t bit = size >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j |= bit;
+    if (i < j) {
+      int16_t t = re[i];
+      re[i] = re[j];
+      re[j] = t;
+      t = im[i];
+      im[i] = im[j];
+      im[j] = t;
+    }
+  }
+
+  uint8_t exponent = 0;
+  int32_t peak = maxComponent(re, im, size);
+  for (uint8_t stage = 1; stage <= log2Size; stage++) {
+    uint8_t shift = peak <= STAGE_LIMIT[0] ? 0 : peak <= STAGE_LIMIT[1] ? 1 : 2;
+    exponent += shift;
+    peak = 0;
+
+    uint16_t half = 1 << (stage - 1);
+    uint16_t stride = MAX_SIZE >> stage;  // шаг по таблице на этом этапе
+    for (uint16_t k = 0; k < half; k++) {
+      // w = exp(-i*2*pi*k/2^stage) = wr - i*ws
+      int32_t wr = cosine(k * stride);
+      int32_t ws = sine(k * stride);
+      for (uint16_t i = k; i < size; i += half << 1) {
+        uint16_t j = i + half;
+        int32_t tr = ((int32_t)re[j] * wr + (int32_t)im[j] * ws + (1 << 14)) >> 15;
+        int32_t ti = ((int32_t)im[j] * wr - (int32_t)re[j] * ws + (1 << 14)) >> 15;
+        int32_t ar = re[i];
+        int32_t ai = im[i];
+
+        int32_t r0 = (ar + tr) >> shift, i0 = (ai + ti) >> shift;
+        int32_t r1 = (ar - tr) >> shift, i1 = (ai - ti) >> shift;
+        re[i] = r0;
+        im[i] = i0;
+        re[j] = r1;
+        im[j] = i1;
+
+        // Максимум выходов - решение о сдвиге следующего этапа
+        if (r0 < 0) r0 = -r0;
+        if (i0 < 0) i0 = -i0;
+        if (r1 < 0) r1 = -r1;
+        if (i1 < 0) i1 = -i1;
+        if (r0 > peak) peak = r0;
+        if (i0 > peak) peak = i0;
+        if (r1 > peak) peak = r1;
+        if (i1 > peak) peak = i1;
+      }
+    }
+  }
+  return exponent;
+}
+
+void FixedFft::applyHann(int16_t *data, uint8_t log2Size) {
+  uint16_t size = 1 << log2Size;
+  uint8_t step = MAX_LOG2 - log2Size;
+  for (uint16_t i = 0; i < size; i++) {
+    // (1 - cos) / 2, периодическое окно - как у ДПФ
+    int32_t w = (32767 - cosine(i << step)) >> 1;
+    data[i] = ((int32_t)data[i] * w + (1 << 14)) >> 15;
+  }
+}
+
+int32_t FixedFft::interpolatePeak(const int16_t *re, const int16_t *im, uint16_t peak,
+                                  uint16_t size) {
+  if (peak == 0 || peak >= size / 2) return 0;
+
+  // Модули с 8 дробными разрядами
+  uint32_t center = squareRoot((uint64_t)power(re, im, peak) << 16);
+  uint32_t left = squareRoot((uint64_t)power(re, im, peak - 1) << 16);
+  uint32_t right = squareRoot((uint64_t)power(re, im, peak + 1) << 16);
+  bool up = right >= left;
+  uint32_t side = up ? right : left;
+  if (side + center == 0) return 0;
+
+  int64_t delta = (((int64_t)side * 2 - center) << 16) / (int64_t)(side + center);
+  if (delta < 0) delta = 0;
+  if (delta > 1 << 15) delta = 1 << 15;
+  return up ? delta : -delta;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+
+// БПФ по основанию 2 в фиксированной точке для ESP32-C3 (FPU нет).
+//
+// Данные - отдельные массивы re/im int16_t, преобразование на месте,
+// прореживание по времени после бит-реверсной перестановки. Поворотные
+// множители Q15 берутся из таблицы четверти синуса на MAX_SIZE точек,
+// таблица заполняется один раз при первом вызове. Куча не используется.
+//
+// Переполнения исключает блочная плавающая точка: перед каждым этапом
+// по максимуму модуля компонент решается, делить ли входы этапа на 2
+// или 4. Результат = спектр * 2^exponent (без деления на N), так что
+// слабый сигнал не теряет разряды, а сильный не переполняется.
+//
+// Для оценки пика: окно Ханна, мощность бина и интерполяция положения
+// пика между бинами по соседнему бину. Для чистого тона под окном Ханна
+// формула точная: delta = (2a - b) / (a + b), где b - модуль пика,
+// a - больший из соседей.
+
+class FixedFft {
+ public:
+  static const uint8_t MAX_LOG2 = 10;
+  static const uint16_t MAX_SIZE = 1 << MAX_LOG2;
+
+  // Прямое БПФ 2^log2Size точек; возвращает показатель степени результата
+  static uint8_t transform(int16_t *re, int16_t *im, uint8_t log2Size);
+  // Умножение на окно Ханна длиной 2^log2Size
+  static void applyHann(int16_t *data, uint8_t log2Size);
+  // re^2 + im^2 бина, до 2^31
+  static uint32_t power(const int16_t *re, const int16_t *im, uint16_t bin) {
+    return (uint32_t)((int32_t)re[bin] * re[bin]) + (uint32_t)((int32_t)im[bin] * im[bin]);
+  }
+  // Смещение пика от бина peak в долях бина, Q16 (-0.5..+0.5)
+  static int32_t interpolatePeak(const int16_t *re, const int16_t *im, uint16_t peak,
+                                 uint16_t size);
+  // sin/cos угла 2*pi*index/MAX_SIZE, Q15
+  static int16_t sine(uint16_t index);
+  static int16_t cosine(uint16_t index) { return sine(index + MAX_SIZE / 4); }
+  // Целый квадратный корень
+  static uint32_t squareRoot(uint64_t value);
+
+ private:
+  static void initTable();
+
+  static int16_t _quarterSine[MAX_SIZE / 4 + 1];
+  static bool _tableReady;
+};
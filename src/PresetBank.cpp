@@ -0,0 +1,55 @@
+#include "PresetBank.h"
+
+// Упакованные регистры интерполируются по битовым полям: у FEEDBACK и
+// CONTROL2 соседние поля независимы, и перенос между ними дал бы мусор.
+// Однобитовые поля при этом переключаются на середине пути.
+static const uint8_t wholeRegister[] = {0xFF};
+static const uint8_t feedbackFields[] = {0x80, 0x70, 0x0C, 0x03};           // N_ERM_LRA, FB_BRAKE_FACTOR, LOOP_GAIN, BEMF_GAIN
+static const uint8_t control2Fields[] = {0x80, 0x40, 0x30, 0x0C, 0x03};     // BIDIR_INPUT, BRAKE_STABILIZER, SAMPLE/BLANKING/IDISS_TIME
+
+static uint8_t morphRegister(uint8_t from, uint8_t to, const uint8_t *fields, uint8_t count, uint8_t step,
+                             uint8_t steps) {
+  uint8_t result = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    uint8_t mask = fields[i];
+    uint8_t shift = 0;
+    while (!((mask >> shift) & 1)) shift++;
+
+    int32_t a = (from & mask) >> shift;
+    int32_t b = (to & mask) >> shift;
+    // Округление к ближайшему, симметрично для обоих направлений
+    int32_t delta = (b - a) * step * 2 / steps;
+    int32_t value = a + (delta + (delta >= 0 ? 1 : -1)) / 2;
+    result |= (value << shift) & mask;
+  }
+  return result;
+}
+
+void applyPreset(const Preset &preset, TapticSettings &settings) {
+  settings.feedbackReg = preset.feedbackReg;
+  settings.controlReg = preset.controlReg;
+  settings.driveReg = preset.driveReg;
+  settings.effect = preset.effect;
+  settings.overdriveReg = preset.overdriveReg;
+  settings.compensationReg = preset.compensationReg;
+}
+
+void capturePreset(const TapticSettings &settings, Preset &preset) {
+  preset.feedbackReg = settings.feedbackReg;
+  preset.controlReg = settings.controlReg;
+  preset.driveReg = settings.driveReg;
+  preset.effect = settings.effect;
+  preset.overdriveReg = settings.overdriveReg;
+  preset.compensationReg = settings.compensationReg;
+}
+
+void morphPresets(const Preset &from, const Preset &to, uint8_t step, uint8_t steps, TapticSettings &settings) {
+  settings.feedbackReg = morphRegister(from.feedbackReg, to.feedbackReg, feedbackFields, sizeof(feedbackFields), step, steps);
+  settings.controlReg = morphRegister(from.controlReg, to.controlReg, control2Fields, sizeof(control2Fields), step, steps);
+  settings.driveReg = morphRegister(from.driveReg, to.driveReg, wholeRegister, 1, step, steps);
+  settings.overdriveReg = morphRegister(from.overdriveReg, to.overdriveReg, wholeRegister, 1, step, steps);
+  settings.compensationReg = morphRegister(from.compensationReg, to.compensationReg, wholeRegister, 1, step, steps);
+
+  // Номер эффекта - не величина, а ссылка на форму в ROM: меняем на середине
+  settings.effect = step * 2 < steps ? from.effect : to.effect;
+}
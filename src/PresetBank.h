@@ -0,0 +1,62 @@
+#pragma once
+
+#include "TapticSettings.h"
+
+// Банк пресетов. Частоту пресеты не трогают - она зависит от мотора.
+struct Preset {
+  const char *name;
+  uint8_t feedbackReg;
+  uint8_t controlReg;
+  uint8_t driveReg;
+  uint8_t effect;
+  uint8_t overdriveReg;
+  uint8_t compensationReg;
+};
+
+// Заводские пресеты: 4 уровня силы x 8 эффектов
+constexpr Preset factoryPresets[] = {
+    {"Мягкий: клик", 0x86, 0x10, 0x04, 1, 0x80, 0x15},
+    {"Мягкий: резкий клик", 0x86, 0x10, 0x04, 4, 0x80, 0x15},
+    {"Мягкий: мягкий толчок", 0x86, 0x10, 0x04, 7, 0x80, 0x15},
+    {"Мягкий: двойной клик", 0x86, 0x10, 0x04, 10, 0x80, 0x15},
+    {"Мягкий: тройной клик", 0x86, 0x10, 0x04, 12, 0x80, 0x15},
+    {"Мягкий: жужжание", 0x86, 0x10, 0x04, 14, 0x80, 0x15},
+    {"Мягкий: тик", 0x86, 0x10, 0x04, 24, 0x80, 0x15},
+    {"Мягкий: длинный двойной клик", 0x86, 0x10, 0x04, 37, 0x80, 0x15},
+    {"Средний: клик", 0x93, 0x20, 0x06, 1, 0x83, 0x1A},
+    {"Средний: резкий клик", 0x93, 0x20, 0x06, 4, 0x83, 0x1A},
+    {"Средний: мягкий толчок", 0x93, 0x20, 0x06, 7, 0x83, 0x1A},
+    {"Средний: двойной клик", 0x93, 0x20, 0x06, 10, 0x83, 0x1A},
+    {"Средний: тройной клик", 0x93, 0x20, 0x06, 12, 0x83, 0x1A},
+    {"Средний: жужжание", 0x93, 0x20, 0x06, 14, 0x83, 0x1A},
+    {"Средний: тик", 0x93, 0x20, 0x06, 24, 0x83, 0x1A},
+    {"Средний: длинный двойной клик", 0x93, 0x20, 0x06, 37, 0x83, 0x1A},
+    {"Сильный: клик", 0xA0, 0x30, 0x08, 1, 0x83, 0x1A},
+    {"Сильный: резкий клик", 0xA0, 0x30, 0x08, 4, 0x83, 0x1A},
+    {"Сильный: мягкий толчок", 0xA0, 0x30, 0x08, 7, 0x83, 0x1A},
+    {"Сильный: двойной клик", 0xA0, 0x30, 0x08, 10, 0x83, 0x1A},
+    {"Сильный: тройной клик", 0xA0, 0x30, 0x08, 12, 0x83, 0x1A},
+    {"Сильный: жужжание", 0xA0, 0x30, 0x08, 14, 0x83, 0x1A},
+    {"Сильный: тик", 0xA0, 0x30, 0x08, 24, 0x83, 0x1A},
+    {"Сильный: длинный двойной клик", 0xA0, 0x30, 0x08, 37, 0x83, 0x1A},
+    {"Максимальный: клик", 0xB6, 0x40, 0x0A, 1, 0x86, 0x1F},
+    {"Максимальный: резкий клик", 0xB6, 0x40, 0x0A, 4, 0x86, 0x1F},
+    {"Максимальный: мягкий толчок", 0xB6, 0x40, 0x0A, 7, 0x86, 0x1F},
+    {"Максимальный: двойной клик", 0xB6, 0x40, 0x0A, 10, 0x86, 0x1F},
+    {"Максимальный: тройной клик", 0xB6, 0x40, 0x0A, 12, 0x86, 0x1F},
+    {"Максимальный: жужжание", 0xB6, 0x40, 0x0A, 14, 0x86, 0x1F},
+    {"Максимальный: тик", 0xB6, 0x40, 0x0A, 24, 0x86, 0x1F},
+    {"Максимальный: длинный двойной клик", 0xB6, 0x40, 0x0A, 37, 0x86, 0x1F},
+};
+constexpr uint8_t factoryPresetCount = sizeof(factoryPresets) / sizeof(factoryPresets[0]);
+
+// Бывшие быстрые пресеты 1/2/3
+constexpr uint8_t presetSoft = 4;     // Мягкий: тройной клик
+constexpr uint8_t presetMedium = 13;  // Средний: жужжание
+constexpr uint8_t presetStrong = 23;  // Сильный: длинный двойной клик
+
+void applyPreset(const Preset &preset, TapticSettings &settings);
+void capturePreset(const TapticSettings &settings, Preset &preset);
+
+// Промежуточная точка между пресетами: step из steps (0 - from, steps - to)
+void morphPresets(const Preset &from, const Preset &to, uint8_t step, uint8_t steps, TapticSettings &settings);
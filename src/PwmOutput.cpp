@@ -0,0 +1,36 @@
+#include "PwmOutput.h"
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <Arduino.h>
+#include <esp_arduino_version.h>
+
+// В ядре 3.x LEDC адресуется выводом, в 2.x - каналом
+bool LedcPwmOutput::begin(uint8_t pin, uint32_t frequency, uint8_t resolutionBits) {
+  _pin = pin;
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+  return ledcAttachChannel(pin, frequency, resolutionBits, _channel);
+#else
+  if (ledcSetup(_channel, frequency, resolutionBits) == 0) return false;
+  ledcAttachPin(pin, _channel);
+  return true;
+#endif
+}
+
+void LedcPwmOutput::write(uint32_t duty) {
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+  ledcWrite(_pin, duty);
+#else
+  ledcWrite(_channel, duty);
+#endif
+}
+
+void LedcPwmOutput::end() {
+  if (_pin == 0xFF) return;
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+  ledcDetach(_pin);
+#else
+  ledcDetachPin(_pin);
+#endif
+  _pin = 0xFF;
+}
+#endif
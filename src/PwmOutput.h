@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+// Источник ШИМ для входа IN/TRIG драйвера в режиме PWM/Analog.
+// На стенде - LEDC, на ПК - заглушка из tools/host, чтобы проигрыватель
+// огибающих можно было гонять без железа.
+class PwmOutput {
+ public:
+  virtual ~PwmOutput() {}
+  virtual bool begin(uint8_t pin, uint32_t frequency, uint8_t resolutionBits) = 0;
+  virtual void write(uint32_t duty) = 0;
+  virtual void end() = 0;
+};
+
+#ifdef ARDUINO_ARCH_ESP32
+class LedcPwmOutput : public PwmOutput {
+ public:
+  explicit LedcPwmOutput(uint8_t channel) : _channel(channel) {}
+  bool begin(uint8_t pin, uint32_t frequency, uint8_t resolutionBits) override;
+  void write(uint32_t duty) override;
+  void end() override;
+
+ private:
+  uint8_t _channel;
+  uint8_t _pin = 0xFF;
+};
+#endif
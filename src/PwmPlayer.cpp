@@ -0,0 +1,40 @@
+#include "PwmPlayer.h"
+
+void PwmPlayer::start(const uint16_t *table, uint16_t length, uint16_t zeroDuty) {
+  _playing.store(false, std::memory_order_release);
+  _table = table;
+  _length = length;
+  _position = 0;
+  _zeroDuty = zeroDuty;
+  _ticks = 0;
+  _playing.store(length > 0, std::memory_order_release);
+}
+
+void PwmPlayer::tick() {
+  if (!_playing.load(std::memory_order_acquire)) return;
+
+  _ticks++;
+  if (_position < _length) {
+    _output.write(_table[_position++]);
+    return;
+  }
+  _output.write(_zeroDuty);
+  _playing.store(false, std::memory_order_release);
+}
+
+void PwmPlayer::stop() {
+  if (!_playing.load(std::memory_order_acquire)) return;
+  _playing.store(false, std::memory_order_release);
+  _output.write(_zeroDuty);
+}
+
+uint16_t buildEnvelope(uint16_t *table, uint16_t capacity, uint16_t attack, uint16_t hold, uint16_t decay,
+                       uint16_t zeroDuty, uint16_t peakDuty) {
+  uint16_t n = 0;
+  int32_t span = (int32_t)peakDuty - zeroDuty;
+
+  for (uint16_t i = 1; i <= attack && n < capacity; i++) table[n++] = zeroDuty + span * i / attack;
+  for (uint16_t i = 0; i < hold && n < capacity; i++) table[n++] = peakDuty;
+  for (uint16_t i = decay; i > 0 && n < capacity; i--) table[n++] = zeroDuty + span * (i - 1) / decay;
+  return n;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "PwmOutput.h"
+
+// Проигрыватель таблицы скважностей: по каждому тику таймера выдаёт
+// следующий отсчёт в PwmOutput, в конце возвращает нулевую амплитуду.
+// tick() вызывается из таймера, playing() - из задачи шины.
+class PwmPlayer {
+ public:
+  explicit PwmPlayer(PwmOutput &output) : _output(output) {}
+
+  void start(const uint16_t *table, uint16_t length, uint16_t zeroDuty);
+  void tick();
+  void stop();
+  bool playing() const { return _playing.load(std::memory_order_acquire); }
+  uint32_t ticks() const { return _ticks; }
+
+ private:
+  PwmOutput &_output;
+  const uint16_t *_table = nullptr;
+  uint16_t _length = 0;
+  uint16_t _position = 0;
+  uint16_t _zeroDuty = 0;
+  uint32_t _ticks = 0;
+  std::atomic<bool> _playing{false};
+};
+
+// Огибающая "клика": линейное нарастание, удержание и спад амплитуды от
+// zeroDuty до peakDuty. Возвращает число отсчётов в таблице.
+uint16_t buildEnvelope(uint16_t *table, uint16_t capacity, uint16_t attack, uint16_t hold, uint16_t decay,
+                       uint16_t zeroDuty, uint16_t peakDuty);
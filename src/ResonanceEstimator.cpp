@@ -0,0 +1,149 @@
+#include "ResonanceEstimator.h"
+
+ResonanceResult ResonanceEstimator::analyze(const int16_t *x, const int16_t *y, const int16_t *z,
+                                            uint16_t count, uint16_t rateHz) {
+  ResonanceResult result = {};
+  if (count < MIN_POINTS || rateHz == 0) return result;
+
+  // Ось с наибольшей дисперсией
+  const int16_t *axes[3] = {x, y, z};
+  uint64_t bestEnergy = 0;
+  for (uint8_t axis = 0; axis < 3; axis++) {
+    int64_t sum = 0;
+    uint64_t squares = 0;
+    for (uint16_t i = 0; i < count; i++) {
+      sum += axes[axis][i];
+      squares += (int32_t)axes[axis][i] * axes[axis][i];
+    }
+    uint64_t energy = squares - (uint64_t)(sum * sum / count);
+    if (energy > bestEnergy) {
+      bestEnergy = energy;
+      result.axis = axis;
+    }
+  }
+  const int16_t *data = axes[result.axis];
+
+  // Окно по активной части: энергия по SMOOTH отсчётам не ниже 1/64
+  // наибольшей (амплитуда - 1/8), так что отдельные выбросы шума её не
+  // растягивают. Щелчок ставим в середину окна - у краёв окно Ханна
+  // почти ноль
+  uint64_t energy = 0, loudest = 0;
+  for (uint16_t i = 0; i < count; i++) {
+    energy += (int32_t)data[i] * data[i];
+    if (i >= SMOOTH) energy -= (int32_t)data[i - SMOOTH] * data[i - SMOOTH];
+    if (energy > loudest) loudest = energy;
+  }
+  if (loudest == 0) return result;
+  uint16_t first = count, last = 0;
+  energy = 0;
+  for (uint16_t i = 0; i < count; i++) {
+    energy += (int32_t)data[i] * data[i];
+    if (i >= SMOOTH) energy -= (int32_t)data[i - SMOOTH] * data[i - SMOOTH];
+    if (energy < loudest / 64) continue;
+    if (first == count) first = i < SMOOTH ? 0 : i - SMOOTH + 1;
+    last = i;
+  }
+
+  uint8_t log2Size = 6;
+  while (log2Size < FixedFft::MAX_LOG2 && (1u << log2Size) < (uint32_t)(last - first + 1)) {
+    log2Size++;
+  }
+  uint16_t size = 1 << log2Size;
+  result.points = size;
+
+  int32_t start = ((int32_t)first + last + 1 - size) / 2;
+  if (last - first + 1 > size) {
+    // Длиннее окна - берём участок с наибольшей энергией
+    uint64_t window = 0;
+    for (uint16_t i = first; i < first + size; i++) window += (int32_t)data[i] * data[i];
+    uint64_t bestWindow = window;
+    start = first;
+    for (uint16_t i = first + size; i <= last; i++) {
+      window += (int32_t)data[i] * data[i];
+      window -= (int32_t)data[i - size] * data[i - size];
+      if (window > bestWindow) {
+        bestWindow = window;
+        start = i - size + 1;
+      }
+    }
+  }
+
+  // Без среднего и на всю разрядность: БПФ не теряет младшие разряды.
+  // Что за пределами записи - покой, нули
+  int32_t sum = 0, inside = 0;
+  for (int32_t i = start; i < start + size; i++) {
+    if (i < 0 || i >= count) continue;
+    sum += data[i];
+    inside++;
+  }
+  int32_t mean = sum / inside;
+  int32_t largest = 0;
+  for (int32_t i = start; i < start + size; i++) {
+    if (i < 0 || i >= count) continue;
+    int32_t v = data[i] - mean;
+    if (v < 0) v = -v;
+    if (v > largest) largest = v;
+  }
+  if (largest == 0) return result;
+  int8_t inShift = 0;
+  if (largest >= 16384) {
+    while ((largest >> -inShift) >= 16384) inShift--;
+  } else {
+    while ((largest << inShift) < 8192) inShift++;
+  }
+  for (uint16_t i = 0; i < size; i++) {
+    int32_t k = start + i;
+    int32_t v = k < 0 || k >= count ? 0 : data[k] - mean;
+    _re[i] = inShift >= 0 ? v << inShift : v >> -inShift;
+    _im[i] = 0;
+  }
+
+  FixedFft::applyHann(_re, log2Size);
+  FixedFft::transform(_re, _im, log2Size);
+
+  // Пик в полосе
+  uint16_t low = ((uint32_t)_minHz * size + rateHz - 1) / rateHz;
+  uint16_t high = (uint32_t)_maxHz * size / rateHz;
+  if (low < 1) low = 1;
+  if (high > size / 2 - 1) high = size / 2 - 1;
+  if (low > high) return result;
+  uint16_t peak = low;
+  uint32_t peakPower = 0;
+  for (uint16_t k = low; k <= high; k++) {
+    uint32_t p = FixedFft::power(_re, _im, k);
+    if (p > peakPower) {
+      peakPower = p;
+      peak = k;
+    }
+  }
+  if (peakPower == 0) return result;
+
+  // Положение пика в бинах, Q16
+  int32_t position = ((int32_t)peak << 16) + FixedFft::interpolatePeak(_re, _im, peak, size);
+  result.centiHz = ((uint64_t)position * rateHz * 100 + ((uint64_t)size << 15)) /
+                   ((uint64_t)size << 16);
+
+  uint64_t fundamental = lobePower((position + 0x8000) >> 16, size);
+  if (fundamental == 0) return result;
+
+  uint64_t harmonics = 0;
+  for (uint8_t h = 0; h < ResonanceResult::HARMONICS; h++) {
+    int64_t center = ((int64_t)position * (h + 2) + 0x8000) >> 16;
+    if (center + 2 >= size / 2) break;  // выше Найквиста
+    uint64_t p = lobePower(center, size);
+    harmonics += p;
+    result.harmonicPermille[h] = FixedFft::squareRoot(p * 1000000 / fundamental);
+  }
+  result.thdPermille = FixedFft::squareRoot(harmonics * 1000000 / fundamental);
+  result.valid = true;
+  return result;
+}
+
+uint64_t ResonanceEstimator::lobePower(int32_t center, uint16_t size) const {
+  uint64_t sum = 0;
+  for (int32_t k = center - 2; k <= center + 2; k++) {
+    if (k < 1 || k > size / 2) continue;
+    sum += FixedFft::power(_re, _im, k);
+  }
+  return sum;
+}
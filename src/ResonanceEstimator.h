@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "FixedFft.h"
+
+// Резонанс мотора и гармоники по записи вибрации (VibrationCapture).
+//
+// Мотор колеблется вдоль одной оси, поэтому берётся ось с наибольшей
+// энергией. Окно в 2^n отсчётов (от MIN_POINTS до FixedFft::MAX_SIZE)
+// накрывает активную часть записи - где энергия по SMOOTH отсчётам не
+// ниже 1/64 наибольшей, - и ставит её в середину; если она длиннее, берётся
+// участок с наибольшей энергией. Из окна вычитается среднее, отсчёты
+// сдвигаются на всю разрядность int16 и умножаются на окно Ханна. После
+// БПФ ищется самый мощный бин в полосе [minHz, maxHz], его положение
+// уточняется интерполяцией - это и есть резонанс.
+//
+// Гармоники 2..HARMONICS+1 меряются суммой мощности по главному лепестку
+// (+-2 бина) вокруг k*f: такая сумма не зависит от того, куда частота
+// попала между бинами. Уровни - отношение амплитуд к основной, в
+// промилле; THD - корень из суммы их квадратов. Гармоники выше частоты
+// Найквиста не считаются (0).
+//
+// Всё в целых числах, буферы - внутри объекта, куча не используется.
+
+struct ResonanceResult {
+  static const uint8_t HARMONICS = 4;
+
+  bool valid;
+  uint8_t axis;         // 0 - X, 1 - Y, 2 - Z
+  uint16_t points;      // размер БПФ
+  uint32_t centiHz;     // резонанс, 0.01 Гц
+  uint16_t thdPermille;
+  uint16_t harmonicPermille[HARMONICS];  // 2-я, 3-я, ...
+};
+
+class ResonanceEstimator {
+ public:
+  static const uint16_t MIN_POINTS = 64;
+  static const uint8_t SMOOTH = 16;
+
+  void setBand(uint16_t minHz, uint16_t maxHz) {
+    _minHz = minHz;
+    _maxHz = maxHz;
+  }
+  ResonanceResult analyze(const int16_t *x, const int16_t *y, const int16_t *z, uint16_t count,
+                          uint16_t rateHz);
+
+ private:
+  uint64_t lobePower(int32_t center, uint16_t size) const;
+
+  int16_t _re[FixedFft::MAX_SIZE];
+  int16_t _im[FixedFft::MAX_SIZE];
+  uint16_t _minHz = 100;
+  uint16_t _maxHz = 400;
+};
@@ -0,0 +1,241 @@
+#include "ScriptVm.h"
+
+#include "Adafruit_DRV2605.h"
+
+// Длина аргументов; у BURST - без самих значений
+static int8_t argBytes(uint8_t op) {
+  switch (op) {
+    case SCRIPT_END:
+    case SCRIPT_GO:
+    case SCRIPT_END_LOOP:
+    case SCRIPT_TELEMETRY:
+    case SCRIPT_MARK:
+      return 0;
+    case SCRIPT_READ:
+    case SCRIPT_EMIT:
+      return 1;
+    case SCRIPT_WRITE:
+    case SCRIPT_BURST:
+    case SCRIPT_WAIT_GO:
+    case SCRIPT_WAIT_US:
+    case SCRIPT_WAIT_MS:
+    case SCRIPT_LOOP:
+      return 2;
+    default:
+      return -1;
+  }
+}
+
+const char *ScriptVm::errorName(ScriptError error) {
+  switch (error) {
+    case SCRIPT_OK: return "ok";
+    case SCRIPT_BAD_OPCODE: return "неизвестная команда";
+    case SCRIPT_TRUNCATED: return "сценарий оборван";
+    case SCRIPT_BAD_LOOP: return "несогласованные LOOP/END_LOOP";
+    case SCRIPT_TOO_LONG: return "сценарий длиннее буфера";
+    default: return "таймаут WAIT_GO";
+  }
+}
+
+bool ScriptVm::load(const uint8_t *code, size_t size) {
+  _running = false;
+  if (!validate(code, size)) return false;
+
+  memcpy(_code, code, size);
+  _size = size;
+  return true;
+}
+
+bool ScriptVm::validate(const uint8_t *code, size_t size) {
+  // Всё проверяем до запуска, чтобы при выполнении не тратить на это время
+  _error = SCRIPT_OK;
+  _errorPos = 0;
+  if (size > CAPACITY) {
+    _error = SCRIPT_TOO_LONG;
+    return false;
+  }
+
+  uint8_t depth = 0;
+  size_t pos = 0;
+  while (pos < size) {
+    uint8_t op = code[pos];
+    int8_t args = argBytes(op);
+    _errorPos = pos;
+    if (args < 0) {
+      _error = SCRIPT_BAD_OPCODE;
+      return false;
+    }
+    size_t length = 1 + args;
+    if (op == SCRIPT_BURST && pos + 2 < size) length += code[pos + 2];
+    if (pos + length > size) {
+      _error = SCRIPT_TRUNCATED;
+      return false;
+    }
+
+    if (op == SCRIPT_LOOP && ++depth > MAX_DEPTH) {
+      _error = SCRIPT_BAD_LOOP;
+      return false;
+    }
+    if (op == SCRIPT_END_LOOP && depth-- == 0) {
+      _error = SCRIPT_BAD_LOOP;
+      return false;
+    }
+    pos += length;
+    if (op == SCRIPT_END) break;
+  }
+
+  if (depth != 0) {
+    _error = SCRIPT_BAD_LOOP;
+    return false;
+  }
+  return true;
+}
+
+bool ScriptVm::start() {
+  if (_size == 0) return false;
+
+  _pc = 0;
+  _depth = 0;
+  _acc = 0;
+  _ops = 0;
+  _maxLateUs = 0;
+  _waitingGo = false;
+  _waiting = false;
+  _error = SCRIPT_OK;
+  _startUs = micros();
+  _lastUs = _startUs;
+  _deadlineUs = _startUs;
+  _running = true;
+  return true;
+}
+
+void ScriptVm::fail(ScriptError error) {
+  _error = error;
+  _errorPos = _pc;
+  _running = false;
+  _lastUs = micros();
+}
+
+bool ScriptVm::waitUntil(uint32_t deadlineUs) {
+  int32_t remaining = deadlineUs - micros();
+  if (remaining > (int32_t)SPIN_US) return false;
+  if (remaining > 0) delayMicroseconds(remaining);
+
+  uint32_t late = micros() - deadlineUs;
+  if ((int32_t)late > 0 && late > _maxLateUs) _maxLateUs = late;
+  return true;
+}
+
+void ScriptVm::step(ScriptHost &host) {
+  uint32_t stepStart = micros();
+  while (_running) {
+    if (micros() - stepStart > STEP_BUDGET_US) return;
+    if (_pc >= _size) {
+      _running = false;
+      _lastUs = micros();
+      return;
+    }
+
+    uint8_t op = _code[_pc];
+    switch (op) {
+      case SCRIPT_END:
+        _running = false;
+        _lastUs = micros();
+        _ops++;
+        return;
+
+      case SCRIPT_WRITE:
+        host.scriptWrite(_code[_pc + 1], _code + _pc + 2, 1);
+        _pc += 3;
+        break;
+
+      case SCRIPT_BURST:
+        host.scriptWrite(_code[_pc + 1], _code + _pc + 3, _code[_pc + 2]);
+        _pc += 3 + _code[_pc + 2];
+        break;
+
+      case SCRIPT_READ:
+        _acc = host.scriptRead(_code[_pc + 1]);
+        _pc += 2;
+        break;
+
+      case SCRIPT_GO: {
+        uint8_t go = 1;
+        host.scriptWrite(DRV2605_REG_GO, &go, 1);
+        _pc += 1;
+        break;
+      }
+
+      case SCRIPT_WAIT_GO: {
+        // Опрашиваем GO подряд, с темпом шины; долгий эффект не держит
+        // задачу дольше SPIN_US за один вызов
+        if (!_waitingGo) {
+          _waitingGo = true;
+          _waitStartUs = micros();
+        }
+        uint32_t spinStart = micros();
+        for (;;) {
+          bool playing = host.scriptRead(DRV2605_REG_GO) & 0x01;
+          uint32_t now = micros();
+          if (!playing) {
+            _deadlineUs = now;
+            break;
+          }
+          if (now - _waitStartUs > (uint32_t)arg16(_pc + 1) * 1000) {
+            fail(SCRIPT_GO_TIMEOUT);
+            return;
+          }
+          if (now - spinStart >= SPIN_US) return;
+        }
+        _waitingGo = false;
+        _pc += 3;
+        break;
+      }
+
+      case SCRIPT_WAIT_US:
+      case SCRIPT_WAIT_MS:
+        if (!_waiting) {
+          _waiting = true;
+          _deadlineUs += op == SCRIPT_WAIT_MS ? (uint32_t)arg16(_pc + 1) * 1000 : arg16(_pc + 1);
+        }
+        if (!waitUntil(_deadlineUs)) return;
+        _waiting = false;
+        _pc += 3;
+        break;
+
+      case SCRIPT_LOOP:
+        _loops[_depth].body = _pc + 3;
+        _loops[_depth].remaining = arg16(_pc + 1);
+        _depth++;
+        _pc += 3;
+        break;
+
+      case SCRIPT_END_LOOP: {
+        Loop &loop = _loops[_depth - 1];
+        if (loop.remaining == 0 || --loop.remaining > 0) {
+          _pc = loop.body;
+        } else {
+          _depth--;
+          _pc += 1;
+        }
+        break;
+      }
+
+      case SCRIPT_EMIT:
+        host.scriptEmit(_code[_pc + 1], micros() - _startUs, _acc);
+        _pc += 2;
+        break;
+
+      case SCRIPT_TELEMETRY:
+        host.scriptTelemetry(micros());
+        _pc += 1;
+        break;
+
+      case SCRIPT_MARK:
+        _deadlineUs = micros();
+        _pc += 1;
+        break;
+    }
+    _ops++;
+  }
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Интерпретатор тестовых сценариев: байт-код загружается один раз и
+// выполняется на стенде без участия человека и без задержек Serial.
+//
+// Команда - код операции и аргументы (многобайтовые - little-endian):
+//
+//   00                END          конец сценария
+//   01 reg val        WRITE        запись регистра
+//   02 reg n bytes..  BURST        запись n регистров подряд одним пакетом
+//   03 reg            READ         чтение регистра в аккумулятор
+//   04                GO           GO = 1
+//   05 ms(2)          WAIT_GO      ждать снятия GO, не дольше ms
+//   06 us(2)          WAIT_US      пауза от опорного времени
+//   07 ms(2)          WAIT_MS      то же в мс
+//   08 count(2)       LOOP         повторить тело count раз, 0 - бесконечно
+//   09                END_LOOP     конец тела цикла
+//   0A tag            EMIT         вывести метку, время и аккумулятор
+//   0B                TELEMETRY    отсчёт телеметрии STATUS/VBAT/LRA
+//   0C                MARK         опорное время = сейчас
+//
+// Паузы отсчитываются от опорного времени, а не от конца предыдущей
+// команды, поэтому время выполнения команд не накапливается в дрейф.
+// WAIT_GO и MARK переносят опорное время на текущий момент.
+
+enum ScriptOp : uint8_t {
+  SCRIPT_END = 0x00,
+  SCRIPT_WRITE = 0x01,
+  SCRIPT_BURST = 0x02,
+  SCRIPT_READ = 0x03,
+  SCRIPT_GO = 0x04,
+  SCRIPT_WAIT_GO = 0x05,
+  SCRIPT_WAIT_US = 0x06,
+  SCRIPT_WAIT_MS = 0x07,
+  SCRIPT_LOOP = 0x08,
+  SCRIPT_END_LOOP = 0x09,
+  SCRIPT_EMIT = 0x0A,
+  SCRIPT_TELEMETRY = 0x0B,
+  SCRIPT_MARK = 0x0C
+};
+
+enum ScriptError : uint8_t {
+  SCRIPT_OK,
+  SCRIPT_BAD_OPCODE,   // неизвестный код операции
+  SCRIPT_TRUNCATED,    // аргументы за концом сценария
+  SCRIPT_BAD_LOOP,     // END_LOOP без LOOP, LOOP без END_LOOP или глубже MAX_DEPTH
+  SCRIPT_TOO_LONG,     // больше CAPACITY
+  SCRIPT_GO_TIMEOUT    // WAIT_GO не дождался снятия GO
+};
+
+// Всё, что сценарий делает с внешним миром, идёт через стенд
+class ScriptHost {
+ public:
+  virtual ~ScriptHost() {}
+  virtual void scriptWrite(uint8_t reg, const uint8_t *values, uint8_t len) = 0;
+  virtual uint8_t scriptRead(uint8_t reg) = 0;
+  virtual void scriptEmit(uint8_t tag, uint32_t timeUs, uint8_t value) = 0;
+  virtual void scriptTelemetry(uint32_t timeUs) = 0;
+};
+
+class ScriptVm {
+ public:
+  static const size_t CAPACITY = 1024;
+  static const uint8_t MAX_DEPTH = 4;
+  // Остаток паузы короче этого досиживается на месте, длиннее - задача
+  // шины засыпает до следующего тика (1 мс) и успевает вернуться до срока
+  static const uint32_t SPIN_US = 2000;
+  // Дольше этого step() подряд не выполняется, даже без пауз в сценарии
+  static const uint32_t STEP_BUDGET_US = 20000;
+
+  bool load(const uint8_t *code, size_t size);
+  bool start();
+  void stop() {
+    _running = false;
+    _lastUs = micros();
+  }
+  void step(ScriptHost &host);
+
+  const uint8_t *code() const { return _code; }
+  size_t size() const { return _size; }
+  bool running() const { return _running; }
+  ScriptError error() const { return _error; }
+  size_t errorPos() const { return _errorPos; }
+  uint32_t ops() const { return _ops; }
+  uint32_t elapsedUs() const { return _lastUs - _startUs; }
+  uint32_t maxLateUs() const { return _maxLateUs; }
+
+  static const char *errorName(ScriptError error);
+
+ private:
+  struct Loop {
+    uint16_t body;       // адрес первой команды тела
+    uint16_t remaining;  // 0 - бесконечный цикл
+  };
+
+  bool validate(const uint8_t *code, size_t size);
+  bool waitUntil(uint32_t deadlineUs);
+  void fail(ScriptError error);
+  uint16_t arg16(size_t pos) const { return _code[pos] | (_code[pos + 1] << 8); }
+
+  uint8_t _code[CAPACITY];
+  size_t _size = 0;
+  size_t _pc = 0;
+  Loop _loops[MAX_DEPTH];
+  uint8_t _depth = 0;
+  uint8_t _acc = 0;
+  bool _running = false;
+  bool _waiting = false;
+  bool _waitingGo = false;
+  uint32_t _deadlineUs = 0;  // опорное время для пауз
+  uint32_t _waitStartUs = 0;
+  uint32_t _startUs = 0;
+  uint32_t _lastUs = 0;
+  uint32_t _ops = 0;
+  uint32_t _maxLateUs = 0;
+  ScriptError _error = SCRIPT_OK;
+  size_t _errorPos = 0;
+};
@@ -0,0 +1,167 @@
+#include "SessionLog.h"
+
+static const uint8_t sessionMagic[4] = {'T', 'S', 'L', '1'};
+
+void SessionLog::clear() {
+  _size = 0;
+  _events = 0;
+  _durationUs = 0;
+  _recording = false;
+  _overflow = false;
+}
+
+void SessionLog::start(uint32_t nowUs, const void *snapshot, uint8_t length) {
+  clear();
+  _lastUs = nowUs;
+  _recording = true;
+  append(SESSION_SNAPSHOT, nowUs, (const uint8_t *)snapshot, length);
+}
+
+void SessionLog::addInput(uint32_t nowUs, char c) {
+  uint8_t payload = (uint8_t)c;
+  append(SESSION_INPUT, nowUs, &payload, 1);
+}
+
+void SessionLog::addCommit(uint32_t nowUs, uint8_t reg, uint8_t value) {
+  uint8_t payload[2] = {reg, value};
+  append(SESSION_COMMIT, nowUs, payload, 2);
+}
+
+bool SessionLog::append(SessionEventType type, uint32_t nowUs, const uint8_t *payload, uint8_t length) {
+  if (!_recording) return false;
+
+  uint8_t header[1 + 5 + 1];
+  size_t n = 0;
+  header[n++] = type;
+
+  uint32_t delta = nowUs - _lastUs;
+  do {
+    uint8_t b = delta & 0x7F;
+    delta >>= 7;
+    header[n++] = delta ? (b | 0x80) : b;
+  } while (delta);
+
+  // Снимок несёт свою длину, у остальных событий она определяется тегом
+  if (type == SESSION_SNAPSHOT) header[n++] = length;
+
+  if (_size + n + length > CAPACITY) {
+    // Неполный журнал всё ещё воспроизводим - просто перестаём писать
+    _overflow = true;
+    _recording = false;
+    return false;
+  }
+
+  memcpy(_buf + _size, header, n);
+  memcpy(_buf + _size + n, payload, length);
+  _size += n + length;
+  _durationUs += nowUs - _lastUs;
+  _lastUs = nowUs;
+  _events++;
+  return true;
+}
+
+bool SessionLog::Reader::next(SessionEvent &event) {
+  const uint8_t *buf = _log._buf;
+  size_t size = _log._size;
+  size_t pos = _pos;
+
+  if (pos >= size) return false;
+  uint8_t type = buf[pos++];
+
+  uint32_t delta = 0;
+  for (uint8_t shift = 0;; shift += 7) {
+    if (pos >= size || shift > 28) return false;
+    uint8_t b = buf[pos++];
+    delta |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) break;
+  }
+
+  event.type = (SessionEventType)type;
+  event.timeUs = _timeUs + delta;
+  event.data = nullptr;
+  event.length = 0;
+
+  switch (type) {
+    case SESSION_SNAPSHOT:
+      if (pos >= size) return false;
+      event.length = buf[pos++];
+      if (pos + event.length > size) return false;
+      event.data = buf + pos;
+      pos += event.length;
+      break;
+    case SESSION_INPUT:
+      if (pos + 1 > size) return false;
+      event.reg = buf[pos++];
+      break;
+    case SESSION_COMMIT:
+      if (pos + 2 > size) return false;
+      event.reg = buf[pos++];
+      event.value = buf[pos++];
+      break;
+    default:
+      return false;
+  }
+
+  _pos = pos;
+  _timeUs = event.timeUs;
+  return true;
+}
+
+bool SessionLog::rescan() {
+  // Проверяем, что журнал разбирается целиком, и восстанавливаем счётчики
+  Reader reader(*this);
+  SessionEvent event;
+  _events = 0;
+  _durationUs = 0;
+  while (reader.next(event)) {
+    _events++;
+    _durationUs = event.timeUs;
+  }
+  return reader._pos == _size;
+}
+
+bool SessionLog::save(fs::FS &fs, const char *path) const {
+  File file = fs.open(path, FILE_WRITE);
+  if (!file) return false;
+
+  uint8_t size[4] = {(uint8_t)_size, (uint8_t)(_size >> 8), (uint8_t)(_size >> 16), (uint8_t)(_size >> 24)};
+  bool ok = file.write(sessionMagic, 4) == 4 && file.write(size, 4) == 4 && file.write(_buf, _size) == _size;
+  file.close();
+  return ok;
+}
+
+bool SessionLog::load(fs::FS &fs, const char *path) {
+  File file = fs.open(path, FILE_READ);
+  if (!file) return false;
+
+  clear();
+  uint8_t header[8];
+  bool ok = file.read(header, 8) == 8 && memcmp(header, sessionMagic, 4) == 0;
+  if (ok) {
+    size_t size = header[4] | (header[5] << 8) | ((uint32_t)header[6] << 16) | ((uint32_t)header[7] << 24);
+    ok = size <= CAPACITY && file.read(_buf, size) == size;
+    if (ok) _size = size;
+  }
+  file.close();
+
+  if (!ok || !rescan()) {
+    clear();
+    return false;
+  }
+  return true;
+}
+
+void SessionLog::dump(Print &out) const {
+  // Текстовый hex, чтобы выгрузка не ломала терминал
+  out.print("SESSION ");
+  out.print((uint32_t)_size);
+  out.print(" ");
+  out.println(_events);
+
+  for (size_t i = 0; i < _size; i++) {
+    if (_buf[i] < 16) out.print("0");
+    out.print(_buf[i], HEX);
+    if ((i & 31) == 31 || i + 1 == _size) out.println();
+  }
+  out.println("END");
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+// Журнал сеанса настройки: байты консоли и записи в регистры драйвера
+// с отметками времени в мкс. Хранится в RAM в компактном двоичном виде,
+// каждое событие:
+//
+//   тег (1 байт) | дельта времени от предыдущего события (varint) | данные
+//
+// Нажатие клавиши занимает 3-4 байта, запись регистра - 4-5 байт.
+// Первым событием идёт снимок состояния стенда на момент начала записи.
+
+enum SessionEventType : uint8_t {
+  SESSION_SNAPSHOT = 1,  // данные: длина (1 байт) + байты снимка
+  SESSION_INPUT = 2,     // данные: байт консоли
+  SESSION_COMMIT = 3     // данные: адрес регистра, значение
+};
+
+struct SessionEvent {
+  SessionEventType type;
+  uint32_t timeUs;      // от начала записи
+  uint8_t reg;          // SESSION_COMMIT - адрес, SESSION_INPUT - символ
+  uint8_t value;        // SESSION_COMMIT
+  const uint8_t *data;  // SESSION_SNAPSHOT
+  uint8_t length;       // SESSION_SNAPSHOT
+};
+
+class SessionLog {
+ public:
+  static const size_t CAPACITY = 16384;
+
+  void start(uint32_t nowUs, const void *snapshot, uint8_t length);
+  void stop() { _recording = false; }
+  void clear();
+
+  void addInput(uint32_t nowUs, char c);
+  void addCommit(uint32_t nowUs, uint8_t reg, uint8_t value);
+
+  bool recording() const { return _recording; }
+  bool overflow() const { return _overflow; }
+  size_t size() const { return _size; }
+  uint32_t events() const { return _events; }
+  uint32_t durationUs() const { return _durationUs; }
+
+  bool save(fs::FS &fs, const char *path) const;
+  bool load(fs::FS &fs, const char *path);
+  void dump(Print &out) const;
+
+  // Последовательное чтение событий
+  class Reader {
+   public:
+    explicit Reader(const SessionLog &log) : _log(log) {}
+    bool next(SessionEvent &event);
+
+   private:
+    friend class SessionLog;
+    const SessionLog &_log;
+    size_t _pos = 0;
+    uint32_t _timeUs = 0;
+  };
+
+ private:
+  bool append(SessionEventType type, uint32_t nowUs, const uint8_t *payload, uint8_t length);
+  bool rescan();
+
+  uint8_t _buf[CAPACITY];
+  size_t _size = 0;
+  uint32_t _events = 0;
+  uint32_t _lastUs = 0;
+  uint32_t _durationUs = 0;
+  bool _recording = false;
+  bool _overflow = false;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+// Кольцевая очередь без блокировок для одного писателя и одного читателя
+// (две задачи FreeRTOS). Память статическая, N - степень двойки.
+// Индексы растут монотонно: заполненность - разность head и tail.
+// Писатель меняет только head, читатель - только tail, поэтому хватает
+// атомарных load/store без RMW-инструкций (у ESP32-C3 их нет).
+template <typename T, size_t N>
+class SpscRing {
+  static_assert(N && (N & (N - 1)) == 0, "размер очереди - степень двойки");
+
+ public:
+  // Только писатель
+  bool push(const T &item) {
+    size_t head = _head.load(std::memory_order_relaxed);
+    size_t used = head - _tail.load(std::memory_order_acquire);
+    if (used == N) return false;
+
+    _items[head & (N - 1)] = item;
+    _head.store(head + 1, std::memory_order_release);
+    if (used + 1 > _highWater.load(std::memory_order_relaxed)) _highWater.store(used + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Только читатель
+  bool pop(T &item) {
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire)) return false;
+
+    item = _items[tail & (N - 1)];
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t size() const { return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire); }
+  size_t space() const { return N - size(); }
+  bool empty() const { return size() == 0; }
+  size_t highWater() const { return _highWater.load(std::memory_order_relaxed); }
+  static constexpr size_t capacity() { return N; }
+
+ private:
+  T _items[N];
+  std::atomic<size_t> _head{0};
+  std::atomic<size_t> _tail{0};
+  std::atomic<size_t> _highWater{0};
+};
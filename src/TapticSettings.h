@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stdint.h>
+
+// Настройки для тонкой регулировки
+struct TapticSettings {
+  uint8_t feedbackReg;      // Регистр 0x1A - основной контроль
+  uint8_t controlReg;       // Регистр 0x1C - контроль формы сигнала
+  uint8_t driveReg;         // Регистр 0x18 - уровень драйва
+  uint16_t frequency;       // Частота в Гц (235 для iPhone 7), в 0x20 - как период
+  uint8_t effect;           // Номер эффекта
+  uint8_t overdriveReg;     // Регистр 0x16 - контроль перегрузки
+  uint8_t compensationReg;  // Регистр 0x17 - компенсация
+};
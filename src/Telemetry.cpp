@@ -0,0 +1,68 @@
+#include "Telemetry.h"
+
+#include "DrvUnits.h"
+
+void TelemetryStream::setFormat(TelemetryFormat format) {
+  _format = format;
+  _head = 0;
+  _count = 0;
+}
+
+void TelemetryStream::push(uint32_t timeUs, uint8_t status, uint8_t vbat, uint8_t lraPeriod) {
+  if (_count == DEPTH) {
+    // Порт не успевает - вытесняем самый старый отсчёт
+    _head = (_head + 1) % DEPTH;
+    _count--;
+    _dropped++;
+  }
+
+  TelemetrySample &sample = _ring[(_head + _count) % DEPTH];
+  sample.seq = _seq++;
+  sample.timeUs = timeUs;
+  sample.status = status;
+  sample.vbat = vbat;
+  sample.lraPeriod = lraPeriod;
+  _count++;
+  _samples++;
+}
+
+void TelemetryStream::drain(Print &out, int room) {
+  uint8_t record[64];
+  while (_count) {
+    size_t length = encode(_ring[_head], record);
+    if ((int)length > room) return;
+
+    out.write(record, length);
+    room -= length;
+    _head = (_head + 1) % DEPTH;
+    _count--;
+  }
+}
+
+size_t TelemetryStream::encode(const TelemetrySample &sample, uint8_t *out) const {
+  if (_format == TELEMETRY_BINARY) {
+    out[0] = BINARY_SYNC;
+    out[1] = sample.seq;
+    out[2] = sample.seq >> 8;
+    out[3] = sample.timeUs;
+    out[4] = sample.timeUs >> 8;
+    out[5] = sample.timeUs >> 16;
+    out[6] = sample.timeUs >> 24;
+    out[7] = sample.status;
+    out[8] = sample.vbat;
+    out[9] = sample.lraPeriod;
+
+    uint8_t check = 0;
+    for (uint8_t i = 1; i < 10; i++) check ^= out[i];
+    out[10] = check;
+    return 11;
+  }
+
+  uint32_t periodUs10 = lraPeriodUs10(sample.lraPeriod);
+  uint32_t hz10 = lraHz10(sample.lraPeriod);
+  int length = snprintf((char *)out, 64, "T,%u,%lu,%02X,%u,%lu.%lu,%lu.%lu\r\n", sample.seq,
+                        (unsigned long)sample.timeUs, sample.status, vbatMillivolts(sample.vbat),
+                        (unsigned long)(periodUs10 / 10), (unsigned long)(periodUs10 % 10),
+                        (unsigned long)(hz10 / 10), (unsigned long)(hz10 % 10));
+  return length > 0 ? length : 0;
+}
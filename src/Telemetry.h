@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Поток телеметрии драйвера: STATUS, VBAT и период резонанса LRA.
+// Отсчёты копятся в небольшом кольце и уходят в консоль только целыми
+// записями и только пока в буфере передачи есть место. Если порт не
+// успевает, старые отсчёты вытесняются новыми - пропуски видны по seq.
+//
+// CSV:      T,seq,t_us,status,vbat_mv,period_us,hz
+// Двоичный: 0xA5 | seq (2) | t_us (4) | status | vbat | period | xor
+//           (многобайтовые поля - little-endian, xor - по всем байтам после 0xA5)
+
+enum TelemetryFormat : uint8_t {
+  TELEMETRY_OFF,
+  TELEMETRY_CSV,
+  TELEMETRY_BINARY
+};
+
+struct TelemetrySample {
+  uint16_t seq;
+  uint32_t timeUs;
+  uint8_t status;
+  uint8_t vbat;
+  uint8_t lraPeriod;
+};
+
+class TelemetryStream {
+ public:
+  static const uint8_t DEPTH = 32;
+  static const uint8_t BINARY_SYNC = 0xA5;
+
+  void setFormat(TelemetryFormat format);
+  TelemetryFormat format() const { return _format; }
+
+  void push(uint32_t timeUs, uint8_t status, uint8_t vbat, uint8_t lraPeriod);
+  void drain(Print &out, int room);
+
+  uint32_t samples() const { return _samples; }
+  uint32_t dropped() const { return _dropped; }
+  uint8_t pending() const { return _count; }
+
+ private:
+  size_t encode(const TelemetrySample &sample, uint8_t *out) const;
+
+  TelemetrySample _ring[DEPTH];
+  uint8_t _head = 0;
+  uint8_t _count = 0;
+  uint16_t _seq = 0;
+  uint32_t _samples = 0;
+  uint32_t _dropped = 0;
+  TelemetryFormat _format = TELEMETRY_OFF;
+};
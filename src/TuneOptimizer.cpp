@@ -0,0 +1,110 @@
+#include "TuneOptimizer.h"
+
+#include <string.h>
+
+void TuneOptimizer::begin(uint8_t dims, const int16_t *start, const int16_t *lo, const int16_t *hi,
+                          const int16_t *step, uint16_t budget) {
+  if (dims > MAX_DIMS) dims = MAX_DIMS;
+  _dims = dims;
+  for (uint8_t i = 0; i < dims; i++) {
+    _lo[i] = lo[i];
+    _hi[i] = hi[i];
+    _best[i] = start[i] < lo[i] ? lo[i] : (start[i] > hi[i] ? hi[i] : start[i]);
+    // Шире четверти диапазона шаг не растёт - дальше он только перескакивает
+    _maxStep[i] = (hi[i] - lo[i] + 1) / 4;
+    if (_maxStep[i] < 1) _maxStep[i] = 1;
+    _step[i] = step[i] < 1 ? 1 : (step[i] > _maxStep[i] ? _maxStep[i] : step[i]);
+    _dir[i] = 1;
+  }
+  _bestScore = 0;
+  _dim = 0;
+  _reversed = false;
+  _pending = false;
+  _budget = budget;
+  _evaluations = 0;
+  _improvements = 0;
+  _active = dims > 0 && budget > 0;
+}
+
+bool TuneOptimizer::next(int16_t *point) {
+  if (!_active) return false;
+  if (_pending) {
+    memcpy(point, _candidate, _dims * sizeof(int16_t));
+    return true;
+  }
+
+  // Первый замер - в начальной точке
+  if (_evaluations == 0) {
+    memcpy(_candidate, _best, _dims * sizeof(int16_t));
+    memcpy(point, _candidate, _dims * sizeof(int16_t));
+    _pending = true;
+    return true;
+  }
+
+  for (;;) {
+    bool moving = false;
+    for (uint8_t i = 0; i < _dims; i++) moving = moving || _step[i] > 0;
+    if (!moving) {
+      _active = false;
+      return false;
+    }
+    if (_step[_dim] == 0) {
+      nextDim();
+      continue;
+    }
+
+    int32_t value = _best[_dim] + _dir[_dim] * _step[_dim];
+    if (value < _lo[_dim]) value = _lo[_dim];
+    if (value > _hi[_dim]) value = _hi[_dim];
+    if (value == _best[_dim]) {
+      // Упёрлись в границу - замер не тратим
+      miss();
+      continue;
+    }
+
+    memcpy(_candidate, _best, _dims * sizeof(int16_t));
+    _candidate[_dim] = value;
+    memcpy(point, _candidate, _dims * sizeof(int16_t));
+    _pending = true;
+    return true;
+  }
+}
+
+void TuneOptimizer::report(float score) {
+  if (!_active || !_pending) return;
+  _pending = false;
+  _evaluations++;
+
+  if (_evaluations == 1) {
+    _bestScore = score;
+  } else if (score > _bestScore) {
+    _bestScore = score;
+    _best[_dim] = _candidate[_dim];
+    _improvements++;
+    // Сторону запоминаем, шаг растёт
+    _step[_dim] = _step[_dim] * 2 > _maxStep[_dim] ? _maxStep[_dim] : _step[_dim] * 2;
+    _reversed = false;
+    nextDim();
+  } else {
+    miss();
+  }
+
+  if (_evaluations >= _budget) _active = false;
+}
+
+void TuneOptimizer::miss() {
+  _dir[_dim] = -_dir[_dim];
+  if (!_reversed) {
+    _reversed = true;
+    return;
+  }
+  // Обе стороны хуже: сторона возвращается к исходной, шаг - вдвое меньше
+  _reversed = false;
+  _step[_dim] /= 2;
+  nextDim();
+}
+
+void TuneOptimizer::nextDim() {
+  _dim = (_dim + 1) % _dims;
+  _reversed = false;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+
+// Поиск настроек без производных: покоординатный спуск с адаптивным шагом.
+// Каждая точка - одно воспроизведение и одна измеренная оценка (больше -
+// лучше), поэтому важнее число замеров, а не вычисления.
+//
+// По очереди для каждой координаты пробуем шаг в запомненную сторону,
+// при неудаче - в обратную. Удачный шаг принимается и удваивается, две
+// неудачи подряд делят шаг пополам. Поиск заканчивается, когда все шаги
+// сжались до нуля или исчерпан бюджет замеров. На 8 координатах хорошая
+// точка находится за десятки замеров, сетке нужны тысячи.
+//
+// Работает по схеме "спросить/ответить": next() выдаёт точку, report()
+// принимает её оценку. Между ними стенд играет эффект и ждёт замера,
+// ничего не блокируя. Кода для Arduino здесь нет - тот же поиск
+// собирается в инструментах на ПК (tools/tune_opt).
+
+class TuneOptimizer {
+ public:
+  static const uint8_t MAX_DIMS = 8;
+
+  // start, lo, hi, step - по значению на координату
+  void begin(uint8_t dims, const int16_t *start, const int16_t *lo, const int16_t *hi,
+             const int16_t *step, uint16_t budget);
+  // Следующая точка для замера; false - поиск окончен. Пока оценка не
+  // получена, возвращает ту же точку
+  bool next(int16_t *point);
+  void report(float score);
+  void stop() { _active = false; }
+
+  bool active() const { return _active; }
+  uint8_t dims() const { return _dims; }
+  uint16_t evaluations() const { return _evaluations; }
+  uint16_t improvements() const { return _improvements; }
+  const int16_t *best() const { return _best; }
+  float bestScore() const { return _bestScore; }
+
+ private:
+  void miss();
+  void nextDim();
+
+  uint8_t _dims = 0;
+  int16_t _lo[MAX_DIMS];
+  int16_t _hi[MAX_DIMS];
+  int16_t _step[MAX_DIMS];
+  int16_t _maxStep[MAX_DIMS];
+  int8_t _dir[MAX_DIMS];  // сторона, куда шагнуть сначала
+  int16_t _best[MAX_DIMS];
+  int16_t _candidate[MAX_DIMS];
+  float _bestScore = 0;
+  uint8_t _dim = 0;
+  bool _reversed = false;  // первая сторона уже не подошла
+  bool _pending = false;   // точка выдана, оценки ещё нет
+  bool _active = false;
+  uint16_t _budget = 0;
+  uint16_t _evaluations = 0;
+  uint16_t _improvements = 0;
+};
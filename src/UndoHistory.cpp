@@ -0,0 +1,137 @@
+#include "UndoHistory.h"
+
+static const uint8_t fieldCount = 7;
+
+static uint16_t getField(const TapticSettings &settings, uint8_t field) {
+  switch (field) {
+    case 0: return settings.feedbackReg;
+    case 1: return settings.controlReg;
+    case 2: return settings.driveReg;
+    case 3: return settings.frequency;
+    case 4: return settings.effect;
+    case 5: return settings.overdriveReg;
+    default: return settings.compensationReg;
+  }
+}
+
+static void setField(TapticSettings &settings, uint8_t field, uint16_t value) {
+  switch (field) {
+    case 0: settings.feedbackReg = value; break;
+    case 1: settings.controlReg = value; break;
+    case 2: settings.driveReg = value; break;
+    case 3: settings.frequency = value; break;
+    case 4: settings.effect = value; break;
+    case 5: settings.overdriveReg = value; break;
+    default: settings.compensationReg = value; break;
+  }
+}
+
+// Частота - единственное 16-битное поле, её xor занимает два байта
+static uint8_t fieldBytes(uint8_t field) { return field == 3 ? 2 : 1; }
+
+void UndoHistory::clear() {
+  _tail = _cursor = _head = 0;
+  _undoSteps = _redoSteps = 0;
+}
+
+void UndoHistory::record(const TapticSettings &before, const TapticSettings &after) {
+  uint8_t payload[fieldCount * 3];
+  uint8_t length = 0;
+  uint8_t changed = 0;
+  uint8_t small = 0;
+
+  for (uint8_t field = 0; field < fieldCount; field++) {
+    uint16_t a = getField(before, field);
+    uint16_t b = getField(after, field);
+    if (a == b) continue;
+
+    changed++;
+    // Разница по модулю ширины поля: переход 0 -> 255 клавишей - тоже шаг -1
+    int32_t delta = fieldBytes(field) == 2 ? (int16_t)(b - a) : (int8_t)(b - a);
+    small = (field << 4) | (delta & 0x0F);
+    if (delta < -8 || delta > 7) small = 0x80;  // не влезает в короткую форму
+
+    uint16_t diff = a ^ b;
+    payload[length++] = field;
+    payload[length++] = diff;
+    if (fieldBytes(field) == 2) payload[length++] = diff >> 8;
+  }
+  if (changed == 0) return;
+
+  uint8_t size = (changed == 1 && !(small & 0x80)) ? 1 : length + 2;
+
+  // Новый шаг отменяет возможность повтора
+  _head = _cursor;
+  _redoSteps = 0;
+  while (_head + size - _tail > CAPACITY) dropOldest();
+
+  if (size == 1) {
+    put(_head, small);
+  } else {
+    put(_head, 0x80 | length);
+    for (uint8_t i = 0; i < length; i++) put(_head + 1 + i, payload[i]);
+    put(_head + 1 + length, 0x80 | length);
+  }
+  _head += size;
+  _cursor = _head;
+  _undoSteps++;
+}
+
+uint8_t UndoHistory::recordLength(uint32_t start) const {
+  uint8_t first = at(start);
+  return (first & 0x80) ? (first & 0x7F) + 2 : 1;
+}
+
+void UndoHistory::dropOldest() {
+  _tail += recordLength(_tail);
+  if (_tail > _cursor) {
+    // Вытеснили и шаг, который можно было повторить
+    _cursor = _tail;
+    _redoSteps--;
+  } else {
+    _undoSteps--;
+  }
+}
+
+void UndoHistory::applyRecord(uint32_t start, uint8_t length, TapticSettings &settings, bool forward) {
+  if (length == 1) {
+    uint8_t small = at(start);
+    uint8_t field = (small >> 4) & 0x07;
+    int8_t delta = (int8_t)(small << 4) >> 4;  // знаковые 4 бита
+    setField(settings, field, getField(settings, field) + (forward ? delta : -delta));
+    return;
+  }
+
+  // xor обратим сам по себе - направление для длинной формы не важно
+  uint32_t pos = start + 1;
+  uint32_t end = start + length - 1;
+  while (pos < end) {
+    uint8_t field = at(pos++);
+    uint16_t diff = at(pos++);
+    if (fieldBytes(field) == 2) diff |= at(pos++) << 8;
+    setField(settings, field, getField(settings, field) ^ diff);
+  }
+}
+
+bool UndoHistory::undo(TapticSettings &settings) {
+  if (_cursor == _tail) return false;
+
+  uint8_t last = at(_cursor - 1);
+  uint8_t length = (last & 0x80) ? (last & 0x7F) + 2 : 1;
+  _cursor -= length;
+  applyRecord(_cursor, length, settings, false);
+  _undoSteps--;
+  _redoSteps++;
+  return true;
+}
+
+bool UndoHistory::redo(TapticSettings &settings) {
+  if (_cursor == _head) return false;
+
+  uint8_t length = recordLength(_cursor);
+  applyRecord(_cursor, length, settings, true);
+  _cursor += length;
+  _undoSteps++;
+  _redoSteps--;
+  return true;
+}
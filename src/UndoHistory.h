@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "TapticSettings.h"
+
+// История изменений настроек для отмены/повтора. Шаг хранится как разница
+// между наборами настроек в кольцевом буфере фиксированного размера:
+//
+//   0fffdddd                - одно поле f изменилось на d (-8..7), 1 байт
+//   1nnnnnnn <данные> 1nnnnnnn - n байт пар (поле, xor старого и нового)
+//
+// Обычный шаг клавишей занимает один байт. Запись читается с обоих концов,
+// поэтому по буферу можно идти и назад (отмена), и вперёд (повтор).
+// При переполнении вытесняются самые старые шаги.
+class UndoHistory {
+ public:
+  static const uint16_t CAPACITY = 4096;
+
+  void record(const TapticSettings &before, const TapticSettings &after);
+  bool undo(TapticSettings &settings);
+  bool redo(TapticSettings &settings);
+  void clear();
+
+  uint16_t undoSteps() const { return _undoSteps; }
+  uint16_t redoSteps() const { return _redoSteps; }
+  uint16_t bytesUsed() const { return _head - _tail; }
+
+ private:
+  uint8_t at(uint32_t pos) const { return _buf[pos % CAPACITY]; }
+  void put(uint32_t pos, uint8_t value) { _buf[pos % CAPACITY] = value; }
+  uint8_t recordLength(uint32_t start) const;
+  void applyRecord(uint32_t start, uint8_t length, TapticSettings &settings, bool forward);
+  void dropOldest();
+
+  uint8_t _buf[CAPACITY];
+  uint32_t _tail = 0;    // начало самого старого шага
+  uint32_t _cursor = 0;  // конец последнего применённого шага
+  uint32_t _head = 0;    // конец последнего шага, который можно повторить
+  uint16_t _undoSteps = 0;
+  uint16_t _redoSteps = 0;
+};
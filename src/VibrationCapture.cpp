@@ -0,0 +1,119 @@
+#include "VibrationCapture.h"
+
+namespace {
+
+uint16_t isqrt(uint32_t value) {
+  uint32_t root = 0;
+  uint32_t bit = 1UL << 30;
+  while (bit > value) bit >>= 2;
+  while (bit) {
+    if (value >= root + bit) {
+      value -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return root;
+}
+
+int16_t clampMg(int32_t value) {
+  if (value > INT16_MAX) return INT16_MAX;
+  if (value < INT16_MIN) return INT16_MIN;
+  return value;
+}
+
+}  // namespace
+
+void VibrationCapture::start(uint16_t rateHz) {
+  _rateHz = rateHz;
+  _count = 0;
+  _overruns = 0;
+  _restCount = 0;
+  for (uint8_t axis = 0; axis < 3; axis++) _restSum[axis] = 0;
+}
+
+void VibrationCapture::addRest(int16_t x, int16_t y, int16_t z) {
+  _restSum[0] += x;
+  _restSum[1] += y;
+  _restSum[2] += z;
+  _restCount++;
+}
+
+bool VibrationCapture::add(int16_t x, int16_t y, int16_t z) {
+  if (_count == CAPACITY) return false;
+
+  if (_count == 0) {
+    // Покоя нет (FIFO был пуст) - отсчитываем от первого отсчёта
+    if (_restCount == 0) addRest(x, y, z);
+    for (uint8_t axis = 0; axis < 3; axis++) {
+      int32_t sum = _restSum[axis];
+      int32_t half = _restCount / 2;
+      _rest[axis] = (sum >= 0 ? sum + half : sum - half) / (int32_t)_restCount;
+    }
+  }
+
+  _x[_count] = clampMg((int32_t)x - _rest[0]);
+  _y[_count] = clampMg((int32_t)y - _rest[1]);
+  _z[_count] = clampMg((int32_t)z - _rest[2]);
+  _count++;
+  return true;
+}
+
+uint16_t VibrationCapture::magnitude(uint16_t i) const {
+  uint32_t sum = (int32_t)_x[i] * _x[i];
+  sum += (int32_t)_y[i] * _y[i];
+  sum += (int32_t)_z[i] * _z[i];
+  return isqrt(sum);
+}
+
+VibrationMetrics VibrationCapture::finish() {
+  VibrationMetrics metrics = {0, 0, 0, 0, _count, _overruns};
+  if (_count == 0) return metrics;
+
+  uint16_t peak = 0;
+  for (uint16_t i = 0; i < _count; i++) {
+    uint16_t m = magnitude(i);
+    if (m > peak) peak = m;
+  }
+  metrics.peakMg = peak;
+  if (peak == 0) return metrics;
+  uint16_t low = (peak + 5) / 10;
+  uint16_t high = ((uint32_t)peak * 9 + 5) / 10;
+
+  // Огибающая: максимум по окну вокруг отсчёта, модули - в маленьком кольце
+  const uint8_t window = ENVELOPE_HALF * 2 + 1;
+  uint16_t ring[window] = {0};
+  int32_t firstLow = -1, firstHigh = -1, lastHigh = -1, lastLow = -1;
+  for (uint32_t i = 0; i < (uint32_t)_count + ENVELOPE_HALF; i++) {
+    ring[i % window] = i < _count ? magnitude(i) : 0;
+    if (i < ENVELOPE_HALF) continue;
+
+    uint16_t envelope = 0;
+    for (uint8_t k = 0; k < window; k++)
+      if (ring[k] > envelope) envelope = ring[k];
+    int32_t center = i - ENVELOPE_HALF;
+    if (envelope >= low) {
+      if (firstLow < 0) firstLow = center;
+      lastLow = center;
+    }
+    if (envelope >= high) {
+      if (firstHigh < 0) firstHigh = center;
+      lastHigh = center;
+    }
+  }
+
+  // СКЗ по участку выше 10%: квадрат модуля - сумма квадратов осей
+  uint64_t sumSquares = 0;
+  for (int32_t i = firstLow; i <= lastLow; i++) {
+    sumSquares += (int32_t)_x[i] * _x[i];
+    sumSquares += (int32_t)_y[i] * _y[i];
+    sumSquares += (int32_t)_z[i] * _z[i];
+  }
+  metrics.rmsMg = isqrt(sumSquares / (uint32_t)(lastLow - firstLow + 1));
+
+  metrics.riseUs = (uint32_t)(firstHigh - firstLow) * 1000000UL / _rateHz;
+  metrics.fallUs = (uint32_t)(lastLow - lastHigh) * 1000000UL / _rateHz;
+  return metrics;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+
+// Запись вибрации за одно воспроизведение и её характеристики.
+//
+// Отсчёты приходят из FIFO акселерометра (мг по трём осям). Покой - то,
+// что лежало в FIFO до запуска эффекта: его среднее (сила тяжести и
+// смещение нуля) вычитается из каждого отсчёта, и по осям хранится уже
+// чистая вибрация - её же потом берёт спектральный анализ.
+//
+// Характеристики считаются по модулю вектора. Огибающая - скользящий
+// максимум модуля по окну ENVELOPE_HALF*2+1 отсчётов (больше полупериода
+// LRA на 1.6 кГц), от неё берутся уровни 10% и 90% пика:
+//   peakMg  - пик модуля;
+//   rmsMg   - СКЗ модуля между первым и последним пересечением 10%;
+//   riseUs  - от первого пересечения 10% до первого пересечения 90%;
+//   fallUs  - от последнего отсчёта выше 90% до последнего выше 10%.
+// Кода для Arduino здесь нет - те же расчёты собираются в инструментах
+// на ПК (tools/accel_bench).
+
+struct VibrationMetrics {
+  uint16_t peakMg;
+  uint16_t rmsMg;
+  uint32_t riseUs;
+  uint32_t fallUs;
+  uint16_t samples;
+  uint16_t overruns;  // опросы, заставшие FIFO полным - отсчёты могли пропасть
+};
+
+class VibrationCapture {
+ public:
+  static const uint16_t CAPACITY = 2048;  // 1.28 с на 1.6 кГц
+  static const uint8_t ENVELOPE_HALF = 4;
+
+  void start(uint16_t rateHz);
+  // Отсчёт покоя, до запуска эффекта
+  void addRest(int16_t x, int16_t y, int16_t z);
+  // Отсчёт записи; false - буфер полон
+  bool add(int16_t x, int16_t y, int16_t z);
+  void markOverrun() { _overruns++; }
+  VibrationMetrics finish();
+
+  bool full() const { return _count == CAPACITY; }
+  uint16_t samples() const { return _count; }
+  uint16_t rateHz() const { return _rateHz; }
+  // Вибрация по осям без покоя, мг
+  const int16_t *x() const { return _x; }
+  const int16_t *y() const { return _y; }
+  const int16_t *z() const { return _z; }
+
+ private:
+  uint16_t magnitude(uint16_t i) const;
+
+  int16_t _x[CAPACITY];
+  int16_t _y[CAPACITY];
+  int16_t _z[CAPACITY];
+  uint16_t _count = 0;
+  uint16_t _rateHz = 0;
+  uint16_t _overruns = 0;
+
+  int32_t _restSum[3] = {0, 0, 0};
+  uint16_t _restCount = 0;
+  int16_t _rest[3] = {0, 0, 0};
+};
@@ -1,19 +1,120 @@
+#include <LittleFS.h>
+#include <Preferences.h>
 #include <Wire.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
+#include "Adafruit_BusIO_Register.h"
 #include "Adafruit_DRV2605.h"
+#include "DRV2605_RegisterMap.h"
+#include "DrvUnits.h"
+#include "LIS3DH_Fifo.h"
+#include "PresetBank.h"
+#include "PwmOutput.h"
+#include "PwmPlayer.h"
+#include "ResonanceEstimator.h"
+#include "ScriptVm.h"
+#include "SessionLog.h"
+#include "SpscRing.h"
+#include "TapticSettings.h"
+#include "Telemetry.h"
+#include "TuneOptimizer.h"
+#include "UndoHistory.h"
+#include "VibrationCapture.h"
 
 Adafruit_DRV2605 drv;
-
-// Настройки для тонкой регулировки
-struct TapticSettings {
-  uint8_t feedbackReg;      // Регистр 0x1A - основной контроль
-  uint8_t controlReg;       // Регистр 0x1C - контроль формы сигнала
-  uint8_t driveReg;         // Регистр 0x18 - уровень драйва
-  uint8_t frequency;        // Частота (235 для iPhone 7)
-  uint8_t effect;           // Номер эффекта
-  uint8_t overdriveReg;     // Регистр 0x16 - контроль перегрузки
-  uint8_t compensationReg;  // Регистр 0x17 - компенсация
+Preferences prefs;
+
+// Прошивка разделена на три задачи FreeRTOS:
+//   ввод  - читает Serial и передаёт байты задаче шины;
+//   шина  - разбор команд, регистры, воспроизведение (высший приоритет);
+//   вывод - переносит накопленный текст в Serial.
+// Между ними - очереди SpscRing, так что медленный USB-хост
+// не задерживает ни разбор команд, ни вибрацию.
+struct InputEvent {
+  uint32_t timeUs;  // когда байт пришёл, для журнала сеанса
+  char c;
+};
+SpscRing<InputEvent, 256> inputQueue;  // ввод -> шина
+SpscRing<uint8_t, 8192> outputQueue;   // шина -> вывод
+
+// Весь вывод идёт через console: считает объём и складывает текст в
+// очередь вывода. Писать в console может только задача шины (и setup()
+// до её запуска) - у очереди один писатель. Если очередь полна, текст
+// теряется, но воспроизведение не ждёт.
+class ConsoleOut : public Print {
+ public:
+  size_t write(uint8_t c) override {
+    bytes++;
+    if (outputQueue.push(c)) return 1;
+    dropped++;
+    return 0;
+  }
+  size_t write(const uint8_t *buffer, size_t size) override {
+    size_t written = 0;
+    for (size_t i = 0; i < size; i++) written += write(buffer[i]);
+    return written;
+  }
+  int availableForWrite() override { return outputQueue.space(); }
+  uint32_t bytes = 0;
+  uint32_t dropped = 0;
 };
+ConsoleOut console;
+
+// Загрузка задач: время работы считают сами задачи, включая ожидание шины
+struct TaskStats {
+  const char *name;
+  TaskHandle_t handle;
+  volatile uint32_t busyUs;
+  uint32_t reportedBusyUs;
+};
+TaskStats inputStats = {"ввод", nullptr, 0, 0};
+TaskStats busStats = {"шина", nullptr, 0, 0};
+TaskStats renderStats = {"вывод", nullptr, 0, 0};
+uint32_t lastTaskReportUs = 0;
+uint32_t inputStalls = 0;  // опросы, заставшие очередь ввода полной
+
+StaticTask_t inputTaskTcb;
+StaticTask_t busTaskTcb;
+StaticTask_t renderTaskTcb;
+StackType_t inputTaskStack[3072];
+StackType_t busTaskStack[12288];
+StackType_t renderTaskStack[3072];
+
+// Блок регистров 0x16-0x1E читается одной транзакцией, битовые поля
+// расшифровываются из кэша без обращений к шине. Регистры ходят через сам
+// драйвер: то же I2C-устройство и та же подстройка частоты при NACK
+bool drvBusRaw(void *, uint8_t *, size_t) { return false; }
+bool drvBusRawWrite(void *, const uint8_t *, size_t) { return false; }
+bool drvBusReadRegister(void *, uint8_t *addr, uint8_t, uint8_t *data, uint16_t len) {
+  return drv.readRegisters(addr[0], data, len);
+}
+bool drvBusWriteRegister(void *, uint8_t *addr, uint8_t, const uint8_t *data, uint16_t len) {
+  return drv.writeRegisters(addr[0], data, len);
+}
+Adafruit_GenericDevice drvBus(nullptr, drvBusRaw, drvBusRawWrite, drvBusReadRegister,
+                              drvBusWriteRegister);
+Adafruit_BusIO_Register drvConfigStart(&drvBus, DRV2605_REG_RATEDV);
+Adafruit_BusIO_RegisterBlock drvConfig(&drvConfigStart, DRV2605_REG_CONTROL4 - DRV2605_REG_RATEDV + 1);
+
+Adafruit_BusIO_Register feedbackBlockReg(&drvConfig, DRV2605_REG_FEEDBACK);
+Adafruit_BusIO_Register control1BlockReg(&drvConfig, DRV2605_REG_CONTROL1);
+Adafruit_BusIO_Register control2BlockReg(&drvConfig, DRV2605_REG_CONTROL2);
+Adafruit_BusIO_Register control3BlockReg(&drvConfig, DRV2605_REG_CONTROL3);
+
+Adafruit_BusIO_RegisterBits fbErmLra(&feedbackBlockReg, 1, 7);
+Adafruit_BusIO_RegisterBits fbBrakeFactor(&feedbackBlockReg, 3, 4);
+Adafruit_BusIO_RegisterBits fbLoopGain(&feedbackBlockReg, 2, 2);
+Adafruit_BusIO_RegisterBits fbBemfGain(&feedbackBlockReg, 2, 0);
+Adafruit_BusIO_RegisterBits c1StartupBoost(&control1BlockReg, 1, 7);
+Adafruit_BusIO_RegisterBits c1DriveTime(&control1BlockReg, 5, 0);
+Adafruit_BusIO_RegisterBits c2BrakeStabilizer(&control2BlockReg, 1, 6);
+Adafruit_BusIO_RegisterBits c2SampleTime(&control2BlockReg, 2, 4);
+Adafruit_BusIO_RegisterBits c2BlankingTime(&control2BlockReg, 2, 2);
+Adafruit_BusIO_RegisterBits c2IdissTime(&control2BlockReg, 2, 0);
+Adafruit_BusIO_RegisterBits c3ErmOpenLoop(&control3BlockReg, 1, 5);
+Adafruit_BusIO_RegisterBits c3LraOpenLoop(&control3BlockReg, 1, 0);
 
 TapticSettings currentSettings = {
     0xFA,  // feedbackReg
@@ -29,6 +130,246 @@ bool directInputMode = false;
 int currentParameter = 0;
 String inputBuffer = "";
 
+// Автоматический standby драйвера (бит 6 регистра MODE)
+const uint32_t standbyTimeouts[] = {0, 10000, 30000, 60000, 300000};  // мс, 0 - выключен
+uint8_t standbyTimeoutIndex = 2;
+bool driverInStandby = false;
+uint32_t lastActivityMs = 0;
+
+// Замер задержки: пробуждение -> первая вибрация (драйвер взвёл GO)
+bool wakeLatencyPending = false;
+uint32_t wakeStartUs = 0;
+uint32_t lastWakeLatencyUs = 0;
+uint32_t maxWakeLatencyUs = 0;
+uint32_t wakeCount = 0;
+
+// Склейка серий нажатий: при автоповторе клавиши применяем/печатаем/играем
+// один раз, когда ввод затих на inputCoalesceMs
+const uint32_t inputCoalesceMs = 60;
+bool pendingInput = false;
+uint32_t lastInputMs = 0;
+
+// Политика перезапуска эффекта, если предыдущий ещё играет (бит GO)
+enum RetriggerPolicy {
+  RETRIGGER_RESTART,  // остановить текущий и сразу начать заново
+  RETRIGGER_QUEUE,    // сыграть все запросы по очереди
+  RETRIGGER_LATEST    // после окончания сыграть только последний запрос
+};
+RetriggerPolicy retriggerPolicy = RETRIGGER_LATEST;
+
+// Чем запускается последовательность. Во внешних режимах она заранее
+// загружена по I2C, а запуск - только вывод IN/TRIG, без очереди шины.
+enum TriggerSource {
+  TRIGGER_GO,    // запись GO по I2C (INTTRIG)
+  TRIGGER_EDGE,  // фронт на IN/TRIG (EXTTRIGEDGE)
+  TRIGGER_LEVEL  // высокий уровень на IN/TRIG (EXTTRIGLVL), спад - стоп
+};
+TriggerSource triggerSource = TRIGGER_GO;
+const uint8_t triggerPulseUs = 5;
+const uint32_t triggerHoldMs = 1000;  // уровень держим дольше любого эффекта ROM
+bool levelTriggerHigh = false;
+uint32_t levelTriggerStartMs = 0;
+uint8_t preloadedEffect = 0;  // что сейчас в WAVESEQ1, 0 - неизвестно
+
+// Задержка запуска для сравнения GO и GPIO
+struct LatencyStats {
+  uint32_t minUs = UINT32_MAX;
+  uint32_t maxUs = 0;
+  uint32_t totalUs = 0;
+  uint16_t count = 0;
+
+  void add(uint32_t us) {
+    if (us < minUs) minUs = us;
+    if (us > maxUs) maxUs = us;
+    totalUs += us;
+    count++;
+  }
+  uint32_t jitterUs() const { return maxUs - minUs; }
+};
+const uint32_t triggerWaitUs = 5000;  // дольше - запуск не дошёл до драйвера
+const uint8_t maxQueuedPlays = 8;
+uint8_t queuedPlays = 0;
+uint32_t lastGoPollUs = 0;
+
+// Частота I2C: подбирается автоматически и хранится во flash
+uint16_t savedClockFallbacks = 0;
+
+// Стоимость обмена с драйвером: все записи идут через commitRegister(),
+// все чтения - через busRead()
+uint32_t busTransactions = 0;
+uint32_t busBytes = 0;
+
+// Запись и воспроизведение сеанса настройки
+struct SessionSnapshot {
+  TapticSettings settings;
+  uint8_t retriggerPolicy;
+};
+SessionLog sessionLog;
+const char *sessionPath = "/session.bin";
+bool replayActive = false;
+SessionLog::Reader *replayCommits = nullptr;  // ожидаемые записи при воспроизведении
+uint32_t replayMismatches = 0;
+// Быстрый повтор идёт в задаче шины без пауз: вывод не успевает уходить в
+// Serial, поэтому после каждого байта ввода ждём, пока в очереди есть место
+const size_t replayOutputRoom = 2048;  // с запасом на самый длинный ответ на клавишу
+
+// Телеметрия: STATUS и пакетное чтение VBAT + LRA_PERIOD (0x21-0x22)
+Adafruit_BusIO_Register telemetryReg(&drvBus, DRV2605_REG_VBAT, 2);
+TelemetryStream telemetry;
+const uint16_t telemetryRates[] = {50, 200, 500, 1000};  // Гц
+uint8_t telemetryRateIndex = 1;
+uint32_t nextTelemetryUs = 0;
+
+// Чтение STATUS сбрасывает защёлки DIAG_RESULT, OVER_TEMP и OC_DETECT.
+// Кто бы ни прочёл регистр, эти биты копятся здесь, пока их не заберёт
+// takeStatus(), - иначе опрос телеметрии стирал бы их для остальных
+const uint8_t statusLatchMask = 0x0B;
+uint8_t statusLatched = 0;
+
+// Подстройка Frequency под резонанс мотора: после каждого эффекта читаем
+// измеренный период LRA_PERIOD (0x22) и сдвигаем частоту к нему
+bool resonanceTracking = false;
+bool resonancePending = false;
+uint32_t lastResonancePollUs = 0;
+
+// Входной контроль моторов: DIAG и (по желанию) короткая автокалибровка.
+// Цикл неблокирующий; первый опрос GO - через выученную длительность фазы
+enum DiagState {
+  DIAG_IDLE,
+  DIAG_RUNNING,     // MODE = DIAGNOS
+  DIAG_CALIBRATING  // MODE = AUTOCAL
+};
+DiagState diagState = DIAG_IDLE;
+bool diagAutocal = true;
+const uint32_t diagTimeoutUs = 2000000;
+uint32_t diagStartUs = 0;
+uint32_t diagPhaseStartUs = 0;
+uint32_t diagNextPollUs = 0;
+uint32_t diagPhaseUs[2] = {0, 0};  // последняя длительность DIAG и AUTOCAL
+uint8_t diagStatus = 0;
+uint8_t diagControl4 = 0;
+uint32_t diagParts = 0;
+uint32_t diagPassed = 0;
+uint32_t diagFirstStartMs = 0;
+uint32_t diagLastEndMs = 0;
+uint32_t diagCycleMsTotal = 0;
+
+// Результаты автокалибровки 0x18-0x1A читаются одной транзакцией
+Adafruit_BusIO_Register calResultReg(&drvBus, DRV2605_REG_AUTOCALCOMP, 3);
+
+// Теневая копия окна регистров настроек 0x16-0x20: applySettings() шлёт
+// одним пакетом только отличающийся от неё участок
+const uint8_t regWindowStart = DRV2605_REG_RATEDV;
+const uint8_t regWindowLength = DRV2605_REG_OLLRAPERIOD - DRV2605_REG_RATEDV + 1;
+DRV2605::RegisterWindow<regWindowStart, regWindowLength> regShadow;
+bool driverModeReady = false;  // MODE = playbackMode() и библиотека выбрана
+
+// A/B сравнение: образы окна для двух слотов и заранее посчитанный
+// диапазон, в котором они различаются
+TapticSettings abSlots[2];
+bool abStored[2] = {false, false};
+uint8_t abImage[2][regWindowLength];
+uint8_t abDeltaFirst = 0;
+uint8_t abDeltaLength = 0;  // 0 - слоты совпадают
+uint8_t abActive = 0;
+bool abInSync = false;  // в драйвере сейчас образ abActive
+
+// Банк пресетов: заводские + пользовательские слоты во flash
+const uint8_t userPresetCount = 8;
+const char *const userPresetNames[userPresetCount] = {
+    "Пользовательский 1", "Пользовательский 2", "Пользовательский 3", "Пользовательский 4",
+    "Пользовательский 5", "Пользовательский 6", "Пользовательский 7", "Пользовательский 8"};
+Preset userPresets[userPresetCount];
+bool userPresetStored[userPresetCount];
+const uint8_t bankSize = factoryPresetCount + userPresetCount;
+uint8_t presetIndex = presetMedium;
+
+// Морф: пошаговый переход от отмеченного пресета к выбранному
+const uint8_t morphSteps = 8;
+uint8_t morphFrom = presetSoft;
+uint8_t morphStep = 0;
+
+// Отдельные битовые поля 0x1A и 0x1C: F - выбрать поле, +/- - изменить.
+// Меняется только байт в currentSettings, на шину уйдёт один регистр.
+const DRV2605::FieldRef editableFields[] = {
+    DRV2605::fieldRef<DRV2605::Feedback::LoopGain>("LOOP_GAIN"),
+    DRV2605::fieldRef<DRV2605::Feedback::BrakeFactor>("FB_BRAKE_FACTOR"),
+    DRV2605::fieldRef<DRV2605::Feedback::BemfGain>("BEMF_GAIN"),
+    DRV2605::fieldRef<DRV2605::Control2::SampleTime>("SAMPLE_TIME"),
+    DRV2605::fieldRef<DRV2605::Control2::BlankingTime>("BLANKING_TIME"),
+    DRV2605::fieldRef<DRV2605::Control2::IdissTime>("IDISS_TIME"),
+    DRV2605::fieldRef<DRV2605::Control2::BrakeStabilizer>("BRAKE_STABILIZER"),
+    DRV2605::fieldRef<DRV2605::Control2::BidirInput>("BIDIR_INPUT")};
+const uint8_t editableFieldCount = sizeof(editableFields) / sizeof(editableFields[0]);
+uint8_t editableField = editableFieldCount;  // пока не выбрано ни одно
+
+// Тестовые сценарии: байт-код (см. ScriptVm.h) загружается строкой hex
+// после X, хранится во flash и выполняется задачей шины по R
+ScriptVm scriptVm;
+const char *scriptPath = "/script.bin";
+bool scriptUploadMode = false;
+uint8_t scriptUpload[ScriptVm::CAPACITY];
+size_t scriptUploadSize = 0;
+int16_t scriptUploadByte = -1;  // старшая тетрада, ещё ждущая младшую
+bool scriptUploadOverflow = false;
+
+// Автоподбор: стенд перебирает точки TuneOptimizer и играет эффект,
+// оценку каждого воспроизведения (больше - лучше) вводит человек или
+// присылает программа на ПК, которая меряет вибрацию сама. Байты
+// 0x1A/0x1C перебираем по полям, чтобы не задеть N_ERM_LRA и BIDIR_INPUT
+TuneOptimizer tuner;
+const DRV2605::FieldRef tuneFields[] = {
+    DRV2605::fieldRef<DRV2605::Calibration::RatedVoltage>("RATED_VOLTAGE"),
+    DRV2605::fieldRef<DRV2605::Calibration::OverdriveClamp>("OD_CLAMP"),
+    DRV2605::fieldRef<DRV2605::Calibration::Compensation>("A_CAL_COMP"),
+    DRV2605::fieldRef<DRV2605::Feedback::BrakeFactor>("FB_BRAKE_FACTOR"),
+    DRV2605::fieldRef<DRV2605::Feedback::LoopGain>("LOOP_GAIN"),
+    DRV2605::fieldRef<DRV2605::Control2::SampleTime>("SAMPLE_TIME"),
+    DRV2605::fieldRef<DRV2605::Control2::BlankingTime>("BLANKING_TIME"),
+    DRV2605::fieldRef<DRV2605::Control2::IdissTime>("IDISS_TIME")};
+const uint8_t tuneFieldCount = sizeof(tuneFields) / sizeof(tuneFields[0]);
+const uint16_t tuneBudget = 60;  // замеров на один подбор
+char tuneInput[16];
+uint8_t tuneInputLength = 0;
+
+// Замер вибрации: LIS3DH на той же шине I2C пишет 1.6 кГц в свой FIFO на
+// 32 отсчёта (20 мс), задача шины выбирает его пакетным чтением каждые
+// 5 мс. Запись начинается с запуском эффекта, кончается через 100 мс после
+// GO=0. Пока идёт автоподбор, оценку каждой точки даёт сам замер.
+// После записи БПФ в фиксированной точке даёт резонанс и гармоники
+LIS3DH_Fifo accel;
+bool accelPresent = false;
+bool vibrationMeasuring = false;
+bool vibrationCapturing = false;
+bool vibrationGoCleared = false;
+VibrationCapture vibration;
+ResonanceEstimator resonanceEstimator;
+LIS3DH_Sample accelChunk[LIS3DH_FIFO_DEPTH];
+const uint32_t accelDrainUs = 5000;
+const uint32_t vibrationGoPollUs = 10000;
+const uint32_t vibrationTailUs = 100000;  // торможение и затухание после GO=0
+uint32_t lastAccelDrainUs = 0;
+uint32_t lastVibrationGoPollUs = 0;
+uint32_t vibrationStopUs = 0;
+
+// Отмена/повтор: каждое применение настроек - шаг истории
+UndoHistory history;
+TapticSettings historyBase;  // настройки на момент последнего шага
+
+// Режим PWM/Analog: огибающую на вход IN/TRIG выдаёт LEDC, отсчёты
+// меняет esp_timer. Драйвер сглаживает ШИМ сам, шина I2C не занята.
+const uint8_t inTrigPin = 4;            // GPIO4 -> IN/TRIG
+const uint8_t pwmChannel = 0;
+const uint32_t pwmCarrierHz = 50000;    // DRV2605L принимает 10-250 kHz
+const uint8_t pwmResolutionBits = 10;   // 80 MHz / 2^10 = 78 kHz предел несущей
+const uint32_t pwmTickUs = 250;         // шаг огибающей
+uint16_t pwmTable[256];
+LedcPwmOutput pwmOutput(pwmChannel);
+PwmPlayer pwmPlayer(pwmOutput);
+esp_timer_handle_t pwmTimer = nullptr;
+bool pwmActive = false;
+uint8_t pwmControl3 = 0;  // CONTROL3 до переключения на PWM-вход
+
 // --- Объявление функций
 void processKeyInput(char cmd);
 void processDirectInput(char cmd);
@@ -37,45 +378,267 @@ void cancelDirectInput();
 void finishDirectInput();
 void printParameterName(int param);
 void setParameterValue(int param, int value);
-void applySettings();
+uint8_t applySettings(bool full = false);
 void playEffect();
 void printCurrentSettings();
-void loadPreset(int preset);
+void loadBankPreset(uint8_t index);
 void finishValueInput();
+void wakeDriver();
+void updateStandby();
+void cycleStandbyTimeout();
+void printStandbyStats();
+bool standBusy();
+void flushPendingInput(bool force = false);
+void requestPlay();
+void updatePlayback();
+void cycleRetriggerPolicy();
+void setupBusClock();
+uint32_t busClockLimit();
+void autotuneBusClock();
+void updateBusClock();
+uint32_t measureApplyUs();
+void printDecodedRegisters();
+void printField(const char *name, uint32_t value);
+void handleInput(char cmd);
+void commitRegister(uint8_t reg, uint8_t value);
+uint8_t busRead(uint8_t reg);
+uint8_t readStatus();
+uint8_t takeStatus();
+void toggleSessionRecording();
+void replaySession(bool realtime);
+uint32_t waitOutputRoom(size_t room);
+void saveSession();
+void loadSession();
+bool isSessionKey(char cmd);
+void checkReplayCommit(uint8_t reg, uint8_t value);
+void updateTelemetry();
+void sampleTelemetry(uint32_t nowUs);
+void cycleTelemetryFormat();
+void cycleTelemetryRate();
+void toggleResonanceTracking();
+void updateResonanceTracking();
+void trackResonance(uint8_t period);
+void printTenths(int32_t value);
+void startDiagnostics();
+void updateDiagnostics();
+void startDiagPhase(uint8_t mode);
+void finishDiagnostics(bool timedOut);
+void toggleDiagAutocal();
+void printDiagSummary();
+void commitRegisters(uint8_t reg, const uint8_t *values, uint8_t len);
+void buildRegisterImage(const TapticSettings &settings, uint8_t *image);
+void storeABSlot(uint8_t slot);
+void toggleAB();
+uint8_t writeRegisterWindow(const uint8_t *image, bool full);
+void readRegisterShadow();
+const Preset &bankPreset(uint8_t index);
+void browsePresets(int direction);
+void saveUserPreset();
+void loadUserPresets();
+void listPresets();
+void markMorphStart();
+void morphStepForward();
+void recordHistory();
+void undoSettings();
+void redoSettings();
+void printHistoryStep(const char *action, uint8_t changed);
+void inputTask(void *);
+void busTask(void *);
+void renderTask(void *);
+void serviceBus();
+void printTaskStats();
+void printTaskLine(TaskStats &stats, uint32_t windowUs);
+void startPwmPlayback();
+void updatePwmPlayback();
+void comparePwmRtpRates();
+uint8_t playbackMode();
+void cycleTriggerSource();
+void preloadSequence();
+void fireTrigger(bool restart);
+void updateTrigger();
+void resetTriggerPin();
+void compareTriggerLatency();
+bool waitPlaybackStart(uint32_t start, LatencyStats &stats);
+void printLatencyStats(const char *name, const LatencyStats &stats);
+uint8_t &settingsRegister(uint8_t reg);
+void startScriptUpload();
+void processScriptUpload(char cmd);
+void finishScriptUpload();
+void loadScript();
+void toggleScript();
+void updateScript();
+void selectNextField();
+bool stepField(int direction);
+void toggleTuning();
+void proposeTuningPoint();
+void processTuningInput(char cmd);
+void finishTuning();
+void toggleVibrationMeasuring();
+void startVibrationCapture();
+void updateVibrationCapture();
+uint16_t readAccelFifo();
+void drainAccel();
+void finishVibrationCapture();
 
 void setup() {
   Serial.begin(115200);
-  Serial.println("Taptic Engine Fine Tuning");
-  Serial.println("Режим клавиш: q/w g/h j/k d/f a/s l/; </>");
-  Serial.println("Режим ввода: } - начать ввод, { - отмена");
-  Serial.println("Пресеты: 1-мягкий, 2-средний, 3-сильный");
-  Serial.println("Пробел - воспроизвести эффект");
+
+  // Вывод и ввод запускаем сразу: setup() уже печатает через очередь,
+  // а нажатия до готовности стенда дождутся задачи шины в очереди ввода
+  renderStats.handle = xTaskCreateStatic(renderTask, "render", sizeof(renderTaskStack), nullptr, 1,
+                                         renderTaskStack, &renderTaskTcb);
+  inputStats.handle = xTaskCreateStatic(inputTask, "input", sizeof(inputTaskStack), nullptr, 2,
+                                        inputTaskStack, &inputTaskTcb);
+
+  console.println("Taptic Engine Fine Tuning");
+  console.println("Режим клавиш: q/w g/h j/k d/f a/s l/; </>");
+  console.println("Режим ввода: } - начать ввод, { - отмена");
+  console.println("Пресеты: 1-мягкий, 2-средний, 3-сильный");
+  console.println("Пробел - воспроизвести эффект");
+  console.println("Standby: z - таймаут, x - статистика пробуждений");
+  console.println("r - политика перезапуска эффекта, c - подбор частоты I2C");
+  console.println("v - битовые поля регистров 0x16-0x1E");
+  console.println("Сеанс: m - запись, p/P - повтор (реальное время/быстро)");
+  console.println("       y - сохранить во flash, Y - загрузить, M - выгрузить в консоль");
+  console.println("Телеметрия VBAT/LRA/STATUS: t - выкл/CSV/двоичный, T - частота опроса");
+  console.println("o - подстройка Frequency под резонанс мотора");
+  console.println("Входной контроль: i - проверить мотор, I - автокалибровка вкл/выкл, n - итог");
+  console.println("A/B: A, B - запомнить текущие настройки в слот, b - переключить и сыграть");
+  console.println("Банк пресетов: [/] - листать, S - сохранить в свой слот, L - список");
+  console.println("Морф: e - отметить начало, E - шаг к выбранному пресету");
+  console.println("u - отменить, U - повторить изменение настроек");
+  console.println("K - загрузка задач и заполнение очередей");
+  console.println("PWM/Analog: W - сыграть огибающую через LEDC, H - сравнить скорость с RTP");
+  console.println("Запуск: G - GO/фронт/уровень IN/TRIG, J - задержка и джиттер GO против GPIO");
+  console.println("Поля 0x1A/0x1C: F - выбрать (LOOP_GAIN, SAMPLE_TIME...), +/- - изменить");
+  console.println("Сценарий: X - загрузить (hex, Enter - конец, { - отмена), R - запустить/остановить");
+  console.println("O - автоподбор 0x16-0x1C: после каждого эффекта ввести оценку и Enter");
+  console.println("V - замер вибрации LIS3DH после каждого эффекта: пик, СКЗ, нарастание, спад, резонанс");
 
   if (!drv.begin()) {
-    Serial.println("DRV2605 not found");
-    while (1);
+    console.println("DRV2605 not found");
+    while (1) delay(1000);
   }
+  drvBus.begin();
+
+  accelPresent = accel.begin(LIS3DH_DEFAULT_ADDR, &Wire) &&
+                 accel.configure(LIS3DH_RATE_1600_HZ_LP, LIS3DH_RANGE_4_G);
+  if (!accelPresent) console.println("LIS3DH не найден - замер вибрации недоступен");
 
+  resetTriggerPin();
+
+  // Теневая копия нужна уже для замеров при подборе частоты
+  readRegisterShadow();
+  setupBusClock();
+  loadUserPresets();
+  loadScript();
+  historyBase = currentSettings;
   applySettings();
   printCurrentSettings();
+  lastActivityMs = millis();
+  lastTaskReportUs = micros();
+
+  busStats.handle = xTaskCreateStatic(busTask, "bus", sizeof(busTaskStack), nullptr, 3, busTaskStack,
+                                      &busTaskTcb);
 }
 
 void loop() {
-  if (Serial.available()) {
-    char cmd = Serial.read();
+  // Вся работа - в задачах, loopTask больше не нужен
+  vTaskDelete(NULL);
+}
 
-    if (directInputMode) {
-      processDirectInput(cmd);
-    } else {
-      processKeyInput(cmd);
+void inputTask(void *) {
+  for (;;) {
+    uint32_t start = micros();
+    bool received = false;
+    while (Serial.available()) {
+      // Места нет - байты ждут в приёмном буфере, дальше хост притормозит
+      // сам (управление потоком USB CDC). Нажатия не теряются
+      if (inputQueue.space() == 0) {
+        inputStalls++;
+        received = true;  // пусть шина разберёт очередь поскорее
+        break;
+      }
+      InputEvent event = {(uint32_t)micros(), (char)Serial.read()};
+      inputQueue.push(event);
+      received = true;
+    }
+
+    // Будим задачу шины сразу, не дожидаясь её тика
+    if (received && busStats.handle) xTaskNotifyGive(busStats.handle);
+    inputStats.busyUs += micros() - start;
+    vTaskDelay(1);
+  }
+}
+
+void busTask(void *) {
+  for (;;) {
+    uint32_t start = micros();
+    serviceBus();
+    busStats.busyUs += micros() - start;
+
+    // Спим до ввода или до следующего тика (телеметрия, опрос GO)
+    ulTaskNotifyTake(pdTRUE, 1);
+  }
+}
+
+void renderTask(void *) {
+  for (;;) {
+    uint32_t start = micros();
+
+    // Пишем не больше, чем свободно в буфере USB, - задача не блокируется
+    // и её загрузка честно отражает работу с текстом
+    uint8_t chunk[64];
+    size_t n = 0;
+    int room = Serial.availableForWrite();
+    while (n < sizeof(chunk) && (int)n < room && outputQueue.pop(chunk[n])) n++;
+    if (n) Serial.write(chunk, n);
+
+    renderStats.busyUs += micros() - start;
+    if (n < sizeof(chunk)) vTaskDelay(1);
+  }
+}
+
+void serviceBus() {
+  // Выбираем всё, что накопилось, чтобы серия нажатий обработалась за один проход
+  InputEvent event;
+  while (inputQueue.pop(event)) {
+    // Управление записью само в журнал не попадает
+    if (sessionLog.recording() && !(isSessionKey(event.c) && !directInputMode)) {
+      sessionLog.addInput(event.timeUs, event.c);
     }
+    handleInput(event.c);
+  }
+
+  updateScript();
+  flushPendingInput();
+  updatePlayback();
+  updateStandby();
+  updateBusClock();
+  updateTelemetry();
+  updateResonanceTracking();
+  updateDiagnostics();
+  updatePwmPlayback();
+  updateTrigger();
+  updateVibrationCapture();
+}
+
+void handleInput(char cmd) {
+  if (scriptUploadMode) {
+    processScriptUpload(cmd);
+  } else if (tuner.active()) {
+    processTuningInput(cmd);
+  } else if (directInputMode) {
+    processDirectInput(cmd);
+  } else {
+    processKeyInput(cmd);
   }
 }
 
 void processDirectInput(char cmd) {
   // Сначала выводим символ для эха
   if (cmd != '\n' && cmd != '\r' && cmd != '{') {
-    Serial.print(cmd);
+    console.print(cmd);
   }
 
   if (cmd == '\n' || cmd == '\r') {  // Enter
@@ -86,16 +649,16 @@ void processDirectInput(char cmd) {
         if (param >= 1 && param <= 7) {
           currentParameter = param;
           inputBuffer = "";
-          Serial.println();
+          console.println();
           printParameterName(param);
         } else {
-          Serial.println("\nОшибка: неверный номер параметра (1-7)");
+          console.println("\nОшибка: неверный номер параметра (1-7)");
           inputBuffer = "";
         }
       }
     } else {
       // Завершение ввода значения - всегда вызываем finishValueInput()
-      Serial.println();  // Переводим строку
+      console.println();  // Переводим строку
       finishValueInput();
     }
     return;
@@ -109,106 +672,106 @@ void processDirectInput(char cmd) {
 }
 
 void printParameterName(int param) {
-  Serial.println();
-  Serial.println("╔══════════════════════════════════════════════════════════════╗");
+  console.println();
+  console.println("╔══════════════════════════════════════════════════════════════╗");
 
   switch (param) {
     case 1:
-      Serial.println("║                 РЕДАКТИРОВАНИЕ: FEEDBACK                     ║");
-      Serial.print("║ Текущее значение: ");
-      Serial.print(currentSettings.feedbackReg);
+      console.println("║                 РЕДАКТИРОВАНИЕ: FEEDBACK                     ║");
+      console.print("║ Текущее значение: ");
+      console.print(currentSettings.feedbackReg);
 
       if (currentSettings.feedbackReg < 10)
-        Serial.print("  ");
+        console.print("  ");
       else if (currentSettings.feedbackReg < 100)
-        Serial.print(" ");
+        console.print(" ");
       else if (currentSettings.feedbackReg > 99)
-        Serial.print("");
+        console.print("");
 
-      Serial.println("                                        ║");
+      console.println("                                        ║");
       break;
     case 2:
-      Serial.println("║                 РЕДАКТИРОВАНИЕ: OVERDRIVE                    ║");
-      Serial.print("║ Текущее значение: ");
-      Serial.print(currentSettings.overdriveReg);
+      console.println("║                 РЕДАКТИРОВАНИЕ: OVERDRIVE                    ║");
+      console.print("║ Текущее значение: ");
+      console.print(currentSettings.overdriveReg);
 
       if (currentSettings.overdriveReg < 10)
-        Serial.print("  ");
+        console.print("  ");
       else if (currentSettings.overdriveReg < 100)
-        Serial.print(" ");
+        console.print(" ");
       else if (currentSettings.overdriveReg > 99)
-        Serial.print("");
+        console.print("");
 
-      Serial.println("                                        ║");
+      console.println("                                        ║");
       break;
     case 3:
-      Serial.println("║                 РЕДАКТИРОВАНИЕ: COMPENSATION                 ║");
-      Serial.print("║ Текущее значение: ");
-      Serial.print(currentSettings.compensationReg);
+      console.println("║                 РЕДАКТИРОВАНИЕ: COMPENSATION                 ║");
+      console.print("║ Текущее значение: ");
+      console.print(currentSettings.compensationReg);
 
       if (currentSettings.compensationReg < 10)
-        Serial.print("  ");
+        console.print("  ");
       else if (currentSettings.compensationReg < 100)
-        Serial.print(" ");
+        console.print(" ");
       else if (currentSettings.compensationReg > 99)
-        Serial.print("");
+        console.print("");
 
-      Serial.println("                                        ║");
+      console.println("                                        ║");
       break;
     case 4:
-      Serial.println("║                 РЕДАКТИРОВАНИЕ: DRIVE                        ║");
-      Serial.print("║ Текущее значение: ");
-      Serial.print(currentSettings.driveReg);
+      console.println("║                 РЕДАКТИРОВАНИЕ: DRIVE                        ║");
+      console.print("║ Текущее значение: ");
+      console.print(currentSettings.driveReg);
 
       if (currentSettings.driveReg < 10)
-        Serial.print("  ");
+        console.print("  ");
       else if (currentSettings.driveReg < 100)
-        Serial.print(" ");
+        console.print(" ");
       else if (currentSettings.driveReg > 99)
-        Serial.print("");
+        console.print("");
 
-      Serial.println("                                        ║");
+      console.println("                                        ║");
       break;
     case 5:
-      Serial.println("║                 РЕДАКТИРОВАНИЕ: CONTROL                      ║");
-      Serial.print("║ Текущее значение: ");
-      Serial.print(currentSettings.controlReg);
+      console.println("║                 РЕДАКТИРОВАНИЕ: CONTROL                      ║");
+      console.print("║ Текущее значение: ");
+      console.print(currentSettings.controlReg);
 
       if (currentSettings.controlReg < 10)
-        Serial.print("  ");
+        console.print("  ");
       else if (currentSettings.controlReg < 100)
-        Serial.print(" ");
+        console.print(" ");
       else if (currentSettings.controlReg > 99)
-        Serial.print("");
+        console.print("");
 
-      Serial.println("                                        ║");
+      console.println("                                        ║");
       break;
     case 6:
-      Serial.println("║                 РЕДАКТИРОВАНИЕ: FREQUENCY                    ║");
-      Serial.print("║ Текущее значение: ");
-      Serial.print(currentSettings.frequency);
-      Serial.println(" Hz                                     ║");
+      console.println("║                 РЕДАКТИРОВАНИЕ: FREQUENCY                    ║");
+      console.print("║ Текущее значение: ");
+      console.print(currentSettings.frequency);
+      console.println(" Hz                                     ║");
       break;
     case 7:
-      Serial.println("║                 РЕДАКТИРОВАНИЕ: EFFECT                       ║");
-      Serial.print("║ Текущее значение: ");
-      Serial.print(currentSettings.effect);
+      console.println("║                 РЕДАКТИРОВАНИЕ: EFFECT                       ║");
+      console.print("║ Текущее значение: ");
+      console.print(currentSettings.effect);
 
       if (currentSettings.effect < 10)
-        Serial.print("  ");
+        console.print("  ");
       else if (currentSettings.effect < 100)
-        Serial.print(" ");
+        console.print(" ");
       else if (currentSettings.effect > 99)
-        Serial.print("");
+        console.print("");
 
-      Serial.println("                                        ║");
+      console.println("                                        ║");
       break;
   }
 
-  Serial.println("╚══════════════════════════════════════════════════════════════╝");
-  Serial.println("Введите новое значение и нажмите Enter:");
-  // Serial.println("╚══════════════════════════════════════════════════════════════╝");
-  // Serial.println();
+  console.println("╚══════════════════════════════════════════════════════════════╝");
+  console.println("Введите новое значение и нажмите Enter:");
+  // console.println("╚══════════════════════════════════════════════════════════════╝");
+  // console.println();
 }
 
 void startDirectInput() {
@@ -216,110 +779,110 @@ void startDirectInput() {
   inputBuffer = "";
   currentParameter = 0;
 
-  Serial.println();
-  Serial.println("╔═══════════════════════════════════════════════════════════════╗");
-  Serial.println("║                  РЕЖИМ ПРЯМОГО ВВОДА                          ║");
-  Serial.println("╠═══════════════════════════════════════════════════════════════╣");
-  Serial.println("║ Выберите параметр для редактирования:                         ║");
-  Serial.println("║                                                               ║");
+  console.println();
+  console.println("╔═══════════════════════════════════════════════════════════════╗");
+  console.println("║                  РЕЖИМ ПРЯМОГО ВВОДА                          ║");
+  console.println("╠═══════════════════════════════════════════════════════════════╣");
+  console.println("║ Выберите параметр для редактирования:                         ║");
+  console.println("║                                                               ║");
 
-  Serial.print("║  1) Feedback     (0x1A):   ");
-  Serial.print(currentSettings.feedbackReg);
+  console.print("║  1) Feedback     (0x1A):   ");
+  console.print(currentSettings.feedbackReg);
 
   if (currentSettings.feedbackReg < 10)
-    Serial.print("       ");
+    console.print("       ");
   else if (currentSettings.feedbackReg < 100)
-    Serial.print("      ");
+    console.print("      ");
   else if (currentSettings.feedbackReg > 99)
-    Serial.print("     ");
+    console.print("     ");
 
-  Serial.print("Основной контроль мотора");
-  // if (currentSettings.feedbackReg < 10) Serial.print(" ");
-  Serial.println("   ║");
+  console.print("Основной контроль мотора");
+  // if (currentSettings.feedbackReg < 10) console.print(" ");
+  console.println("   ║");
 
-  Serial.print("║  2) Overdrive    (0x16):   ");
-  Serial.print(currentSettings.overdriveReg);
+  console.print("║  2) Overdrive    (0x16):   ");
+  console.print(currentSettings.overdriveReg);
   if (currentSettings.overdriveReg < 10)
-    Serial.print("       ");
+    console.print("       ");
   else if (currentSettings.overdriveReg < 100)
-    Serial.print("      ");
+    console.print("      ");
   else if (currentSettings.overdriveReg > 99)
-    Serial.print("     ");
-  Serial.print("Защита от перегрузки");
-  // if (currentSettings.overdriveReg < 10) Serial.print(" ");
-  Serial.println("       ║");
+    console.print("     ");
+  console.print("Защита от перегрузки");
+  // if (currentSettings.overdriveReg < 10) console.print(" ");
+  console.println("       ║");
 
-  Serial.print("║  3) Compensation (0x17):   ");
-  Serial.print(currentSettings.compensationReg);
+  console.print("║  3) Compensation (0x17):   ");
+  console.print(currentSettings.compensationReg);
 
   if (currentSettings.compensationReg < 10)
-    Serial.print("       ");
+    console.print("       ");
   else if (currentSettings.compensationReg < 100)
-    Serial.print("      ");
+    console.print("      ");
   else if (currentSettings.compensationReg > 99)
-    Serial.print("     ");
+    console.print("     ");
 
-  Serial.print("Компенсация обратной связи");
-  Serial.println(" ║");
+  console.print("Компенсация обратной связи");
+  console.println(" ║");
 
-  Serial.print("║  4) Drive        (0x18):   ");
-  Serial.print(currentSettings.driveReg);
+  console.print("║  4) Drive        (0x18):   ");
+  console.print(currentSettings.driveReg);
 
   if (currentSettings.driveReg < 10)
-    Serial.print("       ");
+    console.print("       ");
   else if (currentSettings.driveReg < 100)
-    Serial.print("      ");
+    console.print("      ");
   else if (currentSettings.driveReg > 99)
-    Serial.print("     ");
+    console.print("     ");
 
-  Serial.print("Сила вибрации (0-255)");
-  // if (currentSettings.driveReg < 10) Serial.print(" ");
-  Serial.println("      ║");
+  console.print("Сила вибрации (0-255)");
+  // if (currentSettings.driveReg < 10) console.print(" ");
+  console.println("      ║");
 
-  Serial.print("║  5) Control      (0x1C):   ");
-  Serial.print(currentSettings.controlReg);
+  console.print("║  5) Control      (0x1C):   ");
+  console.print(currentSettings.controlReg);
 
   if (currentSettings.controlReg < 10)
-    Serial.print("       ");
+    console.print("       ");
   else if (currentSettings.controlReg < 100)
-    Serial.print("      ");
+    console.print("      ");
   else if (currentSettings.controlReg > 99)
-    Serial.print("     ");
+    console.print("     ");
 
-  Serial.print("Форма сигнала");
-  // if (currentSettings.controlReg < 10) Serial.print(" ");
-  Serial.println("              ║");
+  console.print("Форма сигнала");
+  // if (currentSettings.controlReg < 10) console.print(" ");
+  console.println("              ║");
 
-  Serial.print("║  6) Frequency          :   ");
-  Serial.print(currentSettings.frequency);
-  Serial.print(" Hz  Резонансная частота");
-  Serial.println("        ║");
+  console.print("║  6) Frequency          :   ");
+  console.print(currentSettings.frequency);
+  console.print(" Hz  Резонансная частота");
+  console.println("        ║");
 
-  Serial.print("║  7) Effect             :   ");
-  Serial.print(currentSettings.effect);
+  console.print("║  7) Effect             :   ");
+  console.print(currentSettings.effect);
 
   if (currentSettings.effect < 10)
-    Serial.print("       ");
+    console.print("       ");
   else if (currentSettings.effect < 100)
-    Serial.print("      ");
+    console.print("      ");
   else if (currentSettings.effect > 99)
-    Serial.print("     ");
-
-  Serial.print("Тип эффекта 1-117");
-  if (currentSettings.effect < 10) Serial.print("");
-  Serial.println("          ║");
-
-  Serial.println("╠══════════════════════════════════════════════╦════════════════╣");
-  Serial.println("║ Введите номер параметра (1-7) и нажмите      ║      Enter     ║");
-  Serial.println("╟----------------------------------------------╫----------------╢");
-  Serial.println("║ Для выхода в обычный режим нажмите           ║        {       ║");
-  Serial.println("╚══════════════════════════════════════════════╩════════════════╝");
-  Serial.println();
+    console.print("     ");
+
+  console.print("Тип эффекта 1-117");
+  if (currentSettings.effect < 10) console.print("");
+  console.println("          ║");
+
+  console.println("╠══════════════════════════════════════════════╦════════════════╣");
+  console.println("║ Введите номер параметра (1-7) и нажмите      ║      Enter     ║");
+  console.println("╟----------------------------------------------╫----------------╢");
+  console.println("║ Для выхода в обычный режим нажмите           ║        {       ║");
+  console.println("╚══════════════════════════════════════════════╩════════════════╝");
+  console.println();
 }
 
 void cancelDirectInput() {
   directInputMode = false;
-  Serial.println("\nВыход в обычный режим.");
+  console.println("\nВыход в обычный режим.");
   printCurrentSettings();
 }
 
@@ -332,9 +895,9 @@ void finishValueInput() {
   int value = inputBuffer.toInt();
   setParameterValue(currentParameter, value);
 
-  Serial.println("Значение применено!");
+  console.println("Значение применено!");
   applySettings();
-  playEffect();
+  requestPlay();
 
   // Сбрасываем для выбора нового параметра
   currentParameter = 0;
@@ -382,10 +945,10 @@ void processKeyInput(char cmd) {
 
     // Частота и эффекты
     case ';':
-      currentSettings.frequency++;
+      if (currentSettings.frequency < 300) currentSettings.frequency++;
       break;  // Частота +
     case 'l':
-      currentSettings.frequency--;
+      if (currentSettings.frequency > 100) currentSettings.frequency--;
       break;  // Частота -
     case '.':
       currentSettings.effect++;
@@ -396,6 +959,17 @@ void processKeyInput(char cmd) {
       if (currentSettings.effect < 1) currentSettings.effect = 1;
       break;  // Эффект -
 
+    // Битовые поля
+    case '+':
+      if (!stepField(1)) return;
+      break;
+    case '-':
+      if (!stepField(-1)) return;
+      break;
+    case 'F':
+      selectNextField();
+      return;
+
     // Режим прямого ввода
     case '}':
       startDirectInput();
@@ -406,27 +980,176 @@ void processKeyInput(char cmd) {
 
     // Быстрые пресеты
     case '1':
-      loadPreset(1);
+      loadBankPreset(presetSoft);
       break;  // Мягкий
     case '2':
-      loadPreset(2);
+      loadBankPreset(presetMedium);
       break;  // Средний
     case '3':
-      loadPreset(3);
+      loadBankPreset(presetStrong);
       break;  // Сильный
+    case '[':
+      browsePresets(-1);
+      break;
+    case ']':
+      browsePresets(1);
+      break;
 
     // Воспроизведение
     case ' ':
-      playEffect();
       break;
 
+    // Standby
+    case 'z':
+      cycleStandbyTimeout();
+      return;
+    case 'x':
+      printStandbyStats();
+      return;
+
+    case 'r':
+      cycleRetriggerPolicy();
+      return;
+    case 'c':
+      autotuneBusClock();
+      return;
+    case 'v':
+      printDecodedRegisters();
+      return;
+
+    // Запись и повтор сеанса
+    case 'm':
+      toggleSessionRecording();
+      return;
+    case 'p':
+      replaySession(true);
+      return;
+    case 'P':
+      replaySession(false);
+      return;
+    case 'y':
+      saveSession();
+      return;
+    case 'Y':
+      loadSession();
+      return;
+    case 'M':
+      sessionLog.dump(console);
+      return;
+
+    case 't':
+      cycleTelemetryFormat();
+      return;
+    case 'T':
+      cycleTelemetryRate();
+      return;
+    case 'o':
+      toggleResonanceTracking();
+      return;
+
+    // Входной контроль
+    case 'i':
+      startDiagnostics();
+      return;
+    case 'I':
+      toggleDiagAutocal();
+      return;
+    case 'n':
+      printDiagSummary();
+      return;
+
+    // A/B сравнение
+    case 'A':
+      storeABSlot(0);
+      return;
+    case 'B':
+      storeABSlot(1);
+      return;
+    case 'b':
+      toggleAB();
+      return;
+
+    // Банк пресетов и морф
+    case 'S':
+      saveUserPreset();
+      return;
+    case 'L':
+      listPresets();
+      return;
+    case 'e':
+      markMorphStart();
+      return;
+    case 'E':
+      morphStepForward();
+      return;
+
+    // История
+    case 'u':
+      undoSettings();
+      return;
+    case 'U':
+      redoSettings();
+      return;
+
+    case 'K':
+      printTaskStats();
+      return;
+
+    // PWM/Analog
+    case 'W':
+      startPwmPlayback();
+      return;
+    case 'H':
+      comparePwmRtpRates();
+      return;
+
+    // Внешний запуск
+    case 'G':
+      cycleTriggerSource();
+      return;
+    case 'J':
+      compareTriggerLatency();
+      return;
+
+    // Сценарии
+    case 'X':
+      startScriptUpload();
+      return;
+    case 'R':
+      toggleScript();
+      return;
+
+    case 'O':
+      toggleTuning();
+      return;
+    case 'V':
+      toggleVibrationMeasuring();
+      return;
+
     default:
       return;  // Игнорируем другие символы
   }
 
+  // Применение откладывается до паузы во вводе - см. flushPendingInput()
+  pendingInput = true;
+  lastInputMs = millis();
+}
+
+bool standBusy() {
+  // Проверка мотора, PWM-огибающая и сценарий сами ведут драйвер: MODE, RTP и
+  // регистры настроек заняты, чужие записи на шину ждут их окончания
+  return diagState != DIAG_IDLE || pwmActive || scriptVm.running();
+}
+
+void flushPendingInput(bool force) {
+  // Пока стенд занят, изменения применим после
+  if (!pendingInput || standBusy()) return;
+  if (!force && millis() - lastInputMs < inputCoalesceMs) return;
+
+  pendingInput = false;
   applySettings();
   printCurrentSettings();
-  playEffect();
+  requestPlay();
 }
 
 void finishDirectInput() {
@@ -436,11 +1159,11 @@ void finishDirectInput() {
     if (param >= 1 && param <= 7) {
       currentParameter = param;
       inputBuffer = "";
-      Serial.println();
+      console.println();
       printParameterName(param);
-      Serial.println("Введите новое значение:");
+      console.println("Введите новое значение:");
     } else {
-      Serial.println("\nОшибка: неверный номер параметра (1-7)");
+      console.println("\nОшибка: неверный номер параметра (1-7)");
       cancelDirectInput();
     }
   } else {
@@ -448,10 +1171,10 @@ void finishDirectInput() {
     int value = inputBuffer.toInt();
     setParameterValue(currentParameter, value);
     directInputMode = false;
-    Serial.println();
-    applySettings();
-    printCurrentSettings();
-    playEffect();
+    console.println();
+    // Через отложенное применение: если стенд занят, значение запишется после
+    pendingInput = true;
+    flushPendingInput(true);
   }
 }
 
@@ -481,139 +1204,1878 @@ void setParameterValue(int param, int value) {
   }
 }
 
-void applySettings() {
-  drv.setMode(DRV2605_MODE_INTTRIG);
-  drv.selectLibrary(1);
+uint8_t applySettings(bool full) {
+  wakeDriver();
+  recordHistory();
+  abInSync = false;
+  if (full || !driverModeReady) {
+    commitRegister(DRV2605_REG_MODE, playbackMode());
+    commitRegister(DRV2605_REG_LIBRARY, 1);
+    driverModeReady = true;
+  }
+
+  uint8_t image[regWindowLength];
+  memcpy(image, regShadow.bytes, regWindowLength);
+  buildRegisterImage(currentSettings, image);
+  uint8_t sent = writeRegisterWindow(image, full);
+
+  // Во внешних режимах эффект загружаем сразу, чтобы запуск был только импульсом
+  if (triggerSource != TRIGGER_GO) preloadSequence();
+  return sent;
+}
+
+uint8_t writeRegisterWindow(const uint8_t *image, bool full) {
+  // Один пакет от первого до последнего отличающегося регистра:
+  // совпадающие регистры в середине дешевле переслать, чем начинать
+  // новую транзакцию
+  uint8_t first = 0, last = regWindowLength - 1;
+  if (!full) {
+    while (first < regWindowLength && image[first] == regShadow.bytes[first]) first++;
+    if (first == regWindowLength) return 0;
+    while (image[last] == regShadow.bytes[last]) last--;
+  }
+
+  uint8_t length = last - first + 1;
+  commitRegisters(regWindowStart + first, image + first, length);
+  return length;
+}
 
-  drv.writeRegister8(0x1A, currentSettings.feedbackReg);
-  drv.writeRegister8(0x16, currentSettings.overdriveReg);
-  drv.writeRegister8(0x17, currentSettings.compensationReg);
-  drv.writeRegister8(0x18, currentSettings.driveReg);
-  drv.writeRegister8(0x1C, currentSettings.controlReg);
-  drv.writeRegister8(0x20, currentSettings.frequency);
+void readRegisterShadow() {
+  busTransactions++;
+  busBytes += 3 + regWindowLength;
+  drv.readRegisters(regWindowStart, regShadow.bytes, regWindowLength);
 }
 
 void playEffect() {
-  drv.setWaveform(0, currentSettings.effect);
-  drv.setWaveform(1, 0);
-  drv.go();
-  Serial.println("Playing effect...");
+  wakeDriver();
+  if (triggerSource == TRIGGER_GO) {
+    commitRegister(DRV2605_REG_WAVESEQ1, currentSettings.effect);
+    commitRegister(DRV2605_REG_WAVESEQ2, 0);
+    preloadedEffect = currentSettings.effect;
+  } else {
+    preloadSequence();
+  }
+  startVibrationCapture();
+  fireTrigger(false);
+  if (resonanceTracking) resonancePending = true;
+
+  if (wakeLatencyPending) {
+    // Запись GO или фронт - ещё не вибрация: ждём, пока эффект пойдёт
+    LatencyStats wake;
+    if (waitPlaybackStart(wakeStartUs, wake)) {
+      lastWakeLatencyUs = wake.maxUs;
+      if (lastWakeLatencyUs > maxWakeLatencyUs) maxWakeLatencyUs = lastWakeLatencyUs;
+    }
+    wakeLatencyPending = false;
+  }
+
+  console.println("Playing effect...");
 }
 
-void printCurrentSettings() {
-  Serial.println();
-  Serial.println("╔══════════════════════════════════════════════════════════════════════════════════════════════════════╗");
-  Serial.println("║                                           ТЕКУЩИЕ НАСТРОЙКИ                                          ║");
-  Serial.println("╠══════════════════════════════════════════════════════════════════════════════════════════════════════╣");
-
-  Serial.print("║ 1) Feedback      (0x1A)  |  q/w  |  ");
-  Serial.print(currentSettings.feedbackReg);
-  if (currentSettings.feedbackReg < 100) Serial.print(" ");
-  if (currentSettings.feedbackReg < 10) Serial.print(" ");
-  Serial.print(" (0x");
-  if (currentSettings.feedbackReg < 16) Serial.print("0");
-  Serial.print(currentSettings.feedbackReg, HEX);
-  Serial.print(")");
-  Serial.print("  |  Основной контроль: тип мотора и режим работы");
-  Serial.println("      ║");
-
-  Serial.print("║ 2) Overdrive     (0x16)  |  g/h  |  ");
-  Serial.print(currentSettings.overdriveReg);
-  if (currentSettings.overdriveReg < 100) Serial.print(" ");
-  if (currentSettings.overdriveReg < 10) Serial.print(" ");
-  Serial.print(" (0x");
-  if (currentSettings.overdriveReg < 16) Serial.print("0");
-  Serial.print(currentSettings.overdriveReg, HEX);
-  Serial.print(")");
-  Serial.print("  |  Защита от перегрузки: чем выше, тем безопаснее");
-  Serial.println("    ║");
-
-  Serial.print("║ 3) Compensation  (0x17)  |  j/k  |  ");
-  Serial.print(currentSettings.compensationReg);
-  if (currentSettings.compensationReg < 100) Serial.print(" ");
-  if (currentSettings.compensationReg < 10) Serial.print(" ");
-  Serial.print(" (0x");
-  if (currentSettings.compensationReg < 16) Serial.print("0");
-  Serial.print(currentSettings.compensationReg, HEX);
-  Serial.print(")");
-  Serial.print("  |  Компенсация: для стабильной работы мотора");
-  Serial.println("         ║");
-
-  Serial.print("║ 4) Drive         (0x18)  |  d/f  |  ");
-  Serial.print(currentSettings.driveReg);
-  if (currentSettings.driveReg < 100) Serial.print(" ");
-  if (currentSettings.driveReg < 10) Serial.print(" ");
-  Serial.print(" (0x");
-  if (currentSettings.driveReg < 16) Serial.print("0");
-  Serial.print(currentSettings.driveReg, HEX);
-  Serial.print(")");
-  Serial.print("  |  Усиление: 0-255, прямо влияет на силу вибрации");
-  Serial.println("    ║");
-
-  Serial.print("║ 5) Control       (0x1C)  |  a/s  |  ");
-  Serial.print(currentSettings.controlReg);
-  if (currentSettings.controlReg < 100) Serial.print(" ");
-  if (currentSettings.controlReg < 10) Serial.print(" ");
-  Serial.print(" (0x");
-  if (currentSettings.controlReg < 16) Serial.print("0");
-  Serial.print(currentSettings.controlReg, HEX);
-  Serial.print(")");
-  Serial.print("  |  Форма сигнала: влияет на резкость и отклик");
-  Serial.println("        ║");
-
-  Serial.print("║ 6) Frequency             |  l/;  |  ");
-  Serial.print(currentSettings.frequency);
-  Serial.print(" Hz      |  Резонансная частота: ДОЛЖНА совпадать с мотором!");
-   Serial.println("  ║");
-
-  Serial.print("║ 7) Effect                |  </>  |  ");
-  Serial.print(currentSettings.effect);
-  Serial.print("          |  Тип эффект");
-   Serial.println("                                        ║");
-
-  Serial.println("╠══════════════════╦══════════════╦════════════════════════════════════════════════════════════════════╣");
-  Serial.println("║ прямой ввод - }  ║  отмена - {  ║  воспроизвести -  ПРОБЕЛ                                           ║");
-  Serial.println("╚══════════════════╩══════════════╩════════════════════════════════════════════════════════════════════╝");
-  Serial.println();
-  Serial.println("┌──────────────────────────────────────────────────────┐");
-  Serial.println("|                 Советы по настройке:                 |");
-  Serial.println("├──────────────────────────────────────────────────────┤");
-  Serial.println("| 1) Увеличить силу: повысить Drive и Feedback         |");
-  Serial.println("| 2) Сделать мягче: уменьшить Drive, эффект 12 или 14  |");
-  Serial.println("| 3) Быстрее отклик: увеличить Control                 |");
-  Serial.println("| 4) Стабильнее: настроить Compensation                |");
-  Serial.println("| 5) Пресеты: 1=мягкий, 2=средний, 3=сильный           |");
-  Serial.println("└──────────────────────────────────────────────────────┘");
-  Serial.println();
-}
-
-void loadPreset(int preset) {
-  switch (preset) {
-    case 1:  // Мягкий пресет
-      currentSettings.feedbackReg = 0x86;
-      currentSettings.controlReg = 0x10;
-      currentSettings.driveReg = 0x04;
-      currentSettings.effect = 12;
-      currentSettings.overdriveReg = 0x80;
-      currentSettings.compensationReg = 0x15;
-      break;
-
-    case 2:  // Средний пресет
-      currentSettings.feedbackReg = 0x93;
-      currentSettings.controlReg = 0x20;
-      currentSettings.driveReg = 0x06;
-      currentSettings.effect = 14;
-      currentSettings.overdriveReg = 0x83;
-      currentSettings.compensationReg = 0x1A;
-      break;
-
-    case 3:  // Сильный пресет
-      currentSettings.feedbackReg = 0xA0;
-      currentSettings.controlReg = 0x30;
-      currentSettings.driveReg = 0x08;
-      currentSettings.effect = 37;
-      currentSettings.overdriveReg = 0x83;
-      currentSettings.compensationReg = 0x1A;
-      break;
-  }
-}
\ No newline at end of file
+void requestPlay() {
+  if (driverInStandby) {
+    // После standby эффект точно не играет
+    playEffect();
+    return;
+  }
+
+  bool playing = busRead(DRV2605_REG_GO) & 0x01;
+  if (!playing) {
+    queuedPlays = 0;
+    playEffect();
+    return;
+  }
+
+  switch (retriggerPolicy) {
+    case RETRIGGER_RESTART:
+      commitRegister(DRV2605_REG_GO, 0);
+      playEffect();
+      break;
+    case RETRIGGER_QUEUE:
+      if (queuedPlays < maxQueuedPlays) queuedPlays++;
+      break;
+    case RETRIGGER_LATEST:
+      queuedPlays = 1;
+      break;
+  }
+}
+
+void updatePlayback() {
+  if (queuedPlays == 0 || standBusy()) return;
+
+  // Опрашиваем GO не чаще раза в 2 мс, чтобы не забивать шину
+  if (micros() - lastGoPollUs < 2000) return;
+  lastGoPollUs = micros();
+
+  if (busRead(DRV2605_REG_GO) & 0x01) return;
+
+  queuedPlays--;
+  playEffect();
+}
+
+void cycleRetriggerPolicy() {
+  switch (retriggerPolicy) {
+    case RETRIGGER_RESTART:
+      retriggerPolicy = RETRIGGER_QUEUE;
+      console.println("Перезапуск: очередь (играть все запросы по порядку)");
+      break;
+    case RETRIGGER_QUEUE:
+      retriggerPolicy = RETRIGGER_LATEST;
+      console.println("Перезапуск: после окончания - только последний запрос");
+      break;
+    case RETRIGGER_LATEST:
+      retriggerPolicy = RETRIGGER_RESTART;
+      console.println("Перезапуск: сразу (остановить текущий эффект)");
+      break;
+  }
+  queuedPlays = 0;
+}
+
+void setupBusClock() {
+  prefs.begin("stand", false);
+  uint32_t clk = min(prefs.getUInt("i2cclk", 0), busClockLimit());
+
+  // Сохранённую частоту только перепроверяем, полный подбор - если она не прошла
+  if (clk != 0 && drv.probeClock(clk)) {
+    console.print("I2C: ");
+    console.print(clk / 1000);
+    console.println(" kHz (сохранено)");
+    return;
+  }
+  autotuneBusClock();
+}
+
+uint32_t busClockLimit() {
+  // Частота общая для всей шины: LIS3DH держит только fast mode (400 kHz),
+  // даже если драйверу разрешить больше. Сохранённую частоту тоже режем -
+  // её могли подобрать до того, как датчик подключили
+  const uint32_t accelMaxClock = 400000;
+  return accelPresent ? min(accelMaxClock, (uint32_t)DRV2605_I2C_FAST_MODE) : DRV2605_I2C_FAST_MODE;
+}
+
+void autotuneBusClock() {
+  // Подбор гоняет по шине свои шаблоны и применяет настройки - только на свободном стенде
+  if (standBusy()) {
+    console.println("I2C: стенд занят, подбор частоты отменён");
+    return;
+  }
+  wakeDriver();
+
+  drv.setClock(100000);
+  uint32_t slowUs = measureApplyUs();
+
+  uint32_t clk = drv.autotuneClock(busClockLimit());
+  uint32_t fastUs = measureApplyUs();
+  prefs.putUInt("i2cclk", clk);
+  savedClockFallbacks = drv.clockFallbacks();
+
+  console.print("I2C: ");
+  console.print(clk / 1000);
+  console.print(" kHz | применение настроек: ");
+  console.print(slowUs);
+  console.print(" мкс на 100 kHz -> ");
+  console.print(fastUs);
+  console.println(" мкс");
+}
+
+void updateBusClock() {
+  // Драйвер сам понижает частоту после серии NACK - запоминаем новое значение
+  if (drv.clockFallbacks() == savedClockFallbacks) return;
+  savedClockFallbacks = drv.clockFallbacks();
+  prefs.putUInt("i2cclk", drv.clock());
+
+  console.print("I2C: ошибки шины, частота снижена до ");
+  console.print(drv.clock() / 1000);
+  console.println(" kHz");
+}
+
+uint32_t measureApplyUs() {
+  uint32_t start = micros();
+  applySettings(true);
+  return micros() - start;
+}
+
+void printDecodedRegisters() {
+  // applySettings() пишет мимо кэша, поэтому перечитываем весь блок
+  uint32_t startTransactions = drvConfig.transactions();
+  drvConfig.invalidate();
+  if (!drvConfig.fetch()) {
+    console.println("Ошибка чтения регистров");
+    return;
+  }
+
+  console.println("Feedback (0x1A):");
+  printField("N_ERM_LRA", fbErmLra.read());
+  printField("FB_BRAKE_FACTOR", fbBrakeFactor.read());
+  printField("LOOP_GAIN", fbLoopGain.read());
+  printField("BEMF_GAIN", fbBemfGain.read());
+  console.println("Control1 (0x1B):");
+  printField("STARTUP_BOOST", c1StartupBoost.read());
+  printField("DRIVE_TIME", c1DriveTime.read());
+  console.println("Control2 (0x1C):");
+  printField("BRAKE_STABILIZER", c2BrakeStabilizer.read());
+  printField("SAMPLE_TIME", c2SampleTime.read());
+  printField("BLANKING_TIME", c2BlankingTime.read());
+  printField("IDISS_TIME", c2IdissTime.read());
+  console.println("Control3 (0x1D):");
+  printField("ERM_OPEN_LOOP", c3ErmOpenLoop.read());
+  printField("LRA_OPEN_LOOP", c3LraOpenLoop.read());
+
+  console.print("Транзакций I2C: ");
+  console.println(drvConfig.transactions() - startTransactions);
+}
+
+void printField(const char *name, uint32_t value) {
+  console.print("  ");
+  console.print(name);
+  console.print(" = ");
+  console.println(value);
+}
+
+void commitRegister(uint8_t reg, uint8_t value) {
+  drv.writeRegister8(reg, value);
+  busTransactions++;
+  busBytes += 3;  // адрес, регистр, значение
+
+  if (regShadow.contains(reg)) regShadow[reg] = value;
+  if (reg == DRV2605_REG_MODE && value != playbackMode()) driverModeReady = false;
+
+  if (sessionLog.recording()) sessionLog.addCommit(micros(), reg, value);
+  if (replayCommits) checkReplayCommit(reg, value);
+}
+
+void commitRegisters(uint8_t reg, const uint8_t *values, uint8_t len) {
+  drv.writeRegisters(reg, values, len);
+  busTransactions++;
+  busBytes += 2 + len;  // адрес, первый регистр, значения
+
+  for (uint8_t i = 0; i < len; i++) {
+    uint8_t r = reg + i;
+    if (regShadow.contains(r)) regShadow[r] = values[i];
+    if (sessionLog.recording()) sessionLog.addCommit(micros(), reg + i, values[i]);
+    if (replayCommits) checkReplayCommit(reg + i, values[i]);
+  }
+}
+
+uint8_t busRead(uint8_t reg) {
+  busTransactions++;
+  busBytes += 4;  // адрес, регистр, повторный старт с адресом, значение
+  return drv.readRegister8(reg);
+}
+
+bool isSessionKey(char cmd) {
+  return cmd == 'm' || cmd == 'p' || cmd == 'P' || cmd == 'y' || cmd == 'Y' || cmd == 'M';
+}
+
+void toggleSessionRecording() {
+  if (replayActive) return;
+
+  if (sessionLog.recording()) {
+    sessionLog.stop();
+    console.print("Запись остановлена: ");
+    console.print(sessionLog.events());
+    console.print(" событий, ");
+    console.print((uint32_t)sessionLog.size());
+    console.print(" байт, ");
+    console.print(sessionLog.durationUs() / 1000);
+    console.println(" мс");
+    return;
+  }
+
+  // Повтор начинается с того же состояния, что и запись
+  flushPendingInput(true);
+  SessionSnapshot snapshot = {currentSettings, (uint8_t)retriggerPolicy};
+  sessionLog.start(micros(), &snapshot, sizeof(snapshot));
+  console.println("Запись сеанса... (m - стоп)");
+}
+
+void checkReplayCommit(uint8_t reg, uint8_t value) {
+  SessionEvent event;
+  while (replayCommits->next(event)) {
+    if (event.type != SESSION_COMMIT) continue;
+    if (event.reg != reg || event.value != value) replayMismatches++;
+    return;
+  }
+  replayMismatches++;  // записей больше, чем в журнале
+}
+
+void replaySession(bool realtime) {
+  if (replayActive) return;
+  if (sessionLog.recording()) toggleSessionRecording();
+
+  SessionLog::Reader reader(sessionLog);
+  SessionEvent event;
+  if (!reader.next(event) || event.type != SESSION_SNAPSHOT || event.length != sizeof(SessionSnapshot)) {
+    console.println("Журнал сеанса пуст");
+    return;
+  }
+
+  // Восстанавливаем исходное состояние - это в стоимость не входит
+  SessionSnapshot snapshot;
+  memcpy(&snapshot, event.data, sizeof(snapshot));
+  currentSettings = snapshot.settings;
+  retriggerPolicy = (RetriggerPolicy)snapshot.retriggerPolicy;
+  directInputMode = false;
+  currentParameter = 0;
+  inputBuffer = "";
+  pendingInput = false;
+  queuedPlays = 0;
+  applySettings(true);
+
+  SessionLog::Reader expected(sessionLog);
+  replayActive = true;
+  replayCommits = &expected;
+  replayMismatches = 0;
+  uint32_t startTransactions = busTransactions;
+  uint32_t startBusBytes = busBytes;
+  uint32_t startConsoleBytes = console.bytes;
+  uint32_t inputs = 0;
+  uint32_t lastInputUs = 0;
+  uint32_t outputWaitUs = 0;  // ожидание вывода в стоимость не входит
+  bool aborted = false;
+
+  uint32_t startUs = micros();
+  while (reader.next(event)) {
+    if (event.type != SESSION_INPUT) continue;
+
+    if (realtime) {
+      // Любой байт с консоли прерывает повтор
+      while (micros() - startUs < event.timeUs && !aborted) {
+        InputEvent key;
+        aborted = inputQueue.pop(key);
+        flushPendingInput();
+        updatePlayback();
+        updateTelemetry();
+        // Долгие паузы отдаём задачам ввода и вывода
+        if (event.timeUs - (micros() - startUs) > 2000) vTaskDelay(1);
+      }
+      if (aborted) break;
+    } else if (event.timeUs - lastInputUs >= inputCoalesceMs * 1000) {
+      // Без ожидания склейку ввода воспроизводим по отметкам времени журнала
+      flushPendingInput(true);
+      updatePlayback();
+    }
+
+    handleInput(event.reg);
+    lastInputUs = event.timeUs;
+    inputs++;
+    if (!realtime) outputWaitUs += waitOutputRoom(replayOutputRoom);
+  }
+
+  if (realtime && !aborted) {
+    while (micros() - startUs < sessionLog.durationUs()) {
+      flushPendingInput();
+      updatePlayback();
+      updateTelemetry();
+      if (sessionLog.durationUs() - (micros() - startUs) > 2000) vTaskDelay(1);
+    }
+  }
+  flushPendingInput(true);
+  uint32_t elapsedUs = micros() - startUs - outputWaitUs;
+
+  // Записи, которых так и не было, тоже считаются расхождением
+  while (expected.next(event)) {
+    if (event.type == SESSION_COMMIT) replayMismatches++;
+  }
+  replayCommits = nullptr;
+  replayActive = false;
+
+  waitOutputRoom(replayOutputRoom);
+  console.println();
+  console.print(aborted ? "Повтор прерван: " : "Повтор сеанса: ");
+  console.print(inputs);
+  console.print(" байт ввода, ");
+  console.print(sessionLog.durationUs() / 1000);
+  console.print(" мс записи -> ");
+  console.print(elapsedUs / 1000);
+  console.println(" мс");
+  console.print("I2C: ");
+  console.print(busTransactions - startTransactions);
+  console.print(" транзакций, ");
+  console.print(busBytes - startBusBytes);
+  console.print(" байт | вывод: ");
+  console.print(console.bytes - startConsoleBytes);
+  console.print(" байт | расхождений записей: ");
+  console.println(replayMismatches);
+}
+
+uint32_t waitOutputRoom(size_t room) {
+  // Задача вывода ниже приоритетом: пока ждём, она разбирает очередь
+  uint32_t startUs = micros();
+  while (outputQueue.space() < room) vTaskDelay(1);
+  return micros() - startUs;
+}
+
+void saveSession() {
+  if (sessionLog.size() == 0) {
+    console.println("Журнал сеанса пуст");
+    return;
+  }
+  if (!LittleFS.begin(true) || !sessionLog.save(LittleFS, sessionPath)) {
+    console.println("Ошибка записи журнала во flash");
+    return;
+  }
+  console.print("Журнал сохранён: ");
+  console.print((uint32_t)sessionLog.size());
+  console.println(" байт");
+}
+
+void loadSession() {
+  if (sessionLog.recording()) toggleSessionRecording();
+  if (!LittleFS.begin(true) || !sessionLog.load(LittleFS, sessionPath)) {
+    console.println("Журнал во flash не найден или повреждён");
+    return;
+  }
+  console.print("Журнал загружен: ");
+  console.print(sessionLog.events());
+  console.print(" событий, ");
+  console.print(sessionLog.durationUs() / 1000);
+  console.println(" мс");
+}
+
+void updateTelemetry() {
+  if (telemetry.format() == TELEMETRY_OFF) return;
+
+  uint32_t periodUs = 1000000UL / telemetryRates[telemetryRateIndex];
+  // Сценарий снимает телеметрию сам (TELEMETRY), фоновый опрос сбил бы его тайминг
+  uint32_t now = micros();
+  if ((int32_t)(now - nextTelemetryUs) >= 0 && !scriptVm.running()) {
+    sampleTelemetry(now);
+    nextTelemetryUs += periodUs;
+    // После долгой блокировки (вывод меню) не догоняем пачкой отсчётов
+    if ((int32_t)(now - nextTelemetryUs) >= 0) nextTelemetryUs = now + periodUs;
+  }
+
+  // Пишем только то, что помещается в буфер передачи, иначе loop() встанет
+  telemetry.drain(console, console.availableForWrite());
+}
+
+void sampleTelemetry(uint32_t nowUs) {
+  // Опрос не будит драйвер: в standby шина и регистры доступны
+  uint8_t status = readStatus();
+
+  uint8_t values[2];
+  busTransactions++;
+  busBytes += 5;  // адрес, регистр, повторный старт с адресом, 2 значения
+  if (!telemetryReg.read(values, 2)) return;
+
+  telemetry.push(nowUs, status, values[0], values[1]);
+}
+
+uint8_t readStatus() {
+  uint8_t status = busRead(DRV2605_REG_STATUS);
+  statusLatched |= status & statusLatchMask;
+  return status;
+}
+
+uint8_t takeStatus() {
+  uint8_t status = readStatus() | statusLatched;
+  statusLatched = 0;
+  return status;
+}
+
+void cycleTelemetryFormat() {
+  switch (telemetry.format()) {
+    case TELEMETRY_OFF:
+      telemetry.setFormat(TELEMETRY_CSV);
+      console.println("# seq,t_us,status,vbat_mv,period_us,hz");
+      break;
+    case TELEMETRY_CSV:
+      telemetry.setFormat(TELEMETRY_BINARY);
+      console.println("# двоичные записи: A5 seq16 t32 status vbat period xor");
+      break;
+    case TELEMETRY_BINARY:
+      telemetry.setFormat(TELEMETRY_OFF);
+      console.println();
+      console.print("Телеметрия выключена: отсчётов ");
+      console.print(telemetry.samples());
+      console.print(", потеряно ");
+      console.println(telemetry.dropped());
+      return;
+  }
+  nextTelemetryUs = micros();
+}
+
+void cycleTelemetryRate() {
+  telemetryRateIndex++;
+  if (telemetryRateIndex >= sizeof(telemetryRates) / sizeof(telemetryRates[0])) telemetryRateIndex = 0;
+
+  console.print("# частота телеметрии: ");
+  console.print(telemetryRates[telemetryRateIndex]);
+  console.println(" Гц");
+}
+
+void toggleResonanceTracking() {
+  resonanceTracking = !resonanceTracking;
+  resonancePending = false;
+  console.println(resonanceTracking ? "Подстройка резонанса: вкл (после каждого эффекта)"
+                                    : "Подстройка резонанса: выкл");
+}
+
+void updateResonanceTracking() {
+  if (!resonancePending) return;
+
+  // Ждём окончания последнего эффекта, опрос GO - не чаще раза в 2 мс
+  if (micros() - lastResonancePollUs < 2000) return;
+  lastResonancePollUs = micros();
+  if (queuedPlays || (busRead(DRV2605_REG_GO) & 0x01)) return;
+
+  resonancePending = false;
+  trackResonance(busRead(DRV2605_REG_LRARESON));
+}
+
+void trackResonance(uint8_t period) {
+  int32_t measured10 = lraHz10(period);
+  if (measured10 == 0) {
+    console.println("Резонанс не измерен: LRA_PERIOD обновляется только в замкнутом контуре");
+    return;
+  }
+
+  int32_t error10 = measured10 - (int32_t)currentSettings.frequency * 10;
+  console.print("Резонанс: ");
+  printTenths(measured10);
+  console.print(" Гц | Frequency: ");
+  console.print(currentSettings.frequency);
+  console.print(" Гц (в 0x20: ");
+  printTenths(lraHz10(olLraPeriodFromHz(currentSettings.frequency)));
+  console.print(" Гц) | ошибка: ");
+  if (error10 > 0) console.print("+");
+  printTenths(error10);
+  console.print(" Гц");
+
+  if (abs(error10) < 10) {
+    console.println(" - совпадает");
+    return;
+  }
+
+  // Шаг в половину ошибки: период измеряется с шумом, перелёт раскачал бы подстройку
+  int32_t step10 = error10 / 2;
+  int32_t step = (step10 + (step10 > 0 ? 5 : -5)) / 10;
+  if (step == 0) step = error10 > 0 ? 1 : -1;
+  currentSettings.frequency = constrain((int32_t)currentSettings.frequency + step, 100, 300);
+
+  commitRegister(DRV2605_REG_OLLRAPERIOD, olLraPeriodFromHz(currentSettings.frequency));
+  recordHistory();
+  abInSync = false;
+  console.print(" -> ");
+  console.print(currentSettings.frequency);
+  console.println(" Гц");
+}
+
+void printTenths(int32_t value) {
+  if (value < 0) {
+    console.print("-");
+    value = -value;
+  }
+  console.print(value / 10);
+  console.print(".");
+  console.print(value % 10);
+}
+
+void startDiagnostics() {
+  if (standBusy()) return;
+
+  wakeDriver();
+  diagStartUs = micros();
+  diagStatus = 0;
+  takeStatus();  // защёлки до запуска к этой детали не относятся
+  if (diagParts == 0) {
+    diagFirstStartMs = millis();
+    console.println("# part,result,diag_status,cal_status,comp,bemf,bemf_gain,lra_hz,vbat_mv,cycle_ms");
+  }
+
+  if (diagAutocal) {
+    // Короткая автокалибровка: AUTO_CAL_TIME = 150 мс, CONTROL4 вернём после
+    diagControl4 = busRead(DRV2605_REG_CONTROL4);
+    commitRegister(DRV2605_REG_CONTROL4, DRV2605::Control4::AutoCalTime::with(diagControl4, 0));
+  }
+
+  diagState = DIAG_RUNNING;
+  startDiagPhase(DRV2605_MODE_DIAGNOS);
+}
+
+void startDiagPhase(uint8_t mode) {
+  commitRegister(DRV2605_REG_MODE, mode);
+  commitRegister(DRV2605_REG_GO, 1);
+
+  // Раньше выученной длительности фазы GO не опрашиваем
+  uint8_t phase = mode == DRV2605_MODE_AUTOCAL;
+  diagPhaseStartUs = micros();
+  diagNextPollUs = diagPhaseStartUs + diagPhaseUs[phase] * 9 / 10;
+}
+
+void updateDiagnostics() {
+  if (diagState == DIAG_IDLE) return;
+
+  uint32_t now = micros();
+  if ((int32_t)(now - diagNextPollUs) < 0) return;
+  diagNextPollUs = now + 2000;
+
+  if (busRead(DRV2605_REG_GO) & 0x01) {
+    if (now - diagPhaseStartUs > diagTimeoutUs) finishDiagnostics(true);
+    return;
+  }
+
+  uint8_t phase = diagState == DIAG_CALIBRATING;
+  diagPhaseUs[phase] = now - diagPhaseStartUs;
+
+  if (diagState == DIAG_RUNNING) {
+    // Автокалибровка перезапишет DIAG_RESULT - забираем его сразу
+    diagStatus = takeStatus();
+    if (diagAutocal && !(diagStatus & 0x0B)) {
+      diagState = DIAG_CALIBRATING;
+      startDiagPhase(DRV2605_MODE_AUTOCAL);
+      return;
+    }
+  }
+  finishDiagnostics(false);
+}
+
+void finishDiagnostics(bool timedOut) {
+  bool calibrated = diagState == DIAG_CALIBRATING && !timedOut;
+  uint8_t calStatus = calibrated ? takeStatus() : 0;
+
+  // DIAG_RESULT (бит 3), OVER_TEMP (бит 1), OC_DETECT (бит 0)
+  bool pass = !timedOut && !(diagStatus & 0x0B) && !(calStatus & 0x0B);
+
+  uint8_t cal[3] = {0, 0, 0};
+  uint8_t supply[2] = {0, 0};
+  if (calibrated) {
+    busTransactions++;
+    busBytes += 6;
+    calResultReg.read(cal, 3);
+  }
+  if (!timedOut) {
+    busTransactions++;
+    busBytes += 5;
+    telemetryReg.read(supply, 2);
+  }
+
+  // Возвращаем стенд в рабочий режим с настройками пользователя.
+  // Автокалибровка сама переписала 0x18-0x1A - перечитываем теневую копию
+  if (diagAutocal) commitRegister(DRV2605_REG_CONTROL4, diagControl4);
+  if (calibrated || timedOut) readRegisterShadow();
+  diagState = DIAG_IDLE;
+  applySettings();
+
+  uint32_t cycleMs = (micros() - diagStartUs) / 1000;
+  diagParts++;
+  if (pass) diagPassed++;
+  diagLastEndMs = millis();
+  diagCycleMsTotal += cycleMs;
+
+  console.print("D,");
+  console.print(diagParts);
+  console.print(pass ? ",PASS," : (timedOut ? ",TIMEOUT," : ",FAIL,"));
+  if (diagStatus < 16) console.print("0");
+  console.print(diagStatus, HEX);
+  console.print(",");
+  if (calibrated) {
+    if (calStatus < 16) console.print("0");
+    console.print(calStatus, HEX);
+    console.print(",");
+    console.print(cal[0]);
+    console.print(",");
+    console.print(cal[1]);
+    console.print(",");
+    console.print(cal[2] & 0x03);
+  } else {
+    console.print("-,-,-,-");
+  }
+  console.print(",");
+  printTenths(lraHz10(supply[1]));
+  console.print(",");
+  console.print(vbatMillivolts(supply[0]));
+  console.print(",");
+  console.println(cycleMs);
+}
+
+void toggleDiagAutocal() {
+  diagAutocal = !diagAutocal;
+  console.println(diagAutocal ? "Входной контроль: DIAG + автокалибровка" : "Входной контроль: только DIAG");
+}
+
+void printDiagSummary() {
+  if (diagParts == 0) {
+    console.println("Входной контроль: моторов ещё не проверяли");
+    return;
+  }
+
+  // Темп считаем по всей смене: от первого старта до последнего результата,
+  // с учётом времени на замену мотора
+  uint32_t spanMs = diagLastEndMs - diagFirstStartMs;
+  uint32_t ppm10 = spanMs ? (uint64_t)diagParts * 600000 / spanMs : 0;
+
+  console.print("Проверено: ");
+  console.print(diagParts);
+  console.print(" | годных: ");
+  console.print(diagPassed);
+  console.print(" | брак: ");
+  console.print(diagParts - diagPassed);
+  console.print(" | цикл: ");
+  console.print(diagCycleMsTotal / diagParts);
+  console.print(" мс | темп: ");
+  printTenths(ppm10);
+  console.println(ppm10 >= 200 ? " шт/мин (цель > 20 выполнена)" : " шт/мин (цель > 20 не выполнена)");
+
+  diagParts = 0;
+  diagPassed = 0;
+  diagCycleMsTotal = 0;
+}
+
+void buildRegisterImage(const TapticSettings &settings, uint8_t *image) {
+  image[DRV2605_REG_RATEDV - regWindowStart] = settings.overdriveReg;
+  image[DRV2605_REG_CLAMPV - regWindowStart] = settings.compensationReg;
+  image[DRV2605_REG_AUTOCALCOMP - regWindowStart] = settings.driveReg;
+  image[DRV2605_REG_FEEDBACK - regWindowStart] = settings.feedbackReg;
+  image[DRV2605_REG_CONTROL2 - regWindowStart] = settings.controlReg;
+  image[DRV2605_REG_OLLRAPERIOD - regWindowStart] = olLraPeriodFromHz(settings.frequency);
+}
+
+void storeABSlot(uint8_t slot) {
+  flushPendingInput(true);
+  abSlots[slot] = currentSettings;
+  abStored[slot] = true;
+
+  // Регистры окна, которые стенд не настраивает (0x19, 0x1B, 0x1D-0x1F),
+  // берём из теневой копии, чтобы пакетная запись их не портила
+  for (uint8_t i = 0; i < 2; i++) {
+    memcpy(abImage[i], regShadow.bytes, regWindowLength);
+    buildRegisterImage(abSlots[i], abImage[i]);
+  }
+
+  // Разница между слотами считается один раз, переключение шлёт только её
+  abDeltaLength = 0;
+  if (abStored[0] && abStored[1]) {
+    int first = -1, last = -1;
+    for (uint8_t i = 0; i < regWindowLength; i++) {
+      if (abImage[0][i] == abImage[1][i]) continue;
+      if (first < 0) first = i;
+      last = i;
+    }
+    if (first >= 0) {
+      abDeltaFirst = first;
+      abDeltaLength = last - first + 1;
+    }
+  }
+
+  // Текущие настройки уже в драйвере
+  abActive = slot;
+  abInSync = true;
+
+  console.print("Слот ");
+  console.print(slot ? "B" : "A");
+  console.print(" сохранён");
+  if (abStored[0] && abStored[1] && abDeltaLength == 0) {
+    console.print(" | слоты совпадают");
+  } else if (abStored[0] && abStored[1]) {
+    console.print(" | разница: ");
+    console.print(abDeltaLength);
+    console.print(" байт с 0x");
+    console.print(regWindowStart + abDeltaFirst, HEX);
+  }
+  console.println();
+}
+
+void toggleAB() {
+  if (!abStored[0] || !abStored[1]) {
+    console.println("A/B: сначала сохраните оба слота (A и B)");
+    return;
+  }
+  if (standBusy()) return;
+
+  uint32_t startUs = micros();
+  uint32_t startTransactions = busTransactions;
+  wakeDriver();
+  pendingInput = false;
+  queuedPlays = 0;
+
+  // Из известного состояния шлём только разницу, иначе - всё окно одним пакетом
+  uint8_t target = abInSync ? 1 - abActive : 0;
+  uint8_t previousEffect = abInSync ? abSlots[abActive].effect : 0;
+  if (abInSync) {
+    if (abDeltaLength) commitRegisters(regWindowStart + abDeltaFirst, abImage[target] + abDeltaFirst, abDeltaLength);
+  } else {
+    if (!driverModeReady) {
+      commitRegister(DRV2605_REG_MODE, playbackMode());
+      commitRegister(DRV2605_REG_LIBRARY, 1);
+      driverModeReady = true;
+    }
+    writeRegisterWindow(abImage[target], false);
+  }
+  currentSettings = abSlots[target];
+  recordHistory();
+  abActive = target;
+  abInSync = true;
+
+  // Сразу играем: останавливаем текущий эффект и перезапускаем GO
+  if (currentSettings.effect != previousEffect) {
+    uint8_t sequence[2] = {currentSettings.effect, 0};
+    commitRegisters(DRV2605_REG_WAVESEQ1, sequence, 2);
+    preloadedEffect = currentSettings.effect;
+  }
+  fireTrigger(true);
+  uint32_t latencyUs = micros() - startUs;
+
+  console.print("A/B: ");
+  console.print(target ? "B" : "A");
+  console.print(" | транзакций: ");
+  console.print(busTransactions - startTransactions);
+  console.print(" | до GO: ");
+  console.print(latencyUs);
+  console.println(" мкс");
+}
+
+void recordHistory() {
+  history.record(historyBase, currentSettings);
+  historyBase = currentSettings;
+}
+
+void undoSettings() {
+  if (standBusy()) return;
+
+  // Ещё не применённая серия нажатий становится отдельным шагом - его и
+  // отменяем, в драйвер она так и не попадёт
+  if (pendingInput) {
+    pendingInput = false;
+    recordHistory();
+  }
+  if (!history.undo(currentSettings)) {
+    console.println("Отменять нечего");
+    return;
+  }
+  historyBase = currentSettings;
+  uint8_t changed = applySettings();
+  requestPlay();
+  printHistoryStep("Отмена", changed);
+}
+
+void redoSettings() {
+  if (standBusy()) return;
+
+  // Новые правки отменяют возможность повтора, как и в любом редакторе.
+  // Записанный шаг сразу уходит в драйвер, иначе он разойдётся с настройками
+  bool flushed = pendingInput;
+  if (pendingInput) {
+    pendingInput = false;
+    applySettings();
+    printCurrentSettings();
+  }
+  if (!history.redo(currentSettings)) {
+    if (flushed) requestPlay();
+    console.println("Повторять нечего");
+    return;
+  }
+  historyBase = currentSettings;
+  uint8_t changed = applySettings();
+  requestPlay();
+  printHistoryStep("Повтор", changed);
+}
+
+void printHistoryStep(const char *action, uint8_t changed) {
+  console.print(action);
+  console.print(" | регистров: ");
+  console.print(changed);
+  console.print(" | назад: ");
+  console.print(history.undoSteps());
+  console.print(", вперёд: ");
+  console.print(history.redoSteps());
+  console.print(" | история: ");
+  console.print(history.bytesUsed());
+  console.println(" байт");
+}
+
+void printTaskStats() {
+  // Загрузка - за время с прошлого отчёта
+  uint32_t now = micros();
+  uint32_t windowUs = now - lastTaskReportUs;
+  lastTaskReportUs = now;
+  if (windowUs == 0) return;
+
+  printTaskLine(busStats, windowUs);
+  printTaskLine(inputStats, windowUs);
+  printTaskLine(renderStats, windowUs);
+
+  console.print("Очередь ввода: макс ");
+  console.print((uint32_t)inputQueue.highWater());
+  console.print("/");
+  console.print((uint32_t)inputQueue.capacity());
+  console.print(", ожиданий места ");
+  console.println(inputStalls);
+  console.print("Очередь вывода: макс ");
+  console.print((uint32_t)outputQueue.highWater());
+  console.print("/");
+  console.print((uint32_t)outputQueue.capacity());
+  console.print(", потеряно ");
+  console.println(console.dropped);
+}
+
+void printTaskLine(TaskStats &stats, uint32_t windowUs) {
+  uint32_t busy = stats.busyUs;
+  uint32_t cpu10 = (uint64_t)(busy - stats.reportedBusyUs) * 1000 / windowUs;
+  stats.reportedBusyUs = busy;
+
+  console.print("Задача ");
+  console.print(stats.name);
+  console.print(": ");
+  printTenths(cpu10);
+  console.print("% | свободно стека: ");
+  console.print((uint32_t)uxTaskGetStackHighWaterMark(stats.handle));
+  console.println(" байт");
+}
+
+void wakeDriver() {
+  lastActivityMs = millis();
+  if (!driverInStandby) return;
+
+  // Регистры в standby сохраняются - достаточно снять бит STANDBY.
+  // Режим известен (playbackMode()), поэтому пишем MODE сразу, без чтения.
+  wakeStartUs = micros();
+  commitRegister(DRV2605_REG_MODE, playbackMode());
+  driverInStandby = false;
+  wakeLatencyPending = true;
+  wakeCount++;
+}
+
+void updateStandby() {
+  uint32_t timeout = standbyTimeouts[standbyTimeoutIndex];
+  if (driverInStandby || timeout == 0 || pendingInput || queuedPlays || standBusy()) return;
+  if (millis() - lastActivityMs < timeout) return;
+
+  // Не усыпляем драйвер посреди воспроизведения
+  if (busRead(DRV2605_REG_GO) & 0x01) {
+    lastActivityMs = millis();
+    return;
+  }
+
+  drv.standby(true);
+  driverInStandby = true;
+  driverModeReady = false;
+}
+
+void cycleStandbyTimeout() {
+  standbyTimeoutIndex++;
+  if (standbyTimeoutIndex >= sizeof(standbyTimeouts) / sizeof(standbyTimeouts[0])) standbyTimeoutIndex = 0;
+  lastActivityMs = millis();
+
+  console.print("Standby через: ");
+  if (standbyTimeouts[standbyTimeoutIndex] == 0) {
+    console.println("выключен");
+  } else {
+    console.print(standbyTimeouts[standbyTimeoutIndex] / 1000);
+    console.println(" с");
+  }
+}
+
+void printStandbyStats() {
+  console.print("Standby: ");
+  console.print(driverInStandby ? "да" : "нет");
+  console.print(" | пробуждений: ");
+  console.print(wakeCount);
+  console.print(" | задержка до вибрации: ");
+  console.print(lastWakeLatencyUs);
+  console.print(" мкс (макс ");
+  console.print(maxWakeLatencyUs);
+  console.println(" мкс)");
+}
+
+void printCurrentSettings() {
+  console.println();
+  console.println("╔══════════════════════════════════════════════════════════════════════════════════════════════════════╗");
+  console.println("║                                           ТЕКУЩИЕ НАСТРОЙКИ                                          ║");
+  console.println("╠══════════════════════════════════════════════════════════════════════════════════════════════════════╣");
+
+  console.print("║ 1) Feedback      (0x1A)  |  q/w  |  ");
+  console.print(currentSettings.feedbackReg);
+  if (currentSettings.feedbackReg < 100) console.print(" ");
+  if (currentSettings.feedbackReg < 10) console.print(" ");
+  console.print(" (0x");
+  if (currentSettings.feedbackReg < 16) console.print("0");
+  console.print(currentSettings.feedbackReg, HEX);
+  console.print(")");
+  console.print("  |  Основной контроль: тип мотора и режим работы");
+  console.println("      ║");
+
+  console.print("║ 2) Overdrive     (0x16)  |  g/h  |  ");
+  console.print(currentSettings.overdriveReg);
+  if (currentSettings.overdriveReg < 100) console.print(" ");
+  if (currentSettings.overdriveReg < 10) console.print(" ");
+  console.print(" (0x");
+  if (currentSettings.overdriveReg < 16) console.print("0");
+  console.print(currentSettings.overdriveReg, HEX);
+  console.print(")");
+  console.print("  |  Защита от перегрузки: чем выше, тем безопаснее");
+  console.println("    ║");
+
+  console.print("║ 3) Compensation  (0x17)  |  j/k  |  ");
+  console.print(currentSettings.compensationReg);
+  if (currentSettings.compensationReg < 100) console.print(" ");
+  if (currentSettings.compensationReg < 10) console.print(" ");
+  console.print(" (0x");
+  if (currentSettings.compensationReg < 16) console.print("0");
+  console.print(currentSettings.compensationReg, HEX);
+  console.print(")");
+  console.print("  |  Компенсация: для стабильной работы мотора");
+  console.println("         ║");
+
+  console.print("║ 4) Drive         (0x18)  |  d/f  |  ");
+  console.print(currentSettings.driveReg);
+  if (currentSettings.driveReg < 100) console.print(" ");
+  if (currentSettings.driveReg < 10) console.print(" ");
+  console.print(" (0x");
+  if (currentSettings.driveReg < 16) console.print("0");
+  console.print(currentSettings.driveReg, HEX);
+  console.print(")");
+  console.print("  |  Усиление: 0-255, прямо влияет на силу вибрации");
+  console.println("    ║");
+
+  console.print("║ 5) Control       (0x1C)  |  a/s  |  ");
+  console.print(currentSettings.controlReg);
+  if (currentSettings.controlReg < 100) console.print(" ");
+  if (currentSettings.controlReg < 10) console.print(" ");
+  console.print(" (0x");
+  if (currentSettings.controlReg < 16) console.print("0");
+  console.print(currentSettings.controlReg, HEX);
+  console.print(")");
+  console.print("  |  Форма сигнала: влияет на резкость и отклик");
+  console.println("        ║");
+
+  console.print("║ 6) Frequency             |  l/;  |  ");
+  console.print(currentSettings.frequency);
+  console.print(" Hz      |  Резонансная частота: ДОЛЖНА совпадать с мотором!");
+   console.println("  ║");
+
+  console.print("║ 7) Effect                |  </>  |  ");
+  console.print(currentSettings.effect);
+  console.print("          |  Тип эффект");
+   console.println("                                        ║");
+
+  console.println("╠══════════════════╦══════════════╦════════════════════════════════════════════════════════════════════╣");
+  console.println("║ прямой ввод - }  ║  отмена - {  ║  воспроизвести -  ПРОБЕЛ                                           ║");
+  console.println("╚══════════════════╩══════════════╩════════════════════════════════════════════════════════════════════╝");
+  console.println();
+  console.println("┌──────────────────────────────────────────────────────┐");
+  console.println("|                 Советы по настройке:                 |");
+  console.println("├──────────────────────────────────────────────────────┤");
+  console.println("| 1) Увеличить силу: повысить Drive и Feedback         |");
+  console.println("| 2) Сделать мягче: уменьшить Drive, эффект 12 или 14  |");
+  console.println("| 3) Быстрее отклик: увеличить Control                 |");
+  console.println("| 4) Стабильнее: настроить Compensation                |");
+  console.println("| 5) Пресеты: 1=мягкий, 2=средний, 3=сильный           |");
+  console.println("└──────────────────────────────────────────────────────┘");
+  console.println();
+}
+
+void loadBankPreset(uint8_t index) {
+  if (index >= factoryPresetCount && !userPresetStored[index - factoryPresetCount]) return;
+
+  presetIndex = index;
+  applyPreset(bankPreset(index), currentSettings);
+  console.print("Пресет ");
+  console.print(index + 1);
+  console.print("/");
+  console.print(bankSize);
+  console.print(": ");
+  console.println(bankPreset(index).name);
+}
+
+const Preset &bankPreset(uint8_t index) {
+  if (index < factoryPresetCount) return factoryPresets[index];
+  return userPresets[index - factoryPresetCount];
+}
+
+void browsePresets(int direction) {
+  // Пустые пользовательские слоты пропускаем
+  uint8_t index = presetIndex;
+  for (uint8_t i = 0; i < bankSize; i++) {
+    index = (index + bankSize + direction) % bankSize;
+    if (index < factoryPresetCount || userPresetStored[index - factoryPresetCount]) break;
+  }
+  loadBankPreset(index);
+}
+
+void loadUserPresets() {
+  for (uint8_t i = 0; i < userPresetCount; i++) {
+    char key[8] = "user0";
+    key[4] = '0' + i;
+
+    uint8_t data[6] = {0, 0, 0, 0, 0, 0};
+    userPresetStored[i] = prefs.getBytes(key, data, sizeof(data)) == sizeof(data);
+    userPresets[i] = {userPresetNames[i], data[0], data[1], data[2], data[3], data[4], data[5]};
+  }
+}
+
+void saveUserPreset() {
+  // На пользовательском слоте - перезаписываем его, иначе берём первый свободный
+  int slot = -1;
+  if (presetIndex >= factoryPresetCount) {
+    slot = presetIndex - factoryPresetCount;
+  } else {
+    for (uint8_t i = 0; i < userPresetCount && slot < 0; i++) {
+      if (!userPresetStored[i]) slot = i;
+    }
+  }
+  if (slot < 0) {
+    console.println("Свободных слотов нет: выберите пользовательский слот ([/]) для перезаписи");
+    return;
+  }
+
+  flushPendingInput(true);
+  capturePreset(currentSettings, userPresets[slot]);
+  userPresetStored[slot] = true;
+
+  char key[8] = "user0";
+  key[4] = '0' + slot;
+  const Preset &preset = userPresets[slot];
+  uint8_t data[6] = {preset.feedbackReg, preset.controlReg, preset.driveReg,
+                     preset.effect, preset.overdriveReg, preset.compensationReg};
+  prefs.putBytes(key, data, sizeof(data));
+
+  presetIndex = factoryPresetCount + slot;
+  console.print("Сохранено: ");
+  console.println(preset.name);
+}
+
+void listPresets() {
+  for (uint8_t i = 0; i < bankSize; i++) {
+    bool stored = i < factoryPresetCount || userPresetStored[i - factoryPresetCount];
+    console.print(i == presetIndex ? "> " : "  ");
+    if (i < 9) console.print(" ");
+    console.print(i + 1);
+    console.print(". ");
+    console.print(bankPreset(i).name);
+    if (!stored) console.print(" (пусто)");
+    console.println();
+  }
+}
+
+void markMorphStart() {
+  morphFrom = presetIndex;
+  morphStep = 0;
+  console.print("Морф: начало - ");
+  console.println(bankPreset(morphFrom).name);
+}
+
+void morphStepForward() {
+  if (standBusy()) return;
+
+  // После последнего шага начинаем проход заново
+  morphStep = morphStep >= morphSteps ? 0 : morphStep + 1;
+  morphPresets(bankPreset(morphFrom), bankPreset(presetIndex), morphStep, morphSteps, currentSettings);
+
+  pendingInput = false;
+  uint8_t changed = applySettings();
+  requestPlay();
+
+  console.print("Морф ");
+  console.print(morphStep);
+  console.print("/");
+  console.print(morphSteps);
+  console.print(": ");
+  console.print(bankPreset(morphFrom).name);
+  console.print(" -> ");
+  console.print(bankPreset(presetIndex).name);
+  console.print(" | отправлено регистров: ");
+  console.println(changed);
+}
+
+void pwmTimerCallback(void *) {
+  pwmPlayer.tick();
+}
+
+void startPwmPlayback() {
+  if (standBusy()) return;
+
+  if (!pwmTimer) {
+    esp_timer_create_args_t args = {};
+    args.callback = pwmTimerCallback;
+    args.name = "pwm";
+    if (esp_timer_create(&args, &pwmTimer) != ESP_OK) {
+      console.println("PWM: не удалось создать таймер");
+      return;
+    }
+  }
+  if (!pwmOutput.begin(inTrigPin, pwmCarrierHz, pwmResolutionBits)) {
+    console.println("PWM: не удалось настроить LEDC");
+    return;
+  }
+
+  // При BIDIR_INPUT нулевая амплитуда - 50 % скважности, иначе 0 %
+  uint16_t zeroDuty = DRV2605::Control2::BidirInput::get(currentSettings.controlReg) ? 1 << (pwmResolutionBits - 1) : 0;
+  uint16_t peakDuty = (1 << pwmResolutionBits) - 1;
+  uint16_t length = buildEnvelope(pwmTable, sizeof(pwmTable) / sizeof(pwmTable[0]), 20, 80, 120, zeroDuty,
+                                  peakDuty);
+  pwmOutput.write(zeroDuty);
+
+  // Ещё не применённые нажатия применяем до смены режима
+  flushPendingInput(true);
+  wakeDriver();
+  pwmControl3 = regShadow[DRV2605_REG_CONTROL3];
+  commitRegister(DRV2605_REG_CONTROL3, DRV2605::Control3::PwmAnalog::with(pwmControl3, DRV2605::InputMode::PWM));
+  commitRegister(DRV2605_REG_MODE, DRV2605_MODE_PWMANALOG);
+
+  pwmActive = true;
+  pwmPlayer.start(pwmTable, length, zeroDuty);
+  esp_timer_start_periodic(pwmTimer, pwmTickUs);
+
+  console.print("PWM: огибающая ");
+  console.print(length);
+  console.print(" отсчётов по ");
+  console.print(pwmTickUs);
+  console.print(" мкс, несущая ");
+  console.print(pwmCarrierHz / 1000);
+  console.println(" kHz");
+}
+
+void updatePwmPlayback() {
+  if (!pwmActive || pwmPlayer.playing()) return;
+
+  // Огибающая доиграна: возвращаем внутренний запуск
+  esp_timer_stop(pwmTimer);
+  pwmOutput.end();
+  resetTriggerPin();
+  pwmActive = false;
+  commitRegister(DRV2605_REG_CONTROL3, pwmControl3);
+  applySettings();
+
+  console.print("PWM: готово, тиков таймера ");
+  console.println(pwmPlayer.ticks());
+}
+
+void comparePwmRtpRates() {
+  if (standBusy()) return;
+
+  // Отсчёт амплитуды через RTP - запись регистра по I2C. RTP_INPUT = 0,
+  // чтобы мотор молчал: длительность записи от значения не зависит.
+  const uint16_t updates = 200;
+  flushPendingInput(true);
+  wakeDriver();
+  commitRegister(DRV2605_REG_MODE, DRV2605_MODE_REALTIME);
+  uint32_t start = micros();
+  for (uint16_t i = 0; i < updates; i++) commitRegister(DRV2605_REG_RTPIN, 0);
+  uint32_t rtpUs = micros() - start;
+  applySettings();
+
+  // Через LEDC - запись регистра скважности; новое значение аппаратура
+  // защёлкивает раз в период несущей, поэтому выше её частоты не выйти
+  uint32_t ledcUs = 0;
+  if (pwmOutput.begin(inTrigPin, pwmCarrierHz, pwmResolutionBits)) {
+    start = micros();
+    for (uint16_t i = 0; i < updates; i++) pwmOutput.write(0);
+    ledcUs = micros() - start;
+    pwmOutput.end();
+    resetTriggerPin();
+  }
+
+  // Частоты в десятых kHz
+  uint32_t rtpRate = rtpUs ? (uint32_t)updates * 10000 / rtpUs : 0;
+  uint32_t ledcRate = ledcUs ? (uint32_t)updates * 10000 / ledcUs : pwmCarrierHz / 100;
+  if (ledcRate > pwmCarrierHz / 100) ledcRate = pwmCarrierHz / 100;
+
+  console.print("RTP (I2C ");
+  console.print(drv.clock() / 1000);
+  console.print(" kHz): ");
+  printTenths(rtpUs * 10 / updates);
+  console.print(" мкс на отсчёт, до ");
+  printTenths(rtpRate);
+  console.println(" kHz");
+  console.print("LEDC: ");
+  printTenths(ledcUs * 10 / updates);
+  console.print(" мкс на запись, до ");
+  printTenths(ledcRate);
+  console.println(" kHz (ограничение - несущая)");
+}
+
+uint8_t playbackMode() {
+  switch (triggerSource) {
+    case TRIGGER_EDGE:
+      return DRV2605_MODE_EXTTRIGEDGE;
+    case TRIGGER_LEVEL:
+      return DRV2605_MODE_EXTTRIGLVL;
+    default:
+      return DRV2605_MODE_INTTRIG;
+  }
+}
+
+void cycleTriggerSource() {
+  if (standBusy()) return;
+
+  switch (triggerSource) {
+    case TRIGGER_GO:
+      triggerSource = TRIGGER_EDGE;
+      console.println("Запуск: фронт на IN/TRIG (GPIO4)");
+      break;
+    case TRIGGER_EDGE:
+      triggerSource = TRIGGER_LEVEL;
+      console.println("Запуск: уровень на IN/TRIG (GPIO4), спад останавливает эффект");
+      break;
+    case TRIGGER_LEVEL:
+      triggerSource = TRIGGER_GO;
+      console.println("Запуск: запись GO по I2C");
+      break;
+  }
+  resetTriggerPin();
+  queuedPlays = 0;
+
+  // Новый MODE и предзагрузку пишет applySettings()
+  driverModeReady = false;
+  flushPendingInput(true);
+  applySettings();
+}
+
+void preloadSequence() {
+  if (preloadedEffect == currentSettings.effect) return;
+  uint8_t sequence[2] = {currentSettings.effect, 0};
+  commitRegisters(DRV2605_REG_WAVESEQ1, sequence, 2);
+  preloadedEffect = currentSettings.effect;
+}
+
+void fireTrigger(bool restart) {
+  switch (triggerSource) {
+    case TRIGGER_GO:
+      if (restart) commitRegister(DRV2605_REG_GO, 0);
+      commitRegister(DRV2605_REG_GO, 1);
+      break;
+    case TRIGGER_EDGE:
+      if (restart) commitRegister(DRV2605_REG_GO, 0);
+      digitalWrite(inTrigPin, HIGH);
+      delayMicroseconds(triggerPulseUs);
+      digitalWrite(inTrigPin, LOW);
+      break;
+    case TRIGGER_LEVEL:
+      // GO повторяет вход: для перезапуска нужен спад и новый фронт
+      if (levelTriggerHigh) {
+        digitalWrite(inTrigPin, LOW);
+        delayMicroseconds(triggerPulseUs);
+      }
+      digitalWrite(inTrigPin, HIGH);
+      levelTriggerHigh = true;
+      levelTriggerStartMs = millis();
+      break;
+  }
+}
+
+void updateTrigger() {
+  if (!levelTriggerHigh || millis() - levelTriggerStartMs < triggerHoldMs) return;
+  digitalWrite(inTrigPin, LOW);
+  levelTriggerHigh = false;
+}
+
+void resetTriggerPin() {
+  // В режиме INTTRIG драйвер вход не смотрит, поэтому низкий уровень держим всегда
+  pinMode(inTrigPin, OUTPUT);
+  digitalWrite(inTrigPin, LOW);
+  levelTriggerHigh = false;
+}
+
+void printLatencyStats(const char *name, const LatencyStats &stats) {
+  console.print(name);
+  if (stats.count == 0) {
+    console.println(": запуск не замечен");
+    return;
+  }
+  console.print(": мин ");
+  console.print(stats.minUs);
+  console.print(" / ср ");
+  console.print(stats.totalUs / stats.count);
+  console.print(" / макс ");
+  console.print(stats.maxUs);
+  console.print(" мкс, джиттер ");
+  console.print(stats.jitterUs());
+  console.println(stats.jitterUs() < 100 ? " мкс (< 100)" : " мкс (>= 100!)");
+}
+
+bool waitPlaybackStart(uint32_t start, LatencyStats &stats) {
+  // Эффект пошёл, когда драйвер взвёл GO: от фронта на IN/TRIG - сам.
+  // Таймаут считается от вызова: start может быть сильно раньше (побудка)
+  uint32_t waitStart = micros();
+  do {
+    if (busRead(DRV2605_REG_GO) & 0x01) {
+      stats.add(micros() - start);
+      return true;
+    }
+  } while (micros() - waitStart < triggerWaitUs);
+  return false;
+}
+
+void compareTriggerLatency() {
+  if (standBusy()) return;
+
+  // Время от решения играть до замеченного начала эффекта (GO = 1 при
+  // опросе сразу после запуска) - в обоих путях есть одно чтение GO.
+  // Играет текущий эффект, его сразу гасим GO = 0: мотор лишь дёргается
+  const uint8_t trials = 50;
+  flushPendingInput(true);
+  wakeDriver();
+  queuedPlays = 0;
+  resetTriggerPin();
+  preloadSequence();
+
+  LatencyStats go, gpio;
+  commitRegister(DRV2605_REG_MODE, DRV2605_MODE_INTTRIG);
+  for (uint8_t i = 0; i < trials; i++) {
+    uint32_t start = micros();
+    commitRegister(DRV2605_REG_GO, 1);
+    waitPlaybackStart(start, go);
+    commitRegister(DRV2605_REG_GO, 0);
+  }
+
+  commitRegister(DRV2605_REG_MODE, DRV2605_MODE_EXTTRIGEDGE);
+  for (uint8_t i = 0; i < trials; i++) {
+    uint32_t start = micros();
+    digitalWrite(inTrigPin, HIGH);
+    waitPlaybackStart(start, gpio);
+    digitalWrite(inTrigPin, LOW);
+    commitRegister(DRV2605_REG_GO, 0);
+    delayMicroseconds(triggerPulseUs);
+  }
+  applySettings();
+
+  console.print("I2C ");
+  console.print(drv.clock() / 1000);
+  console.print(" kHz, попыток ");
+  console.print(trials);
+  console.println(", до GO = 1 в драйвере");
+  printLatencyStats("GO (I2C)", go);
+  printLatencyStats("GPIO IN/TRIG", gpio);
+  // Фронт ни разу не взвёл GO - вывод не доходит до драйвера
+  if (gpio.count == 0) console.println("IN/TRIG: фронт не запустил эффект - проверьте GPIO4 -> IN/TRIG");
+}
+
+uint8_t &settingsRegister(uint8_t reg) {
+  switch (reg) {
+    case DRV2605_REG_RATEDV:
+      return currentSettings.overdriveReg;
+    case DRV2605_REG_CLAMPV:
+      return currentSettings.compensationReg;
+    case DRV2605_REG_AUTOCALCOMP:
+      return currentSettings.driveReg;
+    case DRV2605_REG_FEEDBACK:
+      return currentSettings.feedbackReg;
+    default:
+      return currentSettings.controlReg;
+  }
+}
+
+void selectNextField() {
+  // Первое нажатие выбирает первое поле
+  editableField = editableField + 1 < editableFieldCount ? editableField + 1 : 0;
+  const DRV2605::FieldRef &field = editableFields[editableField];
+  console.print("Поле: ");
+  console.print(field.name);
+  console.print(" = ");
+  console.print(field.get(settingsRegister(field.reg)));
+  console.print(" (0-");
+  console.print(field.maxValue());
+  console.println(")");
+}
+
+bool stepField(int direction) {
+  if (editableField == editableFieldCount) {
+    console.println("Сначала выберите поле: F");
+    return false;
+  }
+  // По кругу в пределах ширины поля, соседние биты регистра не трогаем
+  const DRV2605::FieldRef &field = editableFields[editableField];
+  uint8_t &reg = settingsRegister(field.reg);
+  reg = field.with(reg, field.get(reg) + direction);
+
+  console.print(field.name);
+  console.print(" = ");
+  console.println(field.get(reg));
+  return true;
+}
+
+// Сценарий работает с драйвером через те же функции, что и клавиши:
+// теневая копия, журнал сеанса и счётчики шины остаются верными
+class StandScriptHost : public ScriptHost {
+ public:
+  void scriptWrite(uint8_t reg, const uint8_t *values, uint8_t len) override {
+    if (len == 1) {
+      commitRegister(reg, values[0]);
+    } else {
+      commitRegisters(reg, values, len);
+    }
+  }
+  uint8_t scriptRead(uint8_t reg) override { return busRead(reg); }
+  void scriptEmit(uint8_t tag, uint32_t timeUs, uint8_t value) override {
+    console.print("S,");
+    console.print(tag);
+    console.print(",");
+    console.print(timeUs);
+    console.print(",");
+    console.println(value);
+  }
+  void scriptTelemetry(uint32_t timeUs) override { sampleTelemetry(timeUs); }
+};
+StandScriptHost scriptHost;
+
+void startScriptUpload() {
+  if (scriptVm.running()) return;
+
+  scriptUploadMode = true;
+  scriptUploadSize = 0;
+  scriptUploadByte = -1;
+  scriptUploadOverflow = false;
+  console.println("Сценарий: вставьте байт-код в hex и нажмите Enter ({ - отмена)");
+}
+
+void processScriptUpload(char cmd) {
+  if (cmd == '{') {
+    scriptUploadMode = false;
+    console.println("Загрузка сценария отменена");
+    return;
+  }
+  if (cmd == '\n' || cmd == '\r') {
+    finishScriptUpload();
+    return;
+  }
+
+  // Пробелы и прочие разделители пропускаем
+  int nibble;
+  if (cmd >= '0' && cmd <= '9') {
+    nibble = cmd - '0';
+  } else if (cmd >= 'a' && cmd <= 'f') {
+    nibble = cmd - 'a' + 10;
+  } else if (cmd >= 'A' && cmd <= 'F') {
+    nibble = cmd - 'A' + 10;
+  } else {
+    return;
+  }
+
+  if (scriptUploadByte < 0) {
+    scriptUploadByte = nibble;
+    return;
+  }
+  if (scriptUploadSize < sizeof(scriptUpload)) {
+    scriptUpload[scriptUploadSize++] = (scriptUploadByte << 4) | nibble;
+  } else {
+    scriptUploadOverflow = true;
+  }
+  scriptUploadByte = -1;
+}
+
+void finishScriptUpload() {
+  scriptUploadMode = false;
+  if (scriptUploadSize == 0) {
+    console.println("Сценарий пуст");
+    return;
+  }
+  if (scriptUploadOverflow || scriptUploadByte >= 0) {
+    console.println(scriptUploadOverflow ? "Ошибка: сценарий длиннее буфера" : "Ошибка: нечётное число hex-цифр");
+    return;
+  }
+  if (!scriptVm.load(scriptUpload, scriptUploadSize)) {
+    console.print("Ошибка в сценарии: ");
+    console.print(ScriptVm::errorName(scriptVm.error()));
+    console.print(" (байт ");
+    console.print((uint32_t)scriptVm.errorPos());
+    console.println(")");
+    return;
+  }
+
+  // Проверенный сценарий сохраняем как есть - при загрузке он пройдёт проверку снова
+  File file;
+  bool saved = LittleFS.begin(true) && (file = LittleFS.open(scriptPath, FILE_WRITE));
+  if (saved) {
+    saved = file.write(scriptUpload, scriptUploadSize) == scriptUploadSize;
+    file.close();
+  }
+
+  console.print("Сценарий загружен: ");
+  console.print((uint32_t)scriptUploadSize);
+  console.println(saved ? " байт, сохранён во flash" : " байт, во flash сохранить не удалось");
+}
+
+void loadScript() {
+  if (!LittleFS.begin(true)) return;
+  File file = LittleFS.open(scriptPath, FILE_READ);
+  if (!file) return;
+
+  size_t size = file.read(scriptUpload, sizeof(scriptUpload));
+  file.close();
+  if (size && !scriptVm.load(scriptUpload, size)) console.println("Сценарий во flash повреждён");
+}
+
+void toggleScript() {
+  if (scriptVm.running()) {
+    scriptVm.stop();
+    console.println("Сценарий остановлен");
+    updateScript();
+    return;
+  }
+  if (standBusy()) return;
+  if (scriptVm.size() == 0) {
+    console.println("Сценарий не загружен (X)");
+    return;
+  }
+
+  flushPendingInput(true);
+  wakeDriver();
+  queuedPlays = 0;
+  console.println("# tag,t_us,value");
+  scriptVm.start();
+  updateScript();
+}
+
+void updateScript() {
+  static bool wasRunning = false;
+  if (scriptVm.running()) {
+    wasRunning = true;
+    scriptVm.step(scriptHost);
+    lastActivityMs = millis();
+    if (scriptVm.running()) return;
+  }
+  if (!wasRunning) return;
+  wasRunning = false;
+
+  // Сценарий мог поменять что угодно - возвращаем настройки стенда целиком
+  preloadedEffect = 0;
+  driverModeReady = false;
+  applySettings(true);
+
+  console.print("Сценарий: ");
+  if (scriptVm.error() != SCRIPT_OK) {
+    console.print(ScriptVm::errorName(scriptVm.error()));
+    console.print(" (байт ");
+    console.print((uint32_t)scriptVm.errorPos());
+    console.print("), ");
+  }
+  console.print(scriptVm.ops());
+  console.print(" команд за ");
+  console.print(scriptVm.elapsedUs());
+  console.print(" мкс, макс. опоздание паузы ");
+  console.print(scriptVm.maxLateUs());
+  console.println(" мкс");
+}
+
+void toggleTuning() {
+  if (tuner.active()) {
+    finishTuning();
+    return;
+  }
+  if (standBusy()) return;
+
+  flushPendingInput(true);
+  int16_t start[TuneOptimizer::MAX_DIMS], lo[TuneOptimizer::MAX_DIMS];
+  int16_t hi[TuneOptimizer::MAX_DIMS], step[TuneOptimizer::MAX_DIMS];
+  for (uint8_t i = 0; i < tuneFieldCount; i++) {
+    const DRV2605::FieldRef &field = tuneFields[i];
+    start[i] = field.get(settingsRegister(field.reg));
+    lo[i] = 0;
+    hi[i] = field.maxValue();
+    // Байтам - шаг 16, узким полям - 1
+    step[i] = (field.maxValue() + 1) / 16;
+  }
+  tuner.begin(tuneFieldCount, start, lo, hi, step, tuneBudget);
+
+  if (vibrationMeasuring) {
+    console.println("Оценка по акселерометру: пик (g) - 0.03 * спад (мс), O или { - закончить");
+  } else {
+    console.println("Оценка: число и Enter, пробел - сыграть ещё раз, O или { - закончить");
+  }
+  console.print("# n");
+  for (uint8_t i = 0; i < tuneFieldCount; i++) {
+    console.print(",");
+    console.print(tuneFields[i].name);
+  }
+  console.println();
+  proposeTuningPoint();
+}
+
+void proposeTuningPoint() {
+  int16_t point[TuneOptimizer::MAX_DIMS];
+  if (!tuner.next(point)) {
+    finishTuning();
+    return;
+  }
+
+  for (uint8_t i = 0; i < tuneFieldCount; i++) {
+    const DRV2605::FieldRef &field = tuneFields[i];
+    uint8_t &reg = settingsRegister(field.reg);
+    reg = field.with(reg, point[i]);
+  }
+  applySettings();
+  requestPlay();
+
+  // Строка для программы на ПК: номер замера и точка
+  console.print("O,");
+  console.print(tuner.evaluations() + 1);
+  for (uint8_t i = 0; i < tuneFieldCount; i++) {
+    console.print(",");
+    console.print(point[i]);
+  }
+  console.println();
+  tuneInputLength = 0;
+}
+
+void processTuningInput(char cmd) {
+  if (cmd == '{' || cmd == 'O') {
+    finishTuning();
+    return;
+  }
+  if (cmd == ' ') {
+    requestPlay();
+    return;
+  }
+  // Оценку даёт замер вибрации - ввод не нужен
+  if (vibrationMeasuring) return;
+  if (cmd == '\n' || cmd == '\r') {
+    // Пустая строка - вторая половина \r\n
+    if (tuneInputLength == 0) return;
+    tuneInput[tuneInputLength] = 0;
+    tuner.report(atof(tuneInput));
+    proposeTuningPoint();
+    return;
+  }
+  if ((isdigit(cmd) || cmd == '.' || cmd == '-') && tuneInputLength < sizeof(tuneInput) - 1) {
+    tuneInput[tuneInputLength++] = cmd;
+  }
+}
+
+void finishTuning() {
+  tuner.stop();
+  tuneInputLength = 0;
+  if (tuner.evaluations() == 0) {
+    console.println("Подбор отменён");
+    return;
+  }
+
+  // Оставляем лучшую из измеренных точек
+  for (uint8_t i = 0; i < tuneFieldCount; i++) {
+    const DRV2605::FieldRef &field = tuneFields[i];
+    uint8_t &reg = settingsRegister(field.reg);
+    reg = field.with(reg, tuner.best()[i]);
+  }
+  applySettings();
+
+  console.print("Подбор: лучшая оценка ");
+  console.print(tuner.bestScore(), 2);
+  console.print(" за ");
+  console.print(tuner.evaluations());
+  console.print(" замеров, улучшений ");
+  console.println(tuner.improvements());
+  printCurrentSettings();
+}
+
+void toggleVibrationMeasuring() {
+  if (!accelPresent) {
+    console.println("LIS3DH не найден");
+    return;
+  }
+  vibrationMeasuring = !vibrationMeasuring;
+  vibrationCapturing = false;
+  if (!vibrationMeasuring) {
+    console.println("Замер вибрации выключен");
+    return;
+  }
+  console.print("Замер вибрации: LIS3DH ");
+  console.print(accel.rateHz());
+  console.println(" Гц, по строкам V и F на эффект");
+  console.println("# peak_mg,rms_mg,rise_us,fall_us,samples,overruns");
+  console.println("# freq_hz,thd_pm,h2_pm,h3_pm,h4_pm,h5_pm,points,us");
+}
+
+void startVibrationCapture() {
+  if (!vibrationMeasuring) return;
+
+  // Всё, что накопилось в FIFO до запуска, - покой: по нему вычитается
+  // сила тяжести
+  uint16_t n = readAccelFifo();
+  vibration.start(accel.rateHz());
+  for (uint16_t i = 0; i < n; i++) {
+    vibration.addRest(accelChunk[i].x, accelChunk[i].y, accelChunk[i].z);
+  }
+  vibrationCapturing = true;
+  vibrationGoCleared = false;
+  lastAccelDrainUs = micros();
+  lastVibrationGoPollUs = lastAccelDrainUs;
+}
+
+void updateVibrationCapture() {
+  if (!vibrationCapturing) return;
+
+  uint32_t now = micros();
+  if (now - lastAccelDrainUs >= accelDrainUs) {
+    lastAccelDrainUs = now;
+    drainAccel();
+  }
+  if (!vibrationGoCleared && now - lastVibrationGoPollUs >= vibrationGoPollUs) {
+    lastVibrationGoPollUs = now;
+    if (!(busRead(DRV2605_REG_GO) & 0x01)) {
+      vibrationGoCleared = true;
+      vibrationStopUs = now;
+    }
+  }
+  if (vibration.full() || (vibrationGoCleared && now - vibrationStopUs >= vibrationTailUs)) {
+    finishVibrationCapture();
+  }
+}
+
+uint16_t readAccelFifo() {
+  // Одно чтение FIFO_SRC и пакеты OUT_X_L..OUT_Z_H на всё, что есть в FIFO
+  uint32_t bursts = accel.bursts();
+  uint32_t samples = accel.samples();
+  uint16_t n = accel.drain(accelChunk, LIS3DH_FIFO_DEPTH);
+  bursts = accel.bursts() - bursts;
+  busTransactions += 1 + bursts;
+  busBytes += 4 + 3 * bursts + 6 * (accel.samples() - samples);
+  return n;
+}
+
+void drainAccel() {
+  uint32_t overruns = accel.overruns();
+  uint16_t n = readAccelFifo();
+  if (accel.overruns() != overruns) vibration.markOverrun();
+  for (uint16_t i = 0; i < n; i++) {
+    if (!vibration.add(accelChunk[i].x, accelChunk[i].y, accelChunk[i].z)) break;
+  }
+}
+
+void finishVibrationCapture() {
+  drainAccel();
+  vibrationCapturing = false;
+  VibrationMetrics metrics = vibration.finish();
+
+  console.print("V,");
+  console.print(metrics.peakMg);
+  console.print(",");
+  console.print(metrics.rmsMg);
+  console.print(",");
+  console.print(metrics.riseUs);
+  console.print(",");
+  console.print(metrics.fallUs);
+  console.print(",");
+  console.print(metrics.samples);
+  console.print(",");
+  console.println(metrics.overruns);
+
+  // Спектр: резонанс, гармоники в промилле от основной, размер БПФ и время
+  uint32_t started = micros();
+  ResonanceResult resonance = resonanceEstimator.analyze(
+      vibration.x(), vibration.y(), vibration.z(), vibration.samples(), vibration.rateHz());
+  uint32_t elapsed = micros() - started;
+  if (resonance.valid) {
+    console.print("F,");
+    console.print(resonance.centiHz / 100);
+    console.print(".");
+    if (resonance.centiHz % 100 < 10) console.print("0");
+    console.print(resonance.centiHz % 100);
+    console.print(",");
+    console.print(resonance.thdPermille);
+    for (uint8_t h = 0; h < ResonanceResult::HARMONICS; h++) {
+      console.print(",");
+      console.print(resonance.harmonicPermille[h]);
+    }
+    console.print(",");
+    console.print(resonance.points);
+    console.print(",");
+    console.println(elapsed);
+  }
+
+  // Автоподбор: сильнее и короче хвост - лучше, как в tools/tune_opt
+  if (tuner.active()) {
+    tuner.report(metrics.peakMg / 1000.0f - 0.03f * metrics.fallUs / 1000.0f);
+    proposeTuningPoint();
+  }
+}
@@ -0,0 +1,285 @@
+/*
+ * Vibration capture through the LIS3DH FIFO, off the stand.
+ *
+ * A recording (synthetic LRA click, or x_mg,y_mg,z_mg lines from a file) is
+ * replayed by LIS3DH_Sim at the sensor's output data rate. LIS3DH_Fifo drains
+ * it the way the stand does - one FIFO_SRC read and one burst per poll - into
+ * VibrationCapture, while every transfer advances the virtual clock by its
+ * I2C wire time. For a range of poll intervals the bench reports bus load,
+ * FIFO depth reached and samples lost, checks the drained stream against the
+ * recording sample for sample, and compares the stand's metrics with a
+ * double-precision reference on the unquantised recording.
+ *
+ *   ./accel_bench [--rate 1600] [--clock 400000] [--recording in.csv]
+ *                 [--save out.csv]
+ */
+#include <LIS3DH_Fifo.h>
+#include <LIS3DH_Sim.h>
+#include <VibrationCapture.h>
+
+#include <math.h>
+
+#include <random>
+#include <vector>
+
+static uint32_t busClock = 400000;
+
+// Wire time of a transfer: START, address, register, data, STOP. The
+// address phase passes before the sensor answers and the data phase after,
+// so samples taken during a burst land behind the ones being read, as they
+// do in the part
+static uint64_t bitsUs(uint32_t bits) {
+  return (uint64_t)bits * 1000000 / busClock;
+}
+
+static bool timedReadReg(void *obj, uint8_t *addr_buf, uint8_t addrsiz,
+                         uint8_t *data, uint16_t len) {
+  hostAdvanceUs(bitsUs(1 + 2 * 9 + 10 + 9)); // START, addr, reg, Sr, addr
+  bool ok = LIS3DH_Sim::readRegCallback(obj, addr_buf, addrsiz, data, len);
+  hostAdvanceUs(bitsUs(len * 9 + 1));
+  return ok;
+}
+
+static bool timedWriteReg(void *obj, uint8_t *addr_buf, uint8_t addrsiz,
+                          const uint8_t *data, uint16_t len) {
+  hostAdvanceUs(bitsUs(2 + (2 + len) * 9));
+  return LIS3DH_Sim::writeRegCallback(obj, addr_buf, addrsiz, data, len);
+}
+
+// An LRA click on X with some cross-axis motion, on top of gravity on Z:
+// exponential attack, sustain, exponential ring-down, sensor noise
+static std::vector<LIS3DH_Sample> synthesize(uint16_t rate) {
+  std::mt19937 rng(1);
+  std::normal_distribution<double> noise(0, 12);
+  const double hz = 235, amplitude = 1800;
+  const double attack = 0.006, sustain = 0.060, ring = 0.012;
+
+  std::vector<LIS3DH_Sample> out;
+  for (uint32_t i = 0; i < rate / 4u; i++) {
+    double t = (double)i / rate;
+    double env = 1 - exp(-t / attack);
+    if (t > sustain)
+      env *= exp(-(t - sustain) / ring);
+    double v = amplitude * env * sin(2 * M_PI * hz * t);
+    out.push_back({(int16_t)lround(v + noise(rng)),
+                   (int16_t)lround(0.2 * v + noise(rng)),
+                   (int16_t)lround(1000 + 0.1 * v + noise(rng))});
+  }
+  return out;
+}
+
+static bool load(const char *path, std::vector<LIS3DH_Sample> &out) {
+  FILE *in = fopen(path, "r");
+  if (!in) {
+    perror(path);
+    return false;
+  }
+  char line[128];
+  int x, y, z;
+  while (fgets(line, sizeof(line), in))
+    if (line[0] != '#' && sscanf(line, "%d,%d,%d", &x, &y, &z) == 3)
+      out.push_back({(int16_t)x, (int16_t)y, (int16_t)z});
+  fclose(in);
+  return !out.empty();
+}
+
+// Same definitions as VibrationCapture::finish(), in double and unquantised
+static VibrationMetrics reference(const std::vector<LIS3DH_Sample> &rec,
+                                  const LIS3DH_Sample &rest, uint16_t rate) {
+  size_t n = rec.size();
+  std::vector<double> m(n), env(n);
+  double peak = 0;
+  for (size_t i = 0; i < n; i++) {
+    double x = rec[i].x - rest.x, y = rec[i].y - rest.y, z = rec[i].z - rest.z;
+    m[i] = sqrt(x * x + y * y + z * z);
+    peak = fmax(peak, m[i]);
+  }
+  const int half = VibrationCapture::ENVELOPE_HALF;
+  long firstLow = -1, firstHigh = -1, lastHigh = -1, lastLow = -1;
+  for (size_t i = 0; i < n; i++) {
+    env[i] = 0;
+    for (long k = (long)i - half; k <= (long)i + half; k++)
+      if (k >= 0 && k < (long)n)
+        env[i] = fmax(env[i], m[k]);
+    if (env[i] >= 0.1 * peak) {
+      if (firstLow < 0)
+        firstLow = i;
+      lastLow = i;
+    }
+    if (env[i] >= 0.9 * peak) {
+      if (firstHigh < 0)
+        firstHigh = i;
+      lastHigh = i;
+    }
+  }
+  double sum = 0;
+  for (long i = firstLow; i <= lastLow; i++)
+    sum += m[i] * m[i];
+  VibrationMetrics r;
+  r.peakMg = lround(peak);
+  r.rmsMg = lround(sqrt(sum / (lastLow - firstLow + 1)));
+  r.riseUs = (firstHigh - firstLow) * 1000000L / rate;
+  r.fallUs = (lastLow - lastHigh) * 1000000L / rate;
+  r.samples = n;
+  r.overruns = 0;
+  return r;
+}
+
+struct Run {
+  uint32_t drains, bytes, busUs;
+  uint8_t maxLevel;
+  uint32_t dropped, overruns, mismatches;
+  VibrationMetrics metrics;
+};
+
+static Run capture(const std::vector<LIS3DH_Sample> &rec,
+                   const LIS3DH_Sample &rest, lis3dh_fifo_rate_t rate,
+                   uint32_t pollUs) {
+  static VibrationCapture vc;
+  LIS3DH_Sim sim;
+  Adafruit_GenericDevice bus(&sim, LIS3DH_Sim::readCallback,
+                             LIS3DH_Sim::writeCallback, timedReadReg,
+                             timedWriteReg);
+  LIS3DH_Fifo accel;
+  sim.setRest(rest);
+  sim.setRecording(rec.data(), rec.size());
+  accel.begin(&bus);
+  accel.configure(rate, LIS3DH_RANGE_4_G);
+
+  // Idle long enough to fill the FIFO with rest, as between plays
+  hostAdvanceUs(30000);
+  std::vector<LIS3DH_Sample> stream;
+  LIS3DH_Sample chunk[LIS3DH_FIFO_DEPTH];
+  uint16_t n = accel.drain(chunk, LIS3DH_FIFO_DEPTH);
+  stream.insert(stream.end(), chunk, chunk + n);
+  vc.start(accel.rateHz());
+  for (uint16_t i = 0; i < n; i++)
+    vc.addRest(chunk[i].x, chunk[i].y, chunk[i].z);
+
+  // The idle FIFO overflowed; count losses from here on
+  uint32_t dropped = sim.dropped(), overruns = accel.overruns();
+  sim.resetMaxLevel();
+  sim.play();
+  uint32_t first = sim.produced() - dropped; // stream index of sample 0
+  uint32_t bytes = sim.bytes(), transactions = sim.transactions();
+  uint64_t start = hostTimeUs(), busUs = 0;
+  uint64_t end = start + (uint64_t)rec.size() * 1000000 / accel.rateHz() +
+                 100000; // the stand's tail after GO clears
+  Run run = {};
+  while (hostTimeUs() < end && !vc.full()) {
+    hostAdvanceUs(pollUs);
+    uint64_t before = hostTimeUs();
+    uint32_t full = accel.overruns();
+    n = accel.drain(chunk, LIS3DH_FIFO_DEPTH);
+    busUs += hostTimeUs() - before;
+    run.drains++;
+    if (accel.overruns() != full)
+      vc.markOverrun();
+    stream.insert(stream.end(), chunk, chunk + n);
+    for (uint16_t i = 0; i < n; i++)
+      vc.add(chunk[i].x, chunk[i].y, chunk[i].z);
+  }
+
+  run.bytes = sim.bytes() - bytes + 2 * (sim.transactions() - transactions);
+  run.busUs = hostTimeUs() > start ? busUs * 1000 / (hostTimeUs() - start) : 0;
+  run.maxLevel = sim.maxLevel();
+  run.dropped = sim.dropped() - dropped;
+  run.overruns = accel.overruns() - overruns;
+  run.metrics = vc.finish();
+
+  // Without losses, drained sample k is produced sample k
+  for (size_t j = 0; j < rec.size(); j++) {
+    size_t k = first + j;
+    if (k >= stream.size() || stream[k].x != sim.quantize(rec[j].x) ||
+        stream[k].y != sim.quantize(rec[j].y) ||
+        stream[k].z != sim.quantize(rec[j].z))
+      run.mismatches++;
+  }
+  return run;
+}
+
+int main(int argc, char **argv) {
+  const char *recording = NULL, *save = NULL;
+  uint16_t hz = 1600;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--rate") && i + 1 < argc)
+      hz = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--clock") && i + 1 < argc)
+      busClock = atol(argv[++i]);
+    else if (!strcmp(argv[i], "--recording") && i + 1 < argc)
+      recording = argv[++i];
+    else if (!strcmp(argv[i], "--save") && i + 1 < argc)
+      save = argv[++i];
+  }
+  lis3dh_fifo_rate_t rate = hz == 1344   ? LIS3DH_RATE_1344_HZ
+                            : hz == 5376 ? LIS3DH_RATE_5376_HZ_LP
+                                         : LIS3DH_RATE_1600_HZ_LP;
+  if (rate == LIS3DH_RATE_1600_HZ_LP)
+    hz = 1600; // any other rate falls back to the stand's
+
+  std::vector<LIS3DH_Sample> rec;
+  LIS3DH_Sample rest = {0, 0, 1000};
+  if (recording) {
+    if (!load(recording, rec)) {
+      fprintf(stderr, "%s: no x,y,z lines\n", recording);
+      return 1;
+    }
+    // A recording is expected to start at rest
+    long sum[3] = {0, 0, 0};
+    size_t k = rec.size() < 16 ? rec.size() : 16;
+    for (size_t i = 0; i < k; i++) {
+      sum[0] += rec[i].x;
+      sum[1] += rec[i].y;
+      sum[2] += rec[i].z;
+    }
+    rest = {(int16_t)(sum[0] / (long)k), (int16_t)(sum[1] / (long)k),
+            (int16_t)(sum[2] / (long)k)};
+  } else {
+    rec = synthesize(hz);
+  }
+  if (save) {
+    FILE *out = fopen(save, "w");
+    if (!out) {
+      perror(save);
+      return 1;
+    }
+    fprintf(out, "# x_mg,y_mg,z_mg at %u Hz\n", hz);
+    for (const LIS3DH_Sample &s : rec)
+      fprintf(out, "%d,%d,%d\n", s.x, s.y, s.z);
+    fclose(out);
+  }
+
+  printf("%zu samples at %u Hz, I2C %lu kHz, FIFO %d samples = %.1f ms\n",
+         rec.size(), hz, (unsigned long)(busClock / 1000), LIS3DH_FIFO_DEPTH,
+         LIS3DH_FIFO_DEPTH * 1000.0 / hz);
+  printf("poll_ms drains bytes bus_%% max_level dropped overruns mismatches\n");
+  static const uint32_t polls[] = {1000, 2000, 5000, 10000, 15000, 19000,
+                                   22000, 25000};
+  int failures = 0;
+  Run stand = {};
+  for (uint32_t pollUs : polls) {
+    Run run = capture(rec, rest, rate, pollUs);
+    printf("%7.1f %6lu %5lu %5.1f %9u %7lu %8lu %10lu\n", pollUs / 1000.0,
+           (unsigned long)run.drains, (unsigned long)run.bytes,
+           run.busUs / 10.0, run.maxLevel, (unsigned long)run.dropped,
+           (unsigned long)run.overruns, (unsigned long)run.mismatches);
+    // The stand drains every 5 ms: nothing may be lost there
+    if (pollUs == 5000) {
+      stand = run;
+      if (run.dropped || run.mismatches)
+        failures++;
+    }
+  }
+
+  VibrationMetrics ref = reference(rec, rest, hz);
+  VibrationMetrics &m = stand.metrics;
+  printf("\nmetrics at 5 ms polling    stand  reference\n");
+  printf("peak, mg               %8u %10u\n", m.peakMg, ref.peakMg);
+  printf("rms, mg                %8u %10u\n", m.rmsMg, ref.rmsMg);
+  printf("rise 10-90%%, us        %8lu %10lu\n", (unsigned long)m.riseUs,
+         (unsigned long)ref.riseUs);
+  printf("fall 90-10%%, us        %8lu %10lu\n", (unsigned long)m.fallUs,
+         (unsigned long)ref.fallUs);
+  printf("samples                %8u %10u\n", m.samples, ref.samples);
+  return failures ? 1 : 0;
+}
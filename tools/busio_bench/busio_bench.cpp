@@ -0,0 +1,105 @@
+/*
+ * Register access cost: Adafruit_BusIO_Register vs BusIO::Register<Bus>.
+ *
+ * Both variants talk to the same RAM-backed register file. The classic path
+ * goes through Adafruit_GenericDevice (void* + C callbacks) and the run-time
+ * bus selection of Adafruit_BusIO_Register; the templated path uses a policy
+ * the compiler can inline. Every iteration does one read-modify-write of a
+ * 3-bit field, the typical RegisterBits pattern.
+ *
+ * Code size: nm -C -S --size-sort busio_bench | grep -i access
+ */
+#include <chrono>
+
+#include <Adafruit_BusIO_Register.h>
+
+#define ITERATIONS 20000000UL
+
+static uint8_t regfile[256];
+
+// --- classic: C callbacks through void*
+static bool ramRead(void *, uint8_t *, size_t) { return false; }
+static bool ramWrite(void *, const uint8_t *, size_t) { return false; }
+static bool ramReadReg(void *obj, uint8_t *addr, uint8_t, uint8_t *data,
+                       uint16_t len) {
+  memcpy(data, (uint8_t *)obj + addr[0], len);
+  return true;
+}
+static bool ramWriteReg(void *obj, uint8_t *addr, uint8_t, const uint8_t *data,
+                        uint16_t len) {
+  memcpy((uint8_t *)obj + addr[0], data, len);
+  return true;
+}
+
+// --- templated: the same register file as an inline policy
+struct RamPolicy {
+  uint8_t *mem;
+  bool read(uint8_t *, size_t) { return false; }
+  bool write(const uint8_t *, size_t) { return false; }
+  bool readRegister(const uint8_t *addr, uint8_t, uint8_t *data,
+                    uint16_t len) {
+    memcpy(data, mem + addr[0], len);
+    return true;
+  }
+  bool writeRegister(const uint8_t *addr, uint8_t, const uint8_t *data,
+                     uint16_t len) {
+    memcpy(mem + addr[0], data, len);
+    return true;
+  }
+};
+typedef BusIO::GenericDevice<RamPolicy> RamDevice;
+typedef BusIO::Register<BusIO::GenericBus<RamDevice>> RamRegister;
+
+__attribute__((noinline)) uint32_t classicAccess(Adafruit_BusIO_Register &reg,
+                                                 uint32_t v) {
+  uint32_t val = reg.read();
+  val = (val & ~0x1C) | ((v & 0x07) << 2);
+  reg.write(val, 1);
+  return val;
+}
+
+__attribute__((noinline)) uint32_t templatedAccess(RamRegister &reg,
+                                                   uint32_t v) {
+  uint32_t val = reg.read();
+  val = (val & ~0x1C) | ((v & 0x07) << 2);
+  reg.write(val, 1);
+  return val;
+}
+
+template <class F> static double nsPerAccess(F f) {
+  auto start = std::chrono::steady_clock::now();
+  uint32_t sink = 0;
+  for (uint32_t i = 0; i < ITERATIONS; i++)
+    sink += f(i);
+  auto stop = std::chrono::steady_clock::now();
+  if (sink == 0xFFFFFFFF)
+    printf(" ");
+  return std::chrono::duration<double, std::nano>(stop - start).count() /
+         ITERATIONS;
+}
+
+int main(void) {
+  Adafruit_GenericDevice classic_dev(regfile, ramRead, ramWrite, ramReadReg,
+                                     ramWriteReg);
+  classic_dev.begin();
+  Adafruit_BusIO_Register classic_reg(&classic_dev, 0x1A);
+
+  RamDevice templated_dev(RamPolicy{regfile});
+  templated_dev.begin();
+  RamRegister templated_reg(BusIO::GenericBus<RamDevice>{&templated_dev},
+                            0x1A);
+
+  double classic = 1e9, templated = 1e9;
+  for (int n = 0; n < 3; n++) {
+    double c = nsPerAccess([&](uint32_t i) { return classicAccess(classic_reg, i); });
+    double t = nsPerAccess([&](uint32_t i) { return templatedAccess(templated_reg, i); });
+    classic = c < classic ? c : classic;
+    templated = t < templated ? t : templated;
+  }
+
+  printf("read-modify-write per field:\n");
+  printf("  Adafruit_BusIO_Register  %6.2f ns\n", classic);
+  printf("  BusIO::Register<Bus>     %6.2f ns  (%.1fx)\n", templated,
+         classic / templated);
+  return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * Off-hardware stand session against the DRV2605 model.
+ *
+ * Runs auto-calibration, then sweeps every ROM effect over a range of drive
+ * levels for the requested number of simulated hours, polling GO the way the
+ * stand does. Prints what the driver reported and how long the simulation
+ * took in real time.
+ *
+ *   ./drv_sim [hours]
+ */
+#include <chrono>
+
+#include <Adafruit_DRV2605.h>
+#include <DRV2605_Sim.h>
+
+static DRV2605_Sim sim;
+static Adafruit_DRV2605 drv;
+
+static uint32_t waitGo(void) {
+  uint32_t start = micros();
+  while (drv.readRegister8(DRV2605_REG_GO) & 0x01)
+    delay(1);
+  return micros() - start;
+}
+
+int main(int argc, char **argv) {
+  double hours = argc > 1 ? atof(argv[1]) : 4;
+  auto wall_start = std::chrono::steady_clock::now();
+
+  drv.begin(sim.device());
+  drv.useLRA();
+
+  drv.setMode(DRV2605_MODE_AUTOCAL);
+  drv.go();
+  uint32_t cal_us = waitGo();
+  uint8_t status = drv.readRegister8(DRV2605_REG_STATUS);
+  printf("autocal %lu ms: %s, comp 0x%02X bemf 0x%02X\n",
+         (unsigned long)(cal_us / 1000), (status & 0x08) ? "FAIL" : "ok",
+         drv.readRegister8(DRV2605_REG_AUTOCALCOMP),
+         drv.readRegister8(DRV2605_REG_AUTOCALEMP));
+
+  drv.setMode(DRV2605_MODE_INTTRIG);
+  drv.selectLibrary(6);
+
+  uint64_t end_us = (uint64_t)(hours * 3600e6);
+  uint32_t plays = 0, overtemps = 0;
+  uint8_t min_vbat = 255, min_lra = 255, max_lra = 0;
+
+  while (hostTimeUs() < end_us) {
+    for (uint8_t effect = 1; effect <= 123 && hostTimeUs() < end_us; effect++) {
+      drv.writeRegister8(DRV2605_REG_RATEDV, 0x40 + (plays % 8) * 0x18);
+      drv.setWaveform(0, effect);
+      drv.setWaveform(1, 0);
+      drv.go();
+      delay(1);
+
+      uint8_t vbat = drv.readRegister8(DRV2605_REG_VBAT);
+      if (vbat < min_vbat)
+        min_vbat = vbat;
+      waitGo();
+
+      uint8_t lra = drv.readRegister8(DRV2605_REG_LRARESON);
+      if (lra < min_lra)
+        min_lra = lra;
+      if (lra > max_lra)
+        max_lra = lra;
+      if (drv.readRegister8(DRV2605_REG_STATUS) & SIM_STATUS_OVER_TEMP)
+        overtemps++;
+
+      plays++;
+      delay(50);
+    }
+  }
+
+  double wall = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - wall_start)
+                    .count();
+
+  printf("simulated %.2f h in %.3f s of wall time\n", hostTimeUs() / 3600e6,
+         wall);
+  printf("plays %lu, GO accepted %lu, output active %.1f%%\n",
+         (unsigned long)plays, (unsigned long)sim.goCount(),
+         100.0 * sim.activeUs() / hostTimeUs());
+  printf("bus: %lu transactions, %lu data bytes\n",
+         (unsigned long)sim.transactions(), (unsigned long)sim.bytes());
+  printf("VBAT min %.2f V, LRA period %u-%u (%.1f-%.1f Hz), over-temp %lu\n",
+         min_vbat * 5.6 / 255, min_lra, max_lra, 1e6 / (max_lra * 98.46),
+         1e6 / (min_lra * 98.46), (unsigned long)overtemps);
+  return 0;
+}
@@ -0,0 +1,337 @@
+/*
+ * Fixed-point FFT and resonance estimator against double precision.
+ *
+ * Part 1 runs FixedFft::transform on tones and noise at every size and
+ * compares the result, rescaled by its block exponent, with a double FFT
+ * of the same int16 input (SNR in dB), then times both.
+ *
+ * Part 2 builds synthetic LRA captures - a click of random frequency,
+ * amplitude, length and harmonic content, with attack, ring-down and
+ * noise, quantised to the stand's 32 mg steps - and runs
+ * ResonanceEstimator on them next to the same algorithm in double. The
+ * frequency is checked against the truth, the harmonic levels against the
+ * double reference (a click that rings down has no single true level).
+ *
+ *   ./fft_bench [--trials 2000] [--seed 1]
+ */
+#include <FixedFft.h>
+#include <ResonanceEstimator.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <complex>
+#include <random>
+#include <vector>
+
+typedef std::complex<double> Complex;
+
+static void referenceFft(std::vector<Complex> &a) {
+  size_t n = a.size();
+  for (size_t i = 1, j = 0; i < n; i++) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j |= bit;
+    if (i < j)
+      std::swap(a[i], a[j]);
+  }
+  for (size_t len = 2; len <= n; len <<= 1) {
+    for (size_t k = 0; k < len / 2; k++) {
+      Complex w = std::polar(1.0, -2 * M_PI * k / len);
+      for (size_t i = k; i < n; i += len) {
+        Complex t = w * a[i + len / 2];
+        a[i + len / 2] = a[i] - t;
+        a[i] += t;
+      }
+    }
+  }
+}
+
+static double seconds(std::chrono::steady_clock::time_point since) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       since)
+      .count();
+}
+
+// ------------------------------------------------------------------ kernel
+
+static double kernelSnr(const std::vector<int16_t> &input, uint8_t log2) {
+  size_t n = input.size();
+  static int16_t re[FixedFft::MAX_SIZE], im[FixedFft::MAX_SIZE];
+  std::vector<Complex> ref(n);
+  for (size_t i = 0; i < n; i++) {
+    re[i] = input[i];
+    im[i] = 0;
+    ref[i] = input[i];
+  }
+  uint8_t exponent = FixedFft::transform(re, im, log2);
+  referenceFft(ref);
+
+  double signal = 0, error = 0;
+  for (size_t i = 0; i < n; i++) {
+    Complex got(ldexp(re[i], exponent), ldexp(im[i], exponent));
+    signal += std::norm(ref[i]);
+    error += std::norm(got - ref[i]);
+  }
+  return 10 * log10(signal / fmax(error, 1e-30));
+}
+
+static void benchKernel(std::mt19937 &rng) {
+  std::uniform_real_distribution<double> uniform(-1, 1);
+  printf("points  full tone  weak tone  noise   fixed us  double us\n");
+  for (uint8_t log2 = 6; log2 <= FixedFft::MAX_LOG2; log2++) {
+    size_t n = 1 << log2;
+    std::vector<int16_t> full(n), weak(n), noise(n);
+    double bin = 0.37 * n / 8 + 0.3;
+    for (size_t i = 0; i < n; i++) {
+      double s = sin(2 * M_PI * bin * i / n);
+      full[i] = lround(16000 * s);
+      weak[i] = lround(100 * s);
+      noise[i] = lround(8000 * uniform(rng));
+    }
+
+    // Timing on the noise input, copied in each round like the stand does
+    static int16_t re[FixedFft::MAX_SIZE], im[FixedFft::MAX_SIZE];
+    int rounds = 200000 >> log2;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+      memcpy(re, noise.data(), n * sizeof(int16_t));
+      memset(im, 0, n * sizeof(int16_t));
+      FixedFft::transform(re, im, log2);
+    }
+    double fixedUs = seconds(start) * 1e6 / rounds;
+    std::vector<Complex> a(n);
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+      for (size_t i = 0; i < n; i++)
+        a[i] = noise[i];
+      referenceFft(a);
+    }
+    double doubleUs = seconds(start) * 1e6 / rounds;
+
+    printf("%6zu %8.1f dB %7.1f dB %5.1f dB %9.2f %10.2f\n", n,
+           kernelSnr(full, log2), kernelSnr(weak, log2),
+           kernelSnr(noise, log2), fixedUs, doubleUs);
+  }
+}
+
+// --------------------------------------------------------------- estimator
+
+struct Reference {
+  double hz, thd, harmonic[ResonanceResult::HARMONICS];
+};
+
+// ResonanceEstimator::analyze() in double: same axis, window, band, lobes
+static Reference referenceEstimate(const int16_t *const axes[3],
+                                   uint16_t count, uint16_t rate) {
+  Reference r = {};
+  int best = 0;
+  double bestEnergy = -1;
+  for (int a = 0; a < 3; a++) {
+    double sum = 0, squares = 0;
+    for (uint16_t i = 0; i < count; i++) {
+      sum += axes[a][i];
+      squares += (double)axes[a][i] * axes[a][i];
+    }
+    double energy = squares - sum * sum / count;
+    if (energy > bestEnergy) {
+      bestEnergy = energy;
+      best = a;
+    }
+  }
+  const int16_t *data = axes[best];
+
+  const int smooth = ResonanceEstimator::SMOOTH;
+  double energy = 0, loudest = 0;
+  for (long i = 0; i < count; i++) {
+    energy += (double)data[i] * data[i];
+    if (i >= smooth)
+      energy -= (double)data[i - smooth] * data[i - smooth];
+    loudest = fmax(loudest, energy);
+  }
+  long first = -1, last = 0;
+  energy = 0;
+  for (long i = 0; i < count; i++) {
+    energy += (double)data[i] * data[i];
+    if (i >= smooth)
+      energy -= (double)data[i - smooth] * data[i - smooth];
+    if (energy < floor(loudest / 64))
+      continue;
+    if (first < 0)
+      first = i < smooth ? 0 : i - smooth + 1;
+    last = i;
+  }
+  long n = 64;
+  while (n < FixedFft::MAX_SIZE && n < last - first + 1)
+    n *= 2;
+  long start = (first + last + 1 - n) / 2;
+  if (last - first + 1 > n) {
+    double window = 0, bestWindow;
+    for (long i = first; i < first + n; i++)
+      window += (double)data[i] * data[i];
+    bestWindow = window;
+    start = first;
+    for (long i = first + n; i <= last; i++) {
+      window += (double)data[i] * data[i] - (double)data[i - n] * data[i - n];
+      if (window > bestWindow) {
+        bestWindow = window;
+        start = i - n + 1;
+      }
+    }
+  }
+  double mean = 0;
+  int inside = 0;
+  for (long i = start; i < start + n; i++)
+    if (i >= 0 && i < count) {
+      mean += data[i];
+      inside++;
+    }
+  mean /= inside;
+
+  std::vector<Complex> x(n);
+  for (long i = 0; i < n; i++) {
+    long k = start + i;
+    double v = k < 0 || k >= count ? 0 : data[k] - mean;
+    x[i] = v * 0.5 * (1 - cos(2 * M_PI * i / n));
+  }
+  referenceFft(x);
+
+  long low = (long)ceil(100.0 * n / rate), high = 400 * n / rate;
+  low = low < 1 ? 1 : low;
+  high = high > n / 2 - 1 ? n / 2 - 1 : high;
+  long peak = low;
+  for (long k = low; k <= high; k++)
+    if (std::abs(x[k]) > std::abs(x[peak]))
+      peak = k;
+  double side = fmax(std::abs(x[peak - 1]), std::abs(x[peak + 1]));
+  double delta = (2 * side - std::abs(x[peak])) / (side + std::abs(x[peak]));
+  delta = fmin(fmax(delta, 0), 0.5);
+  if (std::abs(x[peak - 1]) > std::abs(x[peak + 1]))
+    delta = -delta;
+  double position = peak + delta;
+  r.hz = position * rate / n;
+
+  auto lobe = [&](long center) {
+    double sum = 0;
+    for (long k = center - 2; k <= center + 2; k++)
+      if (k >= 1 && k <= (long)n / 2)
+        sum += std::norm(x[k]);
+    return sum;
+  };
+  double fundamental = lobe(lround(position));
+  double harmonics = 0;
+  for (int h = 0; h < ResonanceResult::HARMONICS; h++) {
+    long center = lround(position * (h + 2));
+    if (center + 2 >= (long)n / 2)
+      break;
+    double p = lobe(center);
+    harmonics += p;
+    r.harmonic[h] = 1000 * sqrt(p / fundamental);
+  }
+  r.thd = 1000 * sqrt(harmonics / fundamental);
+  return r;
+}
+
+struct Stats {
+  double sum = 0, worst = 0;
+  int n = 0;
+  void add(double e) {
+    sum += fabs(e);
+    worst = fmax(worst, fabs(e));
+    n++;
+  }
+  double mean() const { return n ? sum / n : 0; }
+};
+
+static void benchEstimator(std::mt19937 &rng, int trials) {
+  const uint16_t rate = 1600;
+  std::uniform_real_distribution<double> uniform(0, 1);
+  std::normal_distribution<double> gauss(0, 12);
+  static int16_t x[2048], y[2048], z[2048];
+  static ResonanceEstimator estimator;
+
+  Stats freqFixed, freqRef, freqVsRef, h2, h3, thd, h2True, h3True;
+  double fixedSeconds = 0;
+  int invalid = 0;
+  for (int t = 0; t < trials; t++) {
+    double hz = 150 + 150 * uniform(rng);
+    double amplitude = 300 + 1700 * uniform(rng);
+    double r2 = 0.1 * uniform(rng), r3 = 0.05 * uniform(rng);
+    double phase = 2 * M_PI * uniform(rng);
+    double sustain = 0.03 + 0.2 * uniform(rng);
+    double ring = 0.005 + 0.03 * uniform(rng);
+    uint16_t count = 300 + (uint16_t)(1700 * uniform(rng));
+
+    for (uint16_t i = 0; i < count; i++) {
+      double s = (double)i / rate;
+      double env = 1 - exp(-s / 0.006);
+      if (s > sustain)
+        env *= exp(-(s - sustain) / ring);
+      double w = 2 * M_PI * hz * s + phase;
+      double v = amplitude * env * (sin(w) + r2 * sin(2 * w) + r3 * sin(3 * w));
+      // Stand capture: rest removed, 32 mg steps of the 1.6 kHz LP mode
+      x[i] = 32 * lround((v + gauss(rng)) / 32);
+      y[i] = 32 * lround((0.2 * v + gauss(rng)) / 32);
+      z[i] = 32 * lround((0.1 * v + gauss(rng)) / 32);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    ResonanceResult got = estimator.analyze(x, y, z, count, rate);
+    fixedSeconds += seconds(start);
+    const int16_t *const axes[3] = {x, y, z};
+    Reference ref = referenceEstimate(axes, count, rate);
+    if (!got.valid) {
+      invalid++;
+      continue;
+    }
+
+    double gotHz = got.centiHz / 100.0;
+    freqFixed.add(gotHz - hz);
+    freqRef.add(ref.hz - hz);
+    freqVsRef.add(gotHz - ref.hz);
+    h2.add(got.harmonicPermille[0] - ref.harmonic[0]);
+    h3.add(got.harmonicPermille[1] - ref.harmonic[1]);
+    thd.add(got.thdPermille - ref.thd);
+    // Against the truth only where the harmonic's lobe is below Nyquist
+    double edge = rate / 2.0 - 3.0 * rate / got.points;
+    if (2 * hz < edge)
+      h2True.add(got.harmonicPermille[0] - 1000 * r2);
+    if (3 * hz < edge)
+      h3True.add(got.harmonicPermille[1] - 1000 * r3);
+  }
+
+  printf("\n%d captures at %u Hz, 150-300 Hz, 300-2000 mg, 32 mg steps\n",
+         trials, rate);
+  printf("                           mean      max\n");
+  printf("freq fixed-true, Hz    %8.3f %8.3f\n", freqFixed.mean(),
+         freqFixed.worst);
+  printf("freq double-true, Hz   %8.3f %8.3f\n", freqRef.mean(),
+         freqRef.worst);
+  printf("freq fixed-double, Hz  %8.3f %8.3f\n", freqVsRef.mean(),
+         freqVsRef.worst);
+  printf("2nd fixed-double, pm   %8.3f %8.3f\n", h2.mean(), h2.worst);
+  printf("3rd fixed-double, pm   %8.3f %8.3f\n", h3.mean(), h3.worst);
+  printf("THD fixed-double, pm   %8.3f %8.3f\n", thd.mean(), thd.worst);
+  printf("2nd fixed-true, pm     %8.3f %8.3f\n", h2True.mean(), h2True.worst);
+  printf("3rd fixed-true, pm     %8.3f %8.3f\n", h3True.mean(), h3True.worst);
+  printf("invalid %d, fixed estimate %.1f us per capture on this host\n",
+         invalid, fixedSeconds * 1e6 / trials);
+}
+
+int main(int argc, char **argv) {
+  int trials = 2000, seed = 1;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--trials") && i + 1 < argc)
+      trials = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+      seed = atoi(argv[++i]);
+  }
+  std::mt19937 rng(seed);
+  benchKernel(rng);
+  benchEstimator(rng, trials);
+  return 0;
+}
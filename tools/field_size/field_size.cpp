@@ -0,0 +1,98 @@
+/*
+ * Code size of DRV2605_RegisterMap.h field access vs handwritten masks.
+ *
+ * Each pair does the same thing twice: once through the typed accessors
+ * (Field<>::get/with, RegisterWindow<>::set) and once with the shift and
+ * mask written out by hand. Every function is placed in a section of its
+ * own, so the linker's __start_/__stop_ symbols give its exact size. The
+ * results are compared for all inputs first.
+ *
+ * Build at -Os, the way the firmware is built. The exit code is non-zero
+ * if a typed accessor is larger than its handwritten form or gives a
+ * different result.
+ */
+#include <stdint.h>
+#include <stdio.h>
+
+#include <DRV2605_RegisterMap.h>
+
+#define MEASURED(name) __attribute__((noinline, used, section(#name)))
+#define SECTION_SIZE(name) (size_t)(__stop_##name - __start_##name)
+#define DECLARE_SECTION(name)                                                  \
+  extern "C" const uint8_t __start_##name[], __stop_##name[]
+
+typedef DRV2605::RegisterWindow<0x16, 11> Window;
+
+// --- field value: LOOP_GAIN, 2 bits in the middle of 0x1A
+MEASURED(typed_get) uint8_t typedGet(uint8_t reg) {
+  return DRV2605::Feedback::LoopGain::get(reg);
+}
+MEASURED(hand_get) uint8_t handGet(uint8_t reg) { return (reg >> 2) & 0x03; }
+
+// --- flag: BIDIR_INPUT, top bit of 0x1C
+MEASURED(typed_flag) bool typedFlag(uint8_t reg) {
+  return DRV2605::Control2::BidirInput::get(reg);
+}
+MEASURED(hand_flag) bool handFlag(uint8_t reg) { return reg & 0x80; }
+
+// --- register with the field replaced
+MEASURED(typed_with) uint8_t typedWith(uint8_t reg, uint8_t value) {
+  return DRV2605::Feedback::LoopGain::with(reg, value);
+}
+MEASURED(hand_with) uint8_t handWith(uint8_t reg, uint8_t value) {
+  return (reg & ~0x0C) | ((value << 2) & 0x0C);
+}
+
+// --- field changed in a shadow window: AUTO_CAL_TIME of 0x1E
+MEASURED(typed_window) void typedWindow(Window &window, uint8_t value) {
+  window.set<DRV2605::Control4::AutoCalTime>(value);
+}
+MEASURED(hand_window) void handWindow(Window &window, uint8_t value) {
+  window.bytes[0x1E - 0x16] =
+      (window.bytes[0x1E - 0x16] & ~0x30) | ((value << 4) & 0x30);
+}
+
+DECLARE_SECTION(typed_get);
+DECLARE_SECTION(hand_get);
+DECLARE_SECTION(typed_flag);
+DECLARE_SECTION(hand_flag);
+DECLARE_SECTION(typed_with);
+DECLARE_SECTION(hand_with);
+DECLARE_SECTION(typed_window);
+DECLARE_SECTION(hand_window);
+
+static bool report(const char *name, size_t typed, size_t hand, bool same) {
+  bool ok = same && typed <= hand;
+  printf("%-24s %5zu B %5zu B  %s\n", name, typed, hand,
+         !same ? "DIFFERENT RESULT" : ok ? "ok" : "LARGER");
+  return ok;
+}
+
+int main() {
+  bool sameGet = true, sameFlag = true, sameWith = true, sameWindow = true;
+  for (unsigned reg = 0; reg < 256; reg++) {
+    sameGet &= typedGet(reg) == handGet(reg);
+    sameFlag &= typedFlag(reg) == handFlag(reg);
+    for (unsigned value = 0; value < 256; value++) {
+      sameWith &= typedWith(reg, value) == handWith(reg, value);
+
+      Window typed = {}, hand = {};
+      typed.bytes[0x1E - 0x16] = hand.bytes[0x1E - 0x16] = reg;
+      typedWindow(typed, value);
+      handWindow(hand, value);
+      sameWindow &= typed.bytes[0x1E - 0x16] == hand.bytes[0x1E - 0x16];
+    }
+  }
+
+  printf("%-24s %7s %7s\n", "access", "typed", "hand");
+  bool ok = true;
+  ok &= report("Field::get", SECTION_SIZE(typed_get), SECTION_SIZE(hand_get),
+               sameGet);
+  ok &= report("Field::get (bool)", SECTION_SIZE(typed_flag),
+               SECTION_SIZE(hand_flag), sameFlag);
+  ok &= report("Field::with", SECTION_SIZE(typed_with),
+               SECTION_SIZE(hand_with), sameWith);
+  ok &= report("RegisterWindow::set", SECTION_SIZE(typed_window),
+               SECTION_SIZE(hand_window), sameWindow);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+#include "Arduino.h"
+
+HostSerial Serial;
+
+static uint64_t host_now_us = 0;
+
+static uint8_t host_pin_level[HOST_PIN_COUNT];
+static uint32_t host_pin_writes[HOST_PIN_COUNT];
+static uint32_t host_pin_toggles[HOST_PIN_COUNT];
+
+unsigned long micros(void) { return (unsigned long)host_now_us; }
+unsigned long millis(void) { return (unsigned long)(host_now_us / 1000); }
+void delay(unsigned long ms) { host_now_us += (uint64_t)ms * 1000; }
+void delayMicroseconds(unsigned int us) { host_now_us += us; }
+void hostAdvanceUs(uint64_t us) { host_now_us += us; }
+uint64_t hostTimeUs(void) { return host_now_us; }
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin >= HOST_PIN_COUNT)
+    return;
+  val = val ? HIGH : LOW;
+  host_pin_writes[pin]++;
+  if (host_pin_level[pin] != val)
+    host_pin_toggles[pin]++;
+  host_pin_level[pin] = val;
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < HOST_PIN_COUNT ? host_pin_level[pin] : LOW;
+}
+
+void hostSetInput(uint8_t pin, uint8_t val) {
+  if (pin < HOST_PIN_COUNT)
+    host_pin_level[pin] = val ? HIGH : LOW;
+}
+
+uint32_t hostPinWrites(uint8_t pin) { return host_pin_writes[pin]; }
+uint32_t hostPinToggles(uint8_t pin) { return host_pin_toggles[pin]; }
+
+void hostResetPinCounters(void) {
+  memset(host_pin_writes, 0, sizeof(host_pin_writes));
+  memset(host_pin_toggles, 0, sizeof(host_pin_toggles));
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  for (size_t i = 0; i < size; i++)
+    write(buffer[i]);
+  return size;
+}
+
+size_t Print::print(long n, int base) {
+  if (n < 0 && base == DEC)
+    return print('-') + print((unsigned long)-n, base);
+  return print((unsigned long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+  char buf[24];
+  snprintf(buf, sizeof(buf), base == HEX ? "%lX" : "%lu", n);
+  return write(buf);
+}
+
+size_t Print::print(double n, int digits) {
+  char buf[40];
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write(buf);
+}
+
+size_t HostSerial::write(uint8_t c) { return fputc(c, stdout) == EOF ? 0 : 1; }
+
+#include "SPI.h"
+#include "Wire.h"
+
+SPIClass SPI;
+TwoWire Wire;
@@ -0,0 +1,106 @@
+/*
+ * Minimal Arduino API for building stand libraries on a Linux host.
+ *
+ * Time is virtual: micros()/millis() only advance through delay(),
+ * delayMicroseconds() or hostAdvanceUs(), so long stand sessions run as fast
+ * as the host allows. Pin writes are recorded so bit-banged buses can be
+ * counted and inspected.
+ */
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <ctype.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+typedef uint8_t BitOrder;
+
+#define DEC 10
+#define HEX 16
+
+#define F(s) (s)
+
+#ifndef constrain
+#define constrain(amt, low, high)                                              \
+  ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+
+typedef uint8_t byte;
+
+#define HOST_PIN_COUNT 64
+
+// --- virtual clock
+unsigned long micros(void);
+unsigned long millis(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void hostAdvanceUs(uint64_t us);
+uint64_t hostTimeUs(void);
+
+// --- pins
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+void hostSetInput(uint8_t pin, uint8_t val);
+uint32_t hostPinWrites(uint8_t pin);
+uint32_t hostPinToggles(uint8_t pin);
+void hostResetPinCounters(void);
+
+// --- console
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *str) { return write((const uint8_t *)str, strlen(str)); }
+
+  size_t print(const char *s) { return write(s); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(long n, int base = DEC);
+  size_t print(unsigned long n, int base = DEC);
+  size_t print(int n, int base = DEC) { return print((long)n, base); }
+  size_t print(unsigned int n, int base = DEC) {
+    return print((unsigned long)n, base);
+  }
+  size_t print(unsigned char n, int base = DEC) {
+    return print((unsigned long)n, base);
+  }
+  size_t print(double n, int digits = 2);
+
+  size_t println(void) { return write("\r\n"); }
+  template <typename T> size_t println(T v) { return print(v) + println(); }
+  template <typename T> size_t println(T v, int fmt) {
+    return print(v, fmt) + println();
+  }
+};
+
+class Stream : public Print {
+public:
+  virtual int available(void) { return 0; }
+  virtual int read(void) { return -1; }
+};
+
+/// Serial console backed by stdout/stdin
+class HostSerial : public Stream {
+public:
+  void begin(unsigned long) {}
+  size_t write(uint8_t c) override;
+  using Print::write;
+  operator bool() { return true; }
+};
+
+extern HostSerial Serial;
+
+#endif // HOST_ARDUINO_H
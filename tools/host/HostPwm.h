@@ -0,0 +1,45 @@
+/*
+ * Host stand-in for the stand's PWM output (src/PwmOutput.h).
+ *
+ * Records every duty write with the virtual time it happened at, so a
+ * waveform produced by PwmPlayer can be checked sample by sample.
+ */
+#ifndef HOST_PWM_H
+#define HOST_PWM_H
+
+#include <vector>
+
+#include <Arduino.h>
+
+#include "PwmOutput.h"
+
+struct HostPwmSample {
+  uint64_t timeUs;
+  uint32_t duty;
+};
+
+class HostPwmOutput : public PwmOutput {
+public:
+  bool begin(uint8_t pin, uint32_t frequency, uint8_t resolutionBits) override {
+    if (resolutionBits == 0 || resolutionBits > 14)
+      return false;
+    this->pin = pin;
+    this->frequency = frequency;
+    this->resolutionBits = resolutionBits;
+    attached = true;
+    samples.clear();
+    return true;
+  }
+  void write(uint32_t duty) override {
+    samples.push_back({hostTimeUs(), duty});
+  }
+  void end() override { attached = false; }
+
+  std::vector<HostPwmSample> samples;
+  uint8_t pin = 0;
+  uint32_t frequency = 0;
+  uint8_t resolutionBits = 0;
+  bool attached = false;
+};
+
+#endif
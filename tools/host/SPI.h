@@ -0,0 +1,31 @@
+/*
+ * Hardware SPI placeholder for host builds. Only software (bit-banged) SPI
+ * devices do real work on the host.
+ */
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include "Arduino.h"
+
+#define SPI_MODE0 0
+#define SPI_MODE1 1
+#define SPI_MODE2 2
+#define SPI_MODE3 3
+
+class SPISettings {
+public:
+  SPISettings(uint32_t, uint8_t, uint8_t) {}
+};
+
+class SPIClass {
+public:
+  void begin(void) {}
+  void beginTransaction(SPISettings) {}
+  void endTransaction(void) {}
+  uint8_t transfer(uint8_t data) { return data; }
+  void transfer(void *, size_t) {}
+};
+
+extern SPIClass SPI;
+
+#endif // HOST_SPI_H
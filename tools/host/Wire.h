@@ -0,0 +1,28 @@
+/*
+ * I2C placeholder for host builds. There is no bus on the host: every
+ * transfer NACKs, so host tools talk to simulated devices through
+ * Adafruit_GenericDevice instead.
+ */
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include "Arduino.h"
+
+class TwoWire : public Stream {
+public:
+  void begin(void) {}
+  void end(void) {}
+  void setClock(uint32_t) {}
+  void beginTransmission(uint8_t) {}
+  uint8_t endTransmission(bool stop = true) {
+    (void)stop;
+    return 2; // address NACK
+  }
+  size_t write(uint8_t) override { return 1; }
+  size_t write(const uint8_t *, size_t len) override { return len; }
+  uint8_t requestFrom(uint8_t, uint8_t, uint8_t = 1) { return 0; }
+};
+
+extern TwoWire Wire;
+
+#endif // HOST_WIRE_H
@@ -0,0 +1,111 @@
+/*
+ * PWM/Analog playback vs real-time playback (RTP).
+ *
+ * Plays the stand's click envelope through PwmPlayer into the host PWM
+ * stand-in and checks the samples against the table, then counts what one
+ * RTP update costs on the I2C bus using the DRV2605 model. The two are
+ * compared as achievable amplitude update rates:
+ *
+ *   RTP  - one 3-byte write per sample, limited by the I2C clock;
+ *   LEDC - one duty register store per sample, latched by the hardware once
+ *          per carrier period, so the carrier frequency is the limit.
+ *
+ * Bus software overhead on the ESP32 (tens of microseconds per transaction)
+ * is not included, so the RTP figures are upper bounds.
+ *
+ *   ./pwm_bench
+ */
+#include <Adafruit_DRV2605.h>
+#include <DRV2605_Sim.h>
+#include <HostPwm.h>
+#include <PwmPlayer.h>
+
+// The stand's settings (src/main.cpp)
+#define CARRIER_HZ 50000
+#define RESOLUTION_BITS 10
+#define TICK_US 250
+#define RTP_UPDATES 1000
+
+static DRV2605_Sim sim;
+static Adafruit_DRV2605 drv;
+
+static int checkEnvelope(uint16_t zero) {
+  uint16_t peak = (1 << RESOLUTION_BITS) - 1;
+  uint16_t table[256];
+  uint16_t length = buildEnvelope(table, 256, 20, 80, 120, zero, peak);
+
+  HostPwmOutput out;
+  PwmPlayer player(out);
+  out.begin(4, CARRIER_HZ, RESOLUTION_BITS);
+  player.start(table, length, zero);
+
+  uint64_t start = hostTimeUs();
+  while (player.playing()) {
+    player.tick();
+    hostAdvanceUs(TICK_US);
+  }
+
+  int errors = 0;
+  if (out.samples.size() != (size_t)length + 1u)
+    errors++;
+  for (size_t i = 0; i < out.samples.size(); i++) {
+    uint32_t expected = i < length ? table[i] : zero;
+    if (out.samples[i].duty != expected)
+      errors++;
+    if (out.samples[i].timeUs != start + i * TICK_US)
+      errors++;
+  }
+
+  uint32_t maxDuty = 0;
+  for (const HostPwmSample &s : out.samples)
+    if (s.duty > maxDuty)
+      maxDuty = s.duty;
+
+  printf("envelope zero=%u: %u samples over %lu us, peak %lu, ends at %lu, "
+         "%d errors\n",
+         zero, length, (unsigned long)(length * TICK_US),
+         (unsigned long)maxDuty, (unsigned long)out.samples.back().duty,
+         errors);
+  return errors;
+}
+
+int main() {
+  int errors = checkEnvelope(0);
+  errors += checkEnvelope(1 << (RESOLUTION_BITS - 1));
+
+  drv.begin(sim.device());
+  drv.useLRA();
+  drv.setMode(DRV2605_MODE_REALTIME);
+
+  uint32_t t0 = sim.transactions(), b0 = sim.bytes();
+  for (uint32_t i = 0; i < RTP_UPDATES; i++)
+    drv.setRealtimeValue(i & 0x7F);
+  uint32_t transactions = sim.transactions() - t0;
+  uint32_t bytes = sim.bytes() - b0;
+
+  // Per transaction: START, address, register, STOP; 9 clocks per byte
+  double bits = (transactions * (2 * 9 + 2) + bytes * 9.0) / RTP_UPDATES;
+  printf("\nRTP: %.1f transactions, %.1f data bytes, %.0f bit times per "
+         "update\n",
+         (double)transactions / RTP_UPDATES, (double)bytes / RTP_UPDATES, bits);
+
+  printf("\n%-22s %12s %14s\n", "path", "us/update", "max rate, Hz");
+  const uint32_t clocks[] = {100000, 400000, 1000000};
+  for (uint32_t clock : clocks) {
+    double us = bits * 1e6 / clock;
+    char name[32];
+    snprintf(name, sizeof(name), "RTP, I2C %lu kHz", (unsigned long)(clock / 1000));
+    printf("%-22s %12.1f %14.0f\n", name, us, 1e6 / us);
+  }
+  printf("%-22s %12.1f %14.0f\n", "LEDC carrier", 1e6 / CARRIER_HZ,
+         (double)CARRIER_HZ);
+  printf("%-22s %12.1f %14.0f\n", "stand envelope tick", (double)TICK_US,
+         1e6 / TICK_US);
+
+  // 80 MHz APB clock on the ESP32-C3: carrier * 2^bits cannot exceed it
+  printf("\nLEDC limit per resolution (APB 80 MHz):\n");
+  for (uint8_t bits = 8; bits <= 12; bits++)
+    printf("  %2u bits: carrier up to %7.0f Hz\n", bits, 80e6 / (1 << bits));
+
+  return errors ? 1 : 0;
+}
@@ -0,0 +1,376 @@
+#include "ResultStore.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char fileMagic[4] = {'T', 'R', 'S', '1'};
+static const uint32_t dataKind = 0x4B4E4843; // "CHNK"
+static const uint32_t dictKind = 0x54434944; // "DICT"
+static const size_t nameBytes = 24;
+
+struct FileHeader {
+  char magic[4];
+  uint32_t columns;
+};
+
+struct ColumnDesc {
+  char name[nameBytes];
+  uint8_t type;
+  uint8_t pad[7];
+};
+
+struct ChunkHeader {
+  uint32_t kind;
+  uint32_t count;
+  uint64_t bytes;
+};
+
+static size_t pad8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+static size_t valueBytes(ResultType type) {
+  return type == RESULT_FLOAT ? sizeof(double) : sizeof(int32_t);
+}
+
+std::vector<std::string> splitFields(const std::string &line) {
+  std::vector<std::string> fields;
+  size_t start = 0;
+  for (;;) {
+    size_t comma = line.find(',', start);
+    fields.push_back(line.substr(start, comma - start));
+    if (comma == std::string::npos)
+      return fields;
+    start = comma + 1;
+  }
+}
+
+// ---------------------------------------------------------------- dictionary
+
+int32_t ResultDictionary::find(const std::string &text) const {
+  auto it = ids.find(text);
+  return it == ids.end() ? -1 : it->second;
+}
+
+int32_t ResultDictionary::add(const std::string &text) {
+  auto it = ids.find(text);
+  if (it != ids.end())
+    return it->second;
+  int32_t id = texts.size();
+  texts.push_back(text);
+  ids.emplace(text, id);
+  return id;
+}
+
+// -------------------------------------------------------------------- reader
+
+bool ResultReader::fail(const char *error) {
+  _error = error;
+  close();
+  return false;
+}
+
+bool ResultReader::open(const char *path) {
+  close();
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0)
+    return fail("cannot open store");
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(FileHeader)) {
+    ::close(fd);
+    return fail("not a result store");
+  }
+  _size = st.st_size;
+  void *map = mmap(NULL, _size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED)
+    return fail("cannot map store");
+  _map = (const uint8_t *)map;
+
+  const FileHeader *header = (const FileHeader *)_map;
+  size_t pos = sizeof(FileHeader) + header->columns * sizeof(ColumnDesc);
+  if (memcmp(header->magic, fileMagic, 4) != 0 || header->columns == 0 ||
+      pos > _size)
+    return fail("not a result store");
+
+  const ColumnDesc *descs = (const ColumnDesc *)(header + 1);
+  for (uint32_t i = 0; i < header->columns; i++) {
+    ResultColumn column;
+    column.name.assign(descs[i].name, strnlen(descs[i].name, nameBytes));
+    column.type = (ResultType)descs[i].type;
+    _columns.push_back(column);
+  }
+  _dictionaries.resize(_columns.size());
+
+  // Walk the chunk headers; the data itself stays unread until a scan
+  size_t columns = _columns.size();
+  while (pos + sizeof(ChunkHeader) <= _size) {
+    const ChunkHeader *chunk = (const ChunkHeader *)(_map + pos);
+    const uint8_t *payload = _map + pos + sizeof(ChunkHeader);
+    size_t end = pos + sizeof(ChunkHeader) + chunk->bytes;
+    if (end > _size || chunk->bytes != pad8(chunk->bytes))
+      break;
+
+    if (chunk->kind == dataKind) {
+      ResultChunk data;
+      data.rows = chunk->count;
+      data.min = (const double *)payload;
+      data.max = data.min + columns;
+      size_t offset = 2 * columns * sizeof(double);
+      for (size_t c = 0; c < columns; c++) {
+        data.columns.push_back(payload + offset);
+        offset += pad8(chunk->count * valueBytes(_columns[c].type));
+      }
+      if (offset != chunk->bytes)
+        break;
+      _chunks.push_back(data);
+      _rows += data.rows;
+    } else if (chunk->kind == dictKind) {
+      size_t offset = 0;
+      bool ok = true;
+      for (uint32_t i = 0; i < chunk->count && ok; i++) {
+        uint16_t entry[2];
+        ok = offset + sizeof(entry) <= chunk->bytes;
+        if (!ok)
+          break;
+        memcpy(entry, payload + offset, sizeof(entry));
+        offset += sizeof(entry);
+        ok = entry[0] < columns && offset + entry[1] <= chunk->bytes;
+        if (ok)
+          _dictionaries[entry[0]].add(
+              std::string((const char *)payload + offset, entry[1]));
+        offset += entry[1];
+      }
+      if (!ok)
+        break;
+    } else {
+      break;
+    }
+    pos = end;
+  }
+  _validBytes = pos;
+  return true;
+}
+
+void ResultReader::close() {
+  if (_map)
+    munmap((void *)_map, _size);
+  _map = nullptr;
+  _size = 0;
+  _validBytes = 0;
+  _rows = 0;
+  _columns.clear();
+  _chunks.clear();
+  _dictionaries.clear();
+}
+
+int ResultReader::findColumn(const std::string &name) const {
+  for (size_t i = 0; i < _columns.size(); i++)
+    if (_columns[i].name == name)
+      return i;
+  return -1;
+}
+
+double ResultReader::value(const ResultChunk &chunk, size_t column,
+                           size_t row) const {
+  if (_columns[column].type == RESULT_FLOAT)
+    return chunk.floats(column)[row];
+  return chunk.ints(column)[row];
+}
+
+std::string ResultReader::text(const ResultChunk &chunk, size_t column,
+                               size_t row) const {
+  char buf[32];
+  switch (_columns[column].type) {
+  case RESULT_TEXT: {
+    int32_t id = chunk.ints(column)[row];
+    const std::vector<std::string> &texts = _dictionaries[column].texts;
+    return id >= 0 && (size_t)id < texts.size() ? texts[id] : "?";
+  }
+  case RESULT_FLOAT:
+    snprintf(buf, sizeof(buf), "%.10g", chunk.floats(column)[row]);
+    return buf;
+  default:
+    snprintf(buf, sizeof(buf), "%d", chunk.ints(column)[row]);
+    return buf;
+  }
+}
+
+// -------------------------------------------------------------------- writer
+
+bool ResultWriter::fail(const char *error) {
+  _error = error;
+  return false;
+}
+
+bool ResultWriter::open(const char *path,
+                        const std::vector<ResultColumn> &columns) {
+  close();
+  if (columns.empty() || columns.size() > 0xFFFF)
+    return fail("bad column list");
+  for (const ResultColumn &column : columns)
+    if (column.name.empty() || column.name.size() > nameBytes)
+      return fail("column name is empty or longer than 24 bytes");
+
+  _columns = columns;
+  _dictionaries.assign(columns.size(), ResultDictionary());
+  _newTexts.clear();
+  _ints.assign(columns.size(), std::vector<int32_t>());
+  _floats.assign(columns.size(), std::vector<double>());
+  _row.assign(columns.size(), 0);
+  _rows = 0;
+
+  ResultReader existing;
+  if (access(path, F_OK) == 0) {
+    if (!existing.open(path))
+      return fail(existing.error());
+    if (existing.columnCount() != columns.size())
+      return fail("store has different columns");
+    for (size_t c = 0; c < columns.size(); c++) {
+      if (existing.column(c).name != columns[c].name ||
+          existing.column(c).type != columns[c].type)
+        return fail("store has different columns");
+      _dictionaries[c] = existing.dictionary(c);
+    }
+
+    // A chunk cut short by a crash is dropped before appending
+    size_t valid = existing.validBytes();
+    existing.close();
+    if (truncate(path, valid) != 0)
+      return fail("cannot truncate store");
+    _file = fopen(path, "ab");
+    return _file ? true : fail("cannot open store");
+  }
+
+  _file = fopen(path, "wb");
+  if (!_file)
+    return fail("cannot create store");
+  FileHeader header;
+  memcpy(header.magic, fileMagic, 4);
+  header.columns = columns.size();
+  fwrite(&header, sizeof(header), 1, _file);
+  for (const ResultColumn &column : columns) {
+    ColumnDesc desc;
+    memset(&desc, 0, sizeof(desc));
+    memcpy(desc.name, column.name.data(), column.name.size());
+    desc.type = column.type;
+    fwrite(&desc, sizeof(desc), 1, _file);
+  }
+  return ferror(_file) ? fail("write failed") : true;
+}
+
+bool ResultWriter::close() {
+  if (!_file)
+    return true;
+  bool ok = flush();
+  ok = fclose(_file) == 0 && ok;
+  _file = nullptr;
+  return ok ? true : fail("write failed");
+}
+
+void ResultWriter::set(size_t column, double value) { _row[column] = value; }
+
+void ResultWriter::set(size_t column, const std::string &text) {
+  ResultDictionary &dictionary = _dictionaries[column];
+  size_t before = dictionary.texts.size();
+  int32_t id = dictionary.add(text);
+  if (dictionary.texts.size() != before)
+    _newTexts.emplace_back(column, text.substr(0, 0xFFFF));
+  _row[column] = id;
+}
+
+bool ResultWriter::setFields(const std::vector<std::string> &fields) {
+  if (fields.size() != _columns.size())
+    return fail("wrong number of fields");
+  for (size_t c = 0; c < fields.size(); c++) {
+    const char *s = fields[c].c_str();
+    char *end;
+    switch (_columns[c].type) {
+    case RESULT_TEXT:
+      set(c, fields[c]);
+      continue;
+    case RESULT_FLOAT:
+      set(c, strtod(s, &end));
+      break;
+    default:
+      set(c, (double)(int32_t)strtoll(s, &end, 0));
+      break;
+    }
+    if (end == s || *end)
+      return fail("field is not a number");
+  }
+  return true;
+}
+
+bool ResultWriter::endRow() {
+  if (!_file)
+    return fail("store is not open");
+  for (size_t c = 0; c < _columns.size(); c++) {
+    if (_columns[c].type == RESULT_FLOAT)
+      _floats[c].push_back(_row[c]);
+    else
+      _ints[c].push_back((int32_t)_row[c]);
+    _row[c] = 0;
+  }
+  if (++_rows == chunkRows)
+    return flush();
+  return true;
+}
+
+bool ResultWriter::flush() {
+  static const uint8_t zeros[8] = {0};
+
+  if (!_newTexts.empty()) {
+    size_t bytes = 0;
+    for (const auto &entry : _newTexts)
+      bytes += 4 + entry.second.size();
+    ChunkHeader header = {dictKind, (uint32_t)_newTexts.size(), pad8(bytes)};
+    fwrite(&header, sizeof(header), 1, _file);
+    for (const auto &entry : _newTexts) {
+      uint16_t desc[2] = {entry.first, (uint16_t)entry.second.size()};
+      fwrite(desc, sizeof(desc), 1, _file);
+      fwrite(entry.second.data(), 1, entry.second.size(), _file);
+    }
+    fwrite(zeros, 1, pad8(bytes) - bytes, _file);
+    _newTexts.clear();
+  }
+
+  if (_rows > 0) {
+    size_t columns = _columns.size();
+    std::vector<double> min(columns, INFINITY), max(columns, -INFINITY);
+    size_t bytes = 2 * columns * sizeof(double);
+    for (size_t c = 0; c < columns; c++) {
+      bool isFloat = _columns[c].type == RESULT_FLOAT;
+      for (uint32_t r = 0; r < _rows; r++) {
+        double v = isFloat ? _floats[c][r] : _ints[c][r];
+        if (v < min[c])
+          min[c] = v;
+        if (v > max[c])
+          max[c] = v;
+      }
+      bytes += pad8(_rows * valueBytes(_columns[c].type));
+    }
+
+    ChunkHeader header = {dataKind, _rows, bytes};
+    fwrite(&header, sizeof(header), 1, _file);
+    fwrite(min.data(), sizeof(double), columns, _file);
+    fwrite(max.data(), sizeof(double), columns, _file);
+    for (size_t c = 0; c < columns; c++) {
+      size_t n;
+      if (_columns[c].type == RESULT_FLOAT) {
+        n = _rows * sizeof(double);
+        fwrite(_floats[c].data(), 1, n, _file);
+        _floats[c].clear();
+      } else {
+        n = _rows * sizeof(int32_t);
+        fwrite(_ints[c].data(), 1, n, _file);
+        _ints[c].clear();
+      }
+      fwrite(zeros, 1, pad8(n) - n, _file);
+    }
+    _rows = 0;
+  }
+  return ferror(_file) ? fail("write failed") : true;
+}
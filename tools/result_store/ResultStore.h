@@ -0,0 +1,148 @@
+/*
+ * Columnar result store for sweep and telemetry data.
+ *
+ * A store is one append-only file: a header with the column list, then a
+ * sequence of chunks. A data chunk holds up to ResultWriter::chunkRows rows,
+ * column after column, with the min and max of every column in front so a
+ * query can skip the whole chunk without touching its data. Text columns are
+ * dictionary-encoded; new strings go into a dictionary chunk written before
+ * the first data chunk that uses them. Nothing is ever rewritten, so a store
+ * can grow over many sessions, and a chunk cut short by a crash is dropped
+ * the next time the file is opened.
+ *
+ * The reader maps the file and hands out pointers into it: a scan over
+ * millions of rows only pages in the columns it looks at.
+ *
+ *   header:  "TRS1" u32 columns, then per column: char name[24], u8 type, pad
+ *   chunk:   u32 kind ("CHNK" or "DICT"), u32 count, u64 payload bytes
+ *   data:    f64 min[columns], f64 max[columns], then each column's values
+ *            (i32 or f64), every column padded to 8 bytes
+ *   dict:    per entry u16 column, u16 length, bytes; padded to 8 bytes
+ *
+ * Numbers are stored in host byte order, the file is not meant to move
+ * between machines of different endianness.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum ResultType : uint8_t {
+  RESULT_INT,   // int32
+  RESULT_FLOAT, // double
+  RESULT_TEXT   // int32 id into the column's dictionary
+};
+
+struct ResultColumn {
+  std::string name;
+  ResultType type;
+};
+
+// One data chunk inside the mapped file
+struct ResultChunk {
+  uint32_t rows;
+  const double *min;
+  const double *max;
+  std::vector<const void *> columns;
+
+  const int32_t *ints(size_t column) const {
+    return (const int32_t *)columns[column];
+  }
+  const double *floats(size_t column) const {
+    return (const double *)columns[column];
+  }
+};
+
+// Strings of one text column, both ways
+struct ResultDictionary {
+  std::vector<std::string> texts;
+  std::unordered_map<std::string, int32_t> ids;
+
+  int32_t find(const std::string &text) const;
+  int32_t add(const std::string &text);
+};
+
+class ResultReader {
+public:
+  ~ResultReader() { close(); }
+
+  bool open(const char *path);
+  void close();
+
+  size_t columnCount() const { return _columns.size(); }
+  const ResultColumn &column(size_t index) const { return _columns[index]; }
+  int findColumn(const std::string &name) const;
+
+  size_t chunkCount() const { return _chunks.size(); }
+  const ResultChunk &chunk(size_t index) const { return _chunks[index]; }
+  uint64_t rows() const { return _rows; }
+
+  const ResultDictionary &dictionary(size_t column) const {
+    return _dictionaries[column];
+  }
+  // Value as a number; text columns give the dictionary id
+  double value(const ResultChunk &chunk, size_t column, size_t row) const;
+  // Value as it was written
+  std::string text(const ResultChunk &chunk, size_t column, size_t row) const;
+
+  // Bytes up to the end of the last complete chunk
+  size_t validBytes() const { return _validBytes; }
+  const char *error() const { return _error; }
+
+private:
+  bool fail(const char *error);
+
+  const uint8_t *_map = nullptr;
+  size_t _size = 0;
+  size_t _validBytes = 0;
+  uint64_t _rows = 0;
+  std::vector<ResultColumn> _columns;
+  std::vector<ResultChunk> _chunks;
+  std::vector<ResultDictionary> _dictionaries;
+  const char *_error = "";
+};
+
+class ResultWriter {
+public:
+  static const uint32_t chunkRows = 65536;
+
+  ~ResultWriter() { close(); }
+
+  // Creates the store, or appends to it if it exists with the same columns
+  bool open(const char *path, const std::vector<ResultColumn> &columns);
+  bool close();
+
+  size_t columnCount() const { return _columns.size(); }
+  const ResultColumn &column(size_t index) const { return _columns[index]; }
+
+  // Fill the row column by column, then endRow(); unset columns are 0 / ""
+  void set(size_t column, double value);
+  void set(size_t column, const std::string &text);
+  // Parses every field by its column type: INT takes decimal or 0x hex
+  bool setFields(const std::vector<std::string> &fields);
+  bool endRow();
+
+  const char *error() const { return _error; }
+
+private:
+  bool flush();
+  bool fail(const char *error);
+
+  FILE *_file = nullptr;
+  std::vector<ResultColumn> _columns;
+  std::vector<ResultDictionary> _dictionaries;
+  std::vector<std::pair<uint16_t, std::string>> _newTexts;
+  std::vector<std::vector<int32_t>> _ints;
+  std::vector<std::vector<double>> _floats;
+  std::vector<double> _row;
+  uint32_t _rows = 0;
+  const char *_error = "";
+};
+
+// Splits a CSV line; no quoting, the stand never prints commas in values
+std::vector<std::string> splitFields(const std::string &line);
@@ -0,0 +1,160 @@
+/*
+ * Appends stand output to a result store (ResultStore.h).
+ *
+ *   ./rs_import store.trs [--columns a,b,c] [--types iixs] < log.txt
+ *
+ * Reads a serial log or a CSV from stdin. The columns come from a CSV
+ * header: either a plain first line (stand_farm output) or a `# a,b,c`
+ * comment as the stand prints before its S, T and D lines. A log can hold
+ * several tables; --columns picks one, otherwise the first header wins (or
+ * the columns of an existing store). Rows are taken while that header is the
+ * current one, a one-letter line tag such as `S,` is dropped, and lines with
+ * a different field count are skipped as console chatter.
+ *
+ * Column types come from the first row unless --types gives one letter per
+ * column: i - integer, x - hex integer (STATUS as the stand prints it),
+ * f - float, s - text.
+ */
+#include "ResultStore.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+
+static bool isTag(const std::string &field) {
+  return field.size() == 1 && field[0] >= 'A' && field[0] <= 'Z';
+}
+
+static ResultType guessType(const std::string &field) {
+  const char *s = field.c_str();
+  char *end;
+  strtoll(s, &end, 0);
+  if (end != s && !*end)
+    return RESULT_INT;
+  strtod(s, &end);
+  if (end != s && !*end)
+    return RESULT_FLOAT;
+  return RESULT_TEXT;
+}
+
+int main(int argc, char **argv) {
+  const char *path = nullptr;
+  std::string wanted, types;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--columns") && i + 1 < argc)
+      wanted = argv[++i];
+    else if (!strcmp(argv[i], "--types") && i + 1 < argc)
+      types = argv[++i];
+    else
+      path = argv[i];
+  }
+  if (!path) {
+    fprintf(stderr, "usage: %s store.trs [--columns a,b,c] [--types iixs]\n",
+            argv[0]);
+    return 2;
+  }
+
+  // An existing store fixes the columns and their types
+  std::vector<ResultType> storeTypes;
+  ResultReader existing;
+  if (existing.open(path)) {
+    std::string names;
+    for (size_t c = 0; c < existing.columnCount(); c++) {
+      names += (c ? "," : "") + existing.column(c).name;
+      storeTypes.push_back(existing.column(c).type);
+    }
+    if (wanted.empty())
+      wanted = names;
+  }
+  existing.close();
+
+  ResultWriter writer;
+  std::string header;     // the table we import
+  std::vector<std::string> names;
+  std::string current;    // the table the log is in now
+  std::vector<bool> hex;
+  uint64_t imported = 0, skipped = 0;
+  bool firstLine = true;
+
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    bool comment = line.compare(0, 2, "# ") == 0;
+    bool plainHeader = firstLine && !comment &&
+                       line.find(',') != std::string::npos &&
+                       guessType(splitFields(line)[0]) == RESULT_TEXT &&
+                       !isTag(splitFields(line)[0]);
+    firstLine = false;
+
+    if (comment || plainHeader) {
+      current = line.substr(comment ? 2 : 0);
+      if (header.empty() && current.find(',') != std::string::npos &&
+          (wanted.empty() || wanted == current)) {
+        header = current;
+        names = splitFields(header);
+      }
+      continue;
+    }
+    if (header.empty() || current != header)
+      continue;
+
+    std::vector<std::string> fields = splitFields(line);
+    if (fields.size() == names.size() + 1 && isTag(fields[0]))
+      fields.erase(fields.begin());
+    if (fields.size() != names.size()) {
+      skipped++;
+      continue;
+    }
+
+    if (writer.columnCount() == 0) {
+      if (!types.empty() && types.size() != names.size()) {
+        fprintf(stderr, "--types needs %zu letters\n", names.size());
+        return 2;
+      }
+      std::vector<ResultColumn> columns;
+      for (size_t c = 0; c < names.size(); c++) {
+        ResultType type = guessType(fields[c]);
+        char letter = types.empty() ? 0 : types[c];
+        if (letter == 'i' || letter == 'x')
+          type = RESULT_INT;
+        else if (letter == 'f')
+          type = RESULT_FLOAT;
+        else if (letter == 's')
+          type = RESULT_TEXT;
+        if (storeTypes.size() == names.size())
+          type = storeTypes[c];
+        columns.push_back({names[c], type});
+        hex.push_back(letter == 'x');
+      }
+      if (!writer.open(path, columns)) {
+        fprintf(stderr, "%s: %s\n", path, writer.error());
+        return 1;
+      }
+    }
+
+    for (size_t c = 0; c < fields.size(); c++)
+      if (hex[c])
+        fields[c] = "0x" + fields[c];
+    if (!writer.setFields(fields)) {
+      skipped++;
+      continue;
+    }
+    if (!writer.endRow()) {
+      fprintf(stderr, "%s: %s\n", path, writer.error());
+      return 1;
+    }
+    imported++;
+  }
+
+  if (!writer.close()) {
+    fprintf(stderr, "%s: %s\n", path, writer.error());
+    return 1;
+  }
+  if (header.empty())
+    fprintf(stderr, "no table header found\n");
+  fprintf(stderr, "%llu rows imported, %llu skipped\n",
+          (unsigned long long)imported, (unsigned long long)skipped);
+  return imported ? 0 : 1;
+}
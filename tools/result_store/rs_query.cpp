@@ -0,0 +1,318 @@
+/*
+ * Queries a result store (ResultStore.h) in place, through the file mapping.
+ *
+ *   ./rs_query store.trs                      columns, rows, chunks
+ *   ./rs_query store.trs --where tag=2 --where 'value>=200' [--limit N]
+ *   ./rs_query store.trs --group job --stats value
+ *   ./rs_query store.trs --top 10 value       (or --bottom 10 value)
+ *
+ * --where takes col=v, col!=v, col<v, col<=v, col>v or col>=v; text columns
+ * only compare for (in)equality. Several --where are ANDed. A chunk whose
+ * min/max rule a filter out is skipped without reading its columns, so a
+ * query over a store sorted or appended by time only touches the pages it
+ * needs. --group takes one or more comma-separated columns and prints count,
+ * min, mean and max of the --stats column per group. --top and --bottom
+ * print the best N rows. Output is CSV on stdout, the scan summary goes to
+ * stderr.
+ */
+#include "ResultStore.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <queue>
+
+enum Op { OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE };
+
+struct Filter {
+  size_t column;
+  Op op;
+  double value;
+  bool never; // a text that is not in the dictionary
+};
+
+static ResultReader store;
+
+static bool parseFilter(const char *expr, Filter &filter) {
+  static const struct {
+    const char *token;
+    Op op;
+  } ops[] = {{"!=", OP_NE}, {"<=", OP_LE}, {">=", OP_GE},
+             {"=", OP_EQ},  {"<", OP_LT},  {">", OP_GT}};
+
+  std::string s = expr;
+  for (const auto &candidate : ops) {
+    size_t at = s.find(candidate.token);
+    if (at == std::string::npos || at == 0)
+      continue;
+    int column = store.findColumn(s.substr(0, at));
+    if (column < 0) {
+      fprintf(stderr, "no column %s\n", s.substr(0, at).c_str());
+      return false;
+    }
+    std::string value = s.substr(at + strlen(candidate.token));
+    filter.column = column;
+    filter.op = candidate.op;
+    filter.never = false;
+
+    if (store.column(column).type == RESULT_TEXT) {
+      if (filter.op != OP_EQ && filter.op != OP_NE) {
+        fprintf(stderr, "%s: text columns only take = and !=\n", expr);
+        return false;
+      }
+      int32_t id = store.dictionary(column).find(value);
+      filter.value = id;
+      filter.never = id < 0;
+      return true;
+    }
+    char *end;
+    filter.value = strtod(value.c_str(), &end);
+    if (end == value.c_str() || *end) {
+      fprintf(stderr, "%s: not a number\n", expr);
+      return false;
+    }
+    return true;
+  }
+  fprintf(stderr, "bad filter %s\n", expr);
+  return false;
+}
+
+static bool test(Op op, double v, double ref) {
+  switch (op) {
+  case OP_EQ: return v == ref;
+  case OP_NE: return v != ref;
+  case OP_LT: return v < ref;
+  case OP_LE: return v <= ref;
+  case OP_GT: return v > ref;
+  default: return v >= ref;
+  }
+}
+
+// Whether any row of a chunk can pass, judged by the column's min/max alone
+static bool chunkMayPass(const ResultChunk &chunk, const Filter &filter) {
+  double lo = chunk.min[filter.column], hi = chunk.max[filter.column];
+  switch (filter.op) {
+  case OP_EQ: return !filter.never && filter.value >= lo && filter.value <= hi;
+  case OP_NE: return filter.never || lo != hi || lo != filter.value;
+  case OP_LT: return lo < filter.value;
+  case OP_LE: return lo <= filter.value;
+  case OP_GT: return hi > filter.value;
+  default: return hi >= filter.value;
+  }
+}
+
+static bool rowPasses(const ResultChunk &chunk, size_t row,
+                      const std::vector<Filter> &filters) {
+  for (const Filter &filter : filters) {
+    if (filter.never) {
+      if (filter.op == OP_EQ)
+        return false;
+      continue;
+    }
+    if (!test(filter.op, store.value(chunk, filter.column, row), filter.value))
+      return false;
+  }
+  return true;
+}
+
+static void printRow(const ResultChunk &chunk, size_t row) {
+  for (size_t c = 0; c < store.columnCount(); c++)
+    printf("%s%s", c ? "," : "", store.text(chunk, c, row).c_str());
+  printf("\n");
+}
+
+static void printHeader() {
+  for (size_t c = 0; c < store.columnCount(); c++)
+    printf("%s%s", c ? "," : "", store.column(c).name.c_str());
+}
+
+static bool parseColumns(const char *list, std::vector<size_t> &columns) {
+  for (const std::string &name : splitFields(list)) {
+    int column = store.findColumn(name);
+    if (column < 0) {
+      fprintf(stderr, "no column %s\n", name.c_str());
+      return false;
+    }
+    columns.push_back(column);
+  }
+  return true;
+}
+
+struct Stats {
+  uint64_t count = 0;
+  double min = INFINITY, max = -INFINITY, sum = 0;
+};
+
+// Row reference for --top/--bottom
+struct Hit {
+  double key;
+  uint32_t chunk, row;
+};
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr,
+            "usage: %s store.trs [--where expr]... [--limit N]\n"
+            "       [--group a,b --stats col] [--top N col] [--bottom N col]\n",
+            argv[0]);
+    return 2;
+  }
+  if (!store.open(argv[1])) {
+    fprintf(stderr, "%s: %s\n", argv[1], store.error());
+    return 1;
+  }
+
+  std::vector<Filter> filters;
+  std::vector<size_t> group;
+  int statsColumn = -1, bestColumn = -1;
+  bool bestHigh = true;
+  uint64_t limit = UINT64_MAX, best = 0;
+  for (int i = 2; i < argc; i++) {
+    bool more = i + 1 < argc;
+    Filter filter;
+    if (!strcmp(argv[i], "--where") && more) {
+      if (!parseFilter(argv[++i], filter))
+        return 2;
+      filters.push_back(filter);
+    } else if (!strcmp(argv[i], "--limit") && more) {
+      limit = strtoull(argv[++i], NULL, 0);
+    } else if (!strcmp(argv[i], "--group") && more) {
+      if (!parseColumns(argv[++i], group))
+        return 2;
+    } else if (!strcmp(argv[i], "--stats") && more) {
+      statsColumn = store.findColumn(argv[++i]);
+      if (statsColumn < 0) {
+        fprintf(stderr, "no column %s\n", argv[i]);
+        return 2;
+      }
+    } else if ((!strcmp(argv[i], "--top") || !strcmp(argv[i], "--bottom")) &&
+               i + 2 < argc) {
+      bestHigh = !strcmp(argv[i], "--top");
+      best = strtoull(argv[++i], NULL, 0);
+      bestColumn = store.findColumn(argv[++i]);
+      if (bestColumn < 0) {
+        fprintf(stderr, "no column %s\n", argv[i]);
+        return 2;
+      }
+    } else {
+      fprintf(stderr, "unknown option %s\n", argv[i]);
+      return 2;
+    }
+  }
+
+  if (argc == 2) {
+    for (size_t c = 0; c < store.columnCount(); c++) {
+      static const char *types[] = {"int", "float", "text"};
+      printf("%-24s %-5s", store.column(c).name.c_str(),
+             types[store.column(c).type]);
+      if (store.column(c).type == RESULT_TEXT)
+        printf(" %zu values", store.dictionary(c).texts.size());
+      printf("\n");
+    }
+    printf("%llu rows in %zu chunks\n", (unsigned long long)store.rows(),
+           store.chunkCount());
+    return 0;
+  }
+  if (!group.empty() && statsColumn < 0)
+    statsColumn = group[0];
+
+  auto start = std::chrono::steady_clock::now();
+  uint64_t scanned = 0, matched = 0, printed = 0;
+  size_t skippedChunks = 0;
+  std::map<std::vector<double>, Stats> groups;
+  // The best rows so far, the worst of them on top
+  auto better = [bestHigh](const Hit &a, const Hit &b) {
+    return bestHigh ? a.key > b.key : a.key < b.key;
+  };
+  std::priority_queue<Hit, std::vector<Hit>, decltype(better)> hits(better);
+
+  if (group.empty() && bestColumn < 0) {
+    printHeader();
+    printf("\n");
+  }
+
+  for (size_t k = 0; k < store.chunkCount() && printed < limit; k++) {
+    const ResultChunk &chunk = store.chunk(k);
+    bool mayPass = true;
+    for (const Filter &filter : filters)
+      mayPass = mayPass && chunkMayPass(chunk, filter);
+    if (!mayPass) {
+      skippedChunks++;
+      continue;
+    }
+
+    scanned += chunk.rows;
+    for (size_t row = 0; row < chunk.rows; row++) {
+      if (!rowPasses(chunk, row, filters))
+        continue;
+      matched++;
+
+      if (!group.empty()) {
+        std::vector<double> key;
+        for (size_t column : group)
+          key.push_back(store.value(chunk, column, row));
+        Stats &stats = groups[key];
+        double v = store.value(chunk, statsColumn, row);
+        stats.count++;
+        stats.sum += v;
+        stats.min = std::min(stats.min, v);
+        stats.max = std::max(stats.max, v);
+      } else if (bestColumn >= 0) {
+        Hit hit = {store.value(chunk, bestColumn, row), (uint32_t)k,
+                   (uint32_t)row};
+        if (hits.size() < best) {
+          hits.push(hit);
+        } else if (best && better(hit, hits.top())) {
+          hits.pop();
+          hits.push(hit);
+        }
+      } else if (printed++ < limit) {
+        printRow(chunk, row);
+      } else {
+        break;
+      }
+    }
+  }
+
+  if (!group.empty()) {
+    for (size_t column : group)
+      printf("%s,", store.column(column).name.c_str());
+    printf("count,min,mean,max\n");
+    for (const auto &entry : groups) {
+      for (size_t i = 0; i < group.size(); i++) {
+        size_t column = group[i];
+        double v = entry.first[i];
+        if (store.column(column).type == RESULT_TEXT)
+          printf("%s,", store.dictionary(column).texts[(size_t)v].c_str());
+        else
+          printf("%.10g,", v);
+      }
+      const Stats &stats = entry.second;
+      printf("%llu,%.10g,%.10g,%.10g\n", (unsigned long long)stats.count,
+             stats.min, stats.sum / stats.count, stats.max);
+    }
+  } else if (bestColumn >= 0) {
+    std::vector<Hit> sorted;
+    for (; !hits.empty(); hits.pop())
+      sorted.push_back(hits.top());
+    std::reverse(sorted.begin(), sorted.end());
+    printHeader();
+    printf("\n");
+    for (const Hit &hit : sorted)
+      printRow(store.chunk(hit.chunk), hit.row);
+  }
+
+  double ms = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+  fprintf(stderr,
+          "%llu of %llu rows match, %llu scanned, %zu of %zu chunks skipped, "
+          "%.1f ms\n",
+          (unsigned long long)matched, (unsigned long long)store.rows(),
+          (unsigned long long)scanned, skippedChunks, store.chunkCount(), ms);
+  return 0;
+}
@@ -0,0 +1,227 @@
+/*
+ * Assembler for the stand's test scripts (src/ScriptVm.h).
+ *
+ * Turns a text script into the hex line the stand accepts after `X`, and with
+ * --run executes it on the same interpreter against the DRV2605 model. Bus
+ * transfers advance the virtual clock by their I2C wire time, so the printed
+ * timings show how close the script runs to the bus limit.
+ *
+ *   ./script_asm script.txt [--run] [--clock hz]
+ *
+ * One command per line, `#` starts a comment. Registers are numbers or
+ * names from the table below.
+ */
+#include <Adafruit_DRV2605.h>
+#include <DRV2605_Sim.h>
+#include <ScriptVm.h>
+
+#include <string>
+#include <vector>
+
+static DRV2605_Sim sim;
+static Adafruit_DRV2605 drv;
+static uint32_t busClock = 400000;
+
+struct Name {
+  const char *name;
+  uint8_t value;
+};
+
+static const Name registers[] = {
+    {"STATUS", DRV2605_REG_STATUS},       {"MODE", DRV2605_REG_MODE},
+    {"RTPIN", DRV2605_REG_RTPIN},         {"LIBRARY", DRV2605_REG_LIBRARY},
+    {"WAVESEQ1", DRV2605_REG_WAVESEQ1},   {"WAVESEQ2", DRV2605_REG_WAVESEQ2},
+    {"GO", DRV2605_REG_GO},               {"OVERDRIVE", DRV2605_REG_OVERDRIVE},
+    {"RATED_VOLTAGE", DRV2605_REG_RATEDV}, {"OD_CLAMP", DRV2605_REG_CLAMPV},
+    {"FEEDBACK", DRV2605_REG_FEEDBACK},   {"CONTROL1", DRV2605_REG_CONTROL1},
+    {"CONTROL2", DRV2605_REG_CONTROL2},   {"CONTROL3", DRV2605_REG_CONTROL3},
+    {"CONTROL4", DRV2605_REG_CONTROL4},   {"OL_LRA_PERIOD", DRV2605_REG_OLLRAPERIOD},
+    {"VBAT", DRV2605_REG_VBAT},           {"LRA_PERIOD", DRV2605_REG_LRARESON},
+};
+
+static const Name opcodes[] = {
+    {"end", SCRIPT_END},           {"write", SCRIPT_WRITE},
+    {"burst", SCRIPT_BURST},       {"read", SCRIPT_READ},
+    {"go", SCRIPT_GO},             {"wait_go", SCRIPT_WAIT_GO},
+    {"wait_us", SCRIPT_WAIT_US},   {"wait_ms", SCRIPT_WAIT_MS},
+    {"loop", SCRIPT_LOOP},         {"end_loop", SCRIPT_END_LOOP},
+    {"emit", SCRIPT_EMIT},         {"telemetry", SCRIPT_TELEMETRY},
+    {"mark", SCRIPT_MARK},
+};
+
+static bool lookup(const Name *table, size_t count, const std::string &s,
+                   uint8_t &value) {
+  for (size_t i = 0; i < count; i++) {
+    if (s == table[i].name) {
+      value = table[i].value;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool number(const std::string &s, long &value) {
+  uint8_t reg;
+  if (lookup(registers, sizeof(registers) / sizeof(registers[0]), s, reg)) {
+    value = reg;
+    return true;
+  }
+  char *end;
+  value = strtol(s.c_str(), &end, 0);
+  return !s.empty() && *end == 0;
+}
+
+static bool assemble(FILE *in, std::vector<uint8_t> &code) {
+  char line[256];
+  for (int n = 1; fgets(line, sizeof(line), in); n++) {
+    std::vector<std::string> tokens;
+    for (char *tok = strtok(line, " \t\r\n"); tok && tok[0] != '#';
+         tok = strtok(NULL, " \t\r\n"))
+      tokens.push_back(tok);
+    if (tokens.empty())
+      continue;
+
+    uint8_t op;
+    if (!lookup(opcodes, sizeof(opcodes) / sizeof(opcodes[0]), tokens[0], op)) {
+      fprintf(stderr, "line %d: unknown command %s\n", n, tokens[0].c_str());
+      return false;
+    }
+
+    std::vector<long> args;
+    for (size_t i = 1; i < tokens.size(); i++) {
+      long v;
+      if (!number(tokens[i], v)) {
+        fprintf(stderr, "line %d: bad argument %s\n", n, tokens[i].c_str());
+        return false;
+      }
+      args.push_back(v);
+    }
+
+    code.push_back(op);
+    switch (op) {
+    case SCRIPT_WRITE:
+      if (args.size() != 2)
+        goto bad;
+      code.push_back(args[0]);
+      code.push_back(args[1]);
+      break;
+    case SCRIPT_BURST:
+      if (args.size() < 2 || args.size() > 256)
+        goto bad;
+      code.push_back(args[0]);
+      code.push_back(args.size() - 1);
+      for (size_t i = 1; i < args.size(); i++)
+        code.push_back(args[i]);
+      break;
+    case SCRIPT_READ:
+    case SCRIPT_EMIT:
+      if (args.size() != 1)
+        goto bad;
+      code.push_back(args[0]);
+      break;
+    case SCRIPT_WAIT_GO:
+    case SCRIPT_WAIT_US:
+    case SCRIPT_WAIT_MS:
+    case SCRIPT_LOOP:
+      if (args.size() != 1 || args[0] < 0 || args[0] > 0xFFFF)
+        goto bad;
+      code.push_back(args[0] & 0xFF);
+      code.push_back(args[0] >> 8);
+      break;
+    default:
+      if (!args.empty())
+        goto bad;
+      break;
+    }
+    continue;
+  bad:
+    fprintf(stderr, "line %d: wrong arguments for %s\n", n, tokens[0].c_str());
+    return false;
+  }
+  return true;
+}
+
+// Wire time of a transfer: START, address, register, data, STOP
+static void busTime(uint32_t bytes, bool repeatedStart) {
+  uint32_t bits = 2 + (2 + bytes) * 9 + (repeatedStart ? 10 : 0);
+  hostAdvanceUs((uint64_t)bits * 1000000 / busClock);
+}
+
+class SimHost : public ScriptHost {
+public:
+  void scriptWrite(uint8_t reg, const uint8_t *values, uint8_t len) override {
+    busTime(len, false);
+    drv.writeRegisters(reg, values, len);
+  }
+  uint8_t scriptRead(uint8_t reg) override {
+    busTime(1, true);
+    return drv.readRegister8(reg);
+  }
+  void scriptEmit(uint8_t tag, uint32_t timeUs, uint8_t value) override {
+    printf("S,%u,%lu,%u\n", tag, (unsigned long)timeUs, value);
+  }
+  void scriptTelemetry(uint32_t timeUs) override {
+    busTime(1, true);
+    uint8_t status = drv.readRegister8(DRV2605_REG_STATUS);
+    busTime(2, true);
+    uint8_t values[2];
+    drv.readRegisters(DRV2605_REG_VBAT, values, 2);
+    printf("T,%lu,%u,%u,%u\n", (unsigned long)timeUs, status, values[0],
+           values[1]);
+  }
+};
+
+int main(int argc, char **argv) {
+  const char *path = NULL;
+  bool run = false;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--run"))
+      run = true;
+    else if (!strcmp(argv[i], "--clock") && i + 1 < argc)
+      busClock = atol(argv[++i]);
+    else
+      path = argv[i];
+  }
+
+  FILE *in = path ? fopen(path, "r") : stdin;
+  if (!in) {
+    perror(path);
+    return 1;
+  }
+  std::vector<uint8_t> code;
+  bool ok = assemble(in, code);
+  if (in != stdin)
+    fclose(in);
+  if (!ok)
+    return 1;
+
+  static ScriptVm vm;
+  if (!vm.load(code.data(), code.size())) {
+    fprintf(stderr, "script rejected: %s at byte %lu\n",
+            ScriptVm::errorName(vm.error()), (unsigned long)vm.errorPos());
+    return 1;
+  }
+
+  for (uint8_t b : code)
+    printf("%02X", b);
+  printf("\n");
+  if (!run)
+    return 0;
+
+  drv.begin(sim.device());
+  SimHost host;
+  vm.start();
+  while (vm.running()) {
+    vm.step(host);
+    // The bus task sleeps until the next 1 ms tick between steps
+    if (vm.running())
+      hostAdvanceUs(1000);
+  }
+
+  printf("%lu ops in %lu us at %lu kHz, max wait overrun %lu us%s%s\n",
+         (unsigned long)vm.ops(), (unsigned long)vm.elapsedUs(),
+         (unsigned long)(busClock / 1000), (unsigned long)vm.maxLateUs(),
+         vm.error() ? ", error: " : "",
+         vm.error() ? ScriptVm::errorName(vm.error()) : "");
+  return vm.error() ? 1 : 0;
+}
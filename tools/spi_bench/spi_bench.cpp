@@ -0,0 +1,65 @@
+/*
+ * Software SPI throughput on the host.
+ *
+ * Drives Adafruit_SPIDevice in bit-bang mode against the host pin model and
+ * reports bytes per second and pin activity per byte for every SPI mode and
+ * bit order. Build it twice - with and without -DBUSIO_NO_SWSPI_KERNELS - to
+ * compare the specialised kernels with the generic loop (see tools/README.md).
+ */
+#include <chrono>
+
+#include <Adafruit_SPIDevice.h>
+
+#define PIN_CS 5
+#define PIN_SCK 6
+#define PIN_MISO 7
+#define PIN_MOSI 8
+
+#define BENCH_BYTES 4096
+#define BENCH_ROUNDS 64
+#define BENCH_REPEATS 5
+
+static void bench(uint8_t mode, BusIOBitOrder order, bool miso) {
+  Adafruit_SPIDevice dev(PIN_CS, PIN_SCK, miso ? PIN_MISO : -1, PIN_MOSI,
+                         8000000, order, mode);
+  dev.begin();
+
+  static uint8_t pattern[BENCH_BYTES], buffer[BENCH_BYTES];
+  for (size_t i = 0; i < sizeof(pattern); i++)
+    pattern[i] = (uint8_t)(i * 37 + 11);
+
+  // best of several repeats, the buffer is refilled as MISO overwrites it
+  double seconds = 1e9;
+  for (int n = 0; n < BENCH_REPEATS; n++) {
+    hostResetPinCounters();
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+      memcpy(buffer, pattern, sizeof(buffer));
+      dev.write_and_read(buffer, sizeof(buffer));
+    }
+    auto stop = std::chrono::steady_clock::now();
+    double t = std::chrono::duration<double>(stop - start).count();
+    if (t < seconds)
+      seconds = t;
+  }
+  double bytes = (double)BENCH_BYTES * BENCH_ROUNDS;
+
+  printf("mode %u  %s  %-7s  %10.0f B/s  sck %5.2f  mosi %5.2f writes/byte\n",
+         mode, order == SPI_BITORDER_LSBFIRST ? "LSB" : "MSB",
+         miso ? "miso" : "no-miso", bytes / seconds,
+         hostPinWrites(PIN_SCK) / bytes, hostPinWrites(PIN_MOSI) / bytes);
+}
+
+int main(void) {
+#ifdef BUSIO_NO_SWSPI_KERNELS
+  printf("generic loop\n");
+#else
+  printf("specialised kernels\n");
+#endif
+  for (uint8_t mode = 0; mode < 4; mode++) {
+    bench(mode, SPI_BITORDER_MSBFIRST, true);
+    bench(mode, SPI_BITORDER_LSBFIRST, true);
+    bench(mode, SPI_BITORDER_MSBFIRST, false);
+  }
+  return 0;
+}
@@ -0,0 +1,585 @@
+/*
+ * Runs test-script jobs on several stands at once.
+ *
+ * Stands are found on serial ports (/dev/ttyACM*, /dev/ttyUSB* or --port) by
+ * sending `K` and waiting for the task report. Every stand gets one I/O
+ * thread and its own job deque; jobs are dealt round-robin, and a stand that
+ * runs out steals from the back of the busiest other deque, so fast stands
+ * end up doing more of the sweep. A job is one script from src/ScriptVm.h:
+ * it is uploaded with `X`, started with `R`, and the `S,...` lines up to the
+ * closing `Сценарий:` summary are collected. A stand that stops answering
+ * is dropped and its jobs are stolen by the others.
+ *
+ *   ./stand_farm jobs.txt [--port /dev/ttyACM0 ...] [--emulate N]
+ *
+ * jobs.txt has one job per line: a label and the script hex from script_asm.
+ * --emulate N starts N pseudo-terminal stand-ins instead of using real
+ * ports. Each stand-in is a child process that emulates the firmware
+ * console: DRV2605_Sim on its own virtual clock, the same ScriptVm, and a
+ * speed that differs per stand: stand-in i takes 5*(i+1) % of the script's
+ * virtual run time in real time, so the first one is the fastest.
+ *
+ * Output: `job,stand,tag,t_us,value` for every emitted value, then a
+ * summary per stand.
+ */
+#include <Adafruit_DRV2605.h>
+#include <DRV2605_Sim.h>
+#include <ScriptVm.h>
+
+#include <fcntl.h>
+#include <glob.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define PROBE_MS 1000
+#define UPLOAD_MS 2000
+#define JOB_MS 60000
+#define MAX_ATTEMPTS 2
+
+// ---------------------------------------------------------------- serial I/O
+
+static bool setRaw(int fd) {
+  struct termios tio;
+  if (tcgetattr(fd, &tio) != 0)
+    return false;
+  cfmakeraw(&tio);
+  cfsetispeed(&tio, B115200);
+  cfsetospeed(&tio, B115200);
+  tio.c_cflag |= CLOCAL | CREAD;
+  return tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+static bool writeAll(int fd, const std::string &s) {
+  size_t done = 0;
+  while (done < s.size()) {
+    ssize_t n = write(fd, s.data() + done, s.size() - done);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    done += n;
+  }
+  return true;
+}
+
+// Line reader with a deadline; '\r' is dropped
+class LineReader {
+public:
+  explicit LineReader(int fd) : _fd(fd) {}
+
+  bool readLine(std::string &line, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(timeoutMs);
+    for (;;) {
+      size_t eol = _buf.find('\n');
+      if (eol != std::string::npos) {
+        line = _buf.substr(0, eol);
+        _buf.erase(0, eol + 1);
+        if (!line.empty() && line.back() == '\r')
+          line.pop_back();
+        return true;
+      }
+
+      int left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     deadline - std::chrono::steady_clock::now())
+                     .count();
+      if (left <= 0)
+        return false;
+      struct pollfd pfd = {_fd, POLLIN, 0};
+      int r = poll(&pfd, 1, left);
+      if (r < 0 && errno == EINTR)
+        continue;
+      if (r <= 0 || (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)))
+        return false;
+
+      char chunk[256];
+      ssize_t n = read(_fd, chunk, sizeof(chunk));
+      if (n <= 0)
+        return false;
+      _buf.append(chunk, n);
+    }
+  }
+
+  void discard() {
+    char chunk[256];
+    struct pollfd pfd = {_fd, POLLIN, 0};
+    while (poll(&pfd, 1, 50) > 0 && read(_fd, chunk, sizeof(chunk)) > 0) {
+    }
+    _buf.clear();
+  }
+
+private:
+  int _fd;
+  std::string _buf;
+};
+
+static bool startsWith(const std::string &s, const char *prefix) {
+  return s.compare(0, strlen(prefix), prefix) == 0;
+}
+
+// ------------------------------------------------------------- orchestrator
+
+struct Job {
+  size_t index;
+  std::string label;
+  std::string hex;
+  uint8_t attempts = 0;
+};
+
+struct Result {
+  size_t job;
+  std::string stand;
+  std::vector<std::string> lines; // "tag,t_us,value"
+  std::string summary;
+  bool ok;
+};
+
+struct Stand {
+  std::string port;
+  int fd = -1;
+  std::deque<Job *> queue;
+  std::mutex lock;
+  std::atomic<bool> alive{true};
+  uint32_t done = 0;
+  uint32_t stolen = 0;
+  uint32_t failed = 0;
+  double busySeconds = 0;
+};
+
+static std::vector<Stand *> stands;
+static std::mutex resultsLock;
+static std::vector<Result> results;
+static std::atomic<size_t> remaining{0};
+static std::mutex workLock;
+static std::condition_variable workChanged;
+
+static Job *takeJob(Stand &self) {
+  {
+    std::lock_guard<std::mutex> guard(self.lock);
+    if (!self.queue.empty()) {
+      Job *job = self.queue.front();
+      self.queue.pop_front();
+      return job;
+    }
+  }
+
+  // Steal from the back of the longest queue, dead stands included
+  for (;;) {
+    Stand *victim = nullptr;
+    size_t longest = 0;
+    for (Stand *other : stands) {
+      if (other == &self)
+        continue;
+      std::lock_guard<std::mutex> guard(other->lock);
+      if (other->queue.size() > longest) {
+        longest = other->queue.size();
+        victim = other;
+      }
+    }
+    if (!victim)
+      return nullptr;
+
+    std::lock_guard<std::mutex> guard(victim->lock);
+    if (victim->queue.empty())
+      continue; // someone else was faster, look again
+    Job *job = victim->queue.back();
+    victim->queue.pop_back();
+    self.stolen++;
+    return job;
+  }
+}
+
+// A job came back to a queue or one was finished: wake the idle workers
+static void signalWork() {
+  { std::lock_guard<std::mutex> guard(workLock); }
+  workChanged.notify_all();
+}
+
+static bool anyQueued() {
+  for (Stand *stand : stands) {
+    std::lock_guard<std::mutex> guard(stand->lock);
+    if (!stand->queue.empty())
+      return true;
+  }
+  return false;
+}
+
+// An idle stand waits until every job is done instead of leaving: a stand
+// that dies late gives its job back, and someone has to be there to take it
+static Job *nextJob(Stand &self) {
+  for (;;) {
+    if (Job *job = takeJob(self))
+      return job;
+    std::unique_lock<std::mutex> guard(workLock);
+    workChanged.wait(guard, [] { return remaining == 0 || anyQueued(); });
+    if (remaining == 0)
+      return nullptr;
+  }
+}
+
+static bool probe(int fd) {
+  LineReader reader(fd);
+  reader.discard();
+  if (!writeAll(fd, "K"))
+    return false;
+  std::string line;
+  while (reader.readLine(line, PROBE_MS)) {
+    if (line.find("Очередь ввода") != std::string::npos) {
+      reader.discard();
+      return true;
+    }
+  }
+  return false;
+}
+
+// false - the stand stopped answering, true - the job has a result
+static bool runJob(Stand &stand, LineReader &reader, const Job &job,
+                   Result &result) {
+  result.job = job.index;
+  result.stand = stand.port;
+  result.ok = false;
+
+  std::string line;
+  if (!writeAll(stand.fd, "X" + job.hex + "\n"))
+    return false;
+  for (;;) {
+    if (!reader.readLine(line, UPLOAD_MS))
+      return false;
+    if (startsWith(line, "Сценарий загружен"))
+      break;
+    if (startsWith(line, "Ошибка") || startsWith(line, "Сценарий пуст")) {
+      result.summary = line;
+      return true; // the script is bad, not the stand
+    }
+  }
+
+  if (!writeAll(stand.fd, "R"))
+    return false;
+  for (;;) {
+    if (!reader.readLine(line, JOB_MS))
+      return false;
+    if (startsWith(line, "S,")) {
+      result.lines.push_back(line.substr(2));
+    } else if (startsWith(line, "Сценарий: ")) {
+      result.summary = line.substr(strlen("Сценарий: "));
+      result.ok = line.find("(байт ") == std::string::npos;
+      return true;
+    }
+  }
+}
+
+static void worker(Stand *stand) {
+  LineReader reader(stand->fd);
+  while (Job *job = nextJob(*stand)) {
+    auto start = std::chrono::steady_clock::now();
+    Result result;
+    bool answered = runJob(*stand, reader, *job, result);
+    stand->busySeconds += std::chrono::duration<double>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+
+    if (!answered) {
+      // Give the job back for the others to steal and leave
+      stand->failed++;
+      stand->alive = false;
+      if (++job->attempts < MAX_ATTEMPTS) {
+        std::lock_guard<std::mutex> guard(stand->lock);
+        stand->queue.push_front(job);
+      } else {
+        fprintf(stderr, "%s: job %s dropped after %u attempts\n",
+                stand->port.c_str(), job->label.c_str(), job->attempts);
+        remaining--;
+      }
+      signalWork();
+      fprintf(stderr, "%s: no answer, stand dropped\n", stand->port.c_str());
+      return;
+    }
+
+    stand->done++;
+    {
+      std::lock_guard<std::mutex> guard(resultsLock);
+      results.push_back(result);
+    }
+    remaining--;
+    signalWork();
+  }
+}
+
+// ---------------------------------------------------------------- stand-in
+
+static DRV2605_Sim sim;
+static Adafruit_DRV2605 drv;
+static int emuFd = -1;
+static uint32_t emuSlowdown = 1; // real us per 100 virtual us
+
+static void emuPrint(const std::string &s) { writeAll(emuFd, s); }
+
+// Bus time as on the stand at 400 kHz: START, address, register, data, STOP
+static void emuBusTime(uint32_t bytes, bool repeatedStart) {
+  uint32_t bits = 2 + (2 + bytes) * 9 + (repeatedStart ? 10 : 0);
+  hostAdvanceUs((uint64_t)bits * 1000000 / 400000);
+}
+
+class EmuHost : public ScriptHost {
+public:
+  void scriptWrite(uint8_t reg, const uint8_t *values, uint8_t len) override {
+    emuBusTime(len, false);
+    drv.writeRegisters(reg, values, len);
+  }
+  uint8_t scriptRead(uint8_t reg) override {
+    emuBusTime(1, true);
+    return drv.readRegister8(reg);
+  }
+  void scriptEmit(uint8_t tag, uint32_t timeUs, uint8_t value) override {
+    char line[64];
+    snprintf(line, sizeof(line), "S,%u,%lu,%u\r\n", tag, (unsigned long)timeUs,
+             value);
+    emuPrint(line);
+  }
+  void scriptTelemetry(uint32_t) override {
+    emuBusTime(1, true);
+    drv.readRegister8(DRV2605_REG_STATUS);
+    emuBusTime(2, true);
+    uint8_t values[2];
+    drv.readRegisters(DRV2605_REG_VBAT, values, 2);
+  }
+};
+
+static void emulateStand(int fd, uint32_t slowdown) {
+  emuFd = fd;
+  emuSlowdown = slowdown;
+  drv.begin(sim.device());
+  drv.useLRA();
+
+  static ScriptVm vm;
+  EmuHost host;
+  bool upload = false;
+  std::vector<uint8_t> code;
+  int high = -1;
+
+  char c;
+  while (read(fd, &c, 1) == 1) {
+    if (upload) {
+      if (c == '\n' || c == '\r') {
+        upload = false;
+        if (high < 0 && vm.load(code.data(), code.size())) {
+          emuPrint("Сценарий загружен: " + std::to_string(code.size()) +
+                   " байт, сохранён во flash\r\n");
+        } else {
+          emuPrint(std::string("Ошибка в сценарии: ") +
+                   ScriptVm::errorName(vm.error()) + "\r\n");
+        }
+      } else if (isxdigit((unsigned char)c)) {
+        int nibble = isdigit((unsigned char)c) ? c - '0' : (c | 0x20) - 'a' + 10;
+        if (high < 0) {
+          high = nibble;
+        } else {
+          code.push_back(high << 4 | nibble);
+          high = -1;
+        }
+      }
+      continue;
+    }
+
+    switch (c) {
+    case 'K':
+      emuPrint("шина: 1.0 %\r\nОчередь ввода: макс 1/256, потеряно 0\r\n");
+      break;
+    case 'X':
+      upload = true;
+      code.clear();
+      high = -1;
+      break;
+    case 'R': {
+      emuPrint("# tag,t_us,value\r\n");
+      vm.start();
+      uint64_t virtualStart = hostTimeUs();
+      while (vm.running()) {
+        vm.step(host);
+        if (vm.running())
+          hostAdvanceUs(1000);
+      }
+      usleep((hostTimeUs() - virtualStart) * emuSlowdown / 100);
+
+      std::string line = "Сценарий: ";
+      if (vm.error() != SCRIPT_OK)
+        line += std::string(ScriptVm::errorName(vm.error())) + " (байт " +
+                std::to_string(vm.errorPos()) + "), ";
+      line += std::to_string(vm.ops()) + " команд за " +
+              std::to_string(vm.elapsedUs()) + " мкс, макс. опоздание паузы " +
+              std::to_string(vm.maxLateUs()) + " мкс\r\n";
+      emuPrint(line);
+      break;
+    }
+    default:
+      break;
+    }
+  }
+  _exit(0);
+}
+
+// Opens a pty pair, forks a stand-in on the master and returns the slave path
+static std::string spawnStandIn(uint32_t slowdown, std::vector<pid_t> &pids) {
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+    return "";
+  std::string path = ptsname(master);
+
+  // Raw before anyone writes, or the line discipline echoes the stand-in's
+  // own output back to it
+  int slave = open(path.c_str(), O_RDWR | O_NOCTTY);
+  if (slave < 0 || !setRaw(slave))
+    return "";
+
+  // The child keeps the slave open too: with no slave left the master reads
+  // EIO, and that would end the stand-in before the farm opens the port
+  pid_t pid = fork();
+  if (pid == 0)
+    emulateStand(master, slowdown);
+  close(master);
+  close(slave);
+  pids.push_back(pid);
+  return path;
+}
+
+// -------------------------------------------------------------------- main
+
+static bool loadJobs(const char *path, std::vector<Job> &jobs) {
+  FILE *in = fopen(path, "r");
+  if (!in) {
+    perror(path);
+    return false;
+  }
+  char line[8192];
+  while (fgets(line, sizeof(line), in)) {
+    char label[128], hex[8192];
+    if (line[0] == '#' || sscanf(line, "%127s %8191s", label, hex) != 2)
+      continue;
+    Job job;
+    job.index = jobs.size();
+    job.label = label;
+    job.hex = hex;
+    jobs.push_back(job);
+  }
+  fclose(in);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  const char *jobsPath = nullptr;
+  std::vector<std::string> ports;
+  int emulate = 0;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--port") && i + 1 < argc)
+      ports.push_back(argv[++i]);
+    else if (!strcmp(argv[i], "--emulate") && i + 1 < argc)
+      emulate = atoi(argv[++i]);
+    else
+      jobsPath = argv[i];
+  }
+  if (!jobsPath) {
+    fprintf(stderr, "usage: %s jobs.txt [--port dev ...] [--emulate N]\n",
+            argv[0]);
+    return 2;
+  }
+
+  std::vector<Job> jobs;
+  if (!loadJobs(jobsPath, jobs))
+    return 1;
+
+  std::vector<pid_t> children;
+  for (int i = 0; i < emulate; i++) {
+    std::string path = spawnStandIn(5 * (i + 1), children);
+    if (path.empty()) {
+      perror("pty");
+      return 1;
+    }
+    ports.push_back(path);
+  }
+  if (ports.empty()) {
+    const char *patterns[] = {"/dev/ttyACM*", "/dev/ttyUSB*"};
+    for (const char *pattern : patterns) {
+      glob_t g;
+      if (glob(pattern, 0, NULL, &g) == 0)
+        for (size_t i = 0; i < g.gl_pathc; i++)
+          ports.push_back(g.gl_pathv[i]);
+      globfree(&g);
+    }
+  }
+
+  // Discovery: only ports that answer like a stand take part
+  for (const std::string &port : ports) {
+    int fd = open(port.c_str(), O_RDWR | O_NOCTTY);
+    if (fd < 0 || !setRaw(fd) || !probe(fd)) {
+      fprintf(stderr, "%s: not a stand\n", port.c_str());
+      if (fd >= 0)
+        close(fd);
+      continue;
+    }
+    Stand *stand = new Stand;
+    stand->port = port;
+    stand->fd = fd;
+    stands.push_back(stand);
+  }
+  if (stands.empty()) {
+    fprintf(stderr, "no stands found\n");
+    return 1;
+  }
+  fprintf(stderr, "%zu stands, %zu jobs\n", stands.size(), jobs.size());
+
+  for (size_t i = 0; i < jobs.size(); i++)
+    stands[i % stands.size()]->queue.push_back(&jobs[i]);
+  remaining = jobs.size();
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (Stand *stand : stands)
+    threads.emplace_back(worker, stand);
+  for (std::thread &t : threads)
+    t.join();
+  double wall = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+
+  std::sort(results.begin(), results.end(),
+            [](const Result &a, const Result &b) { return a.job < b.job; });
+  printf("job,stand,tag,t_us,value\n");
+  size_t failedJobs = 0;
+  for (const Result &r : results) {
+    if (!r.ok) {
+      failedJobs++;
+      fprintf(stderr, "%s on %s: %s\n", jobs[r.job].label.c_str(),
+              r.stand.c_str(), r.summary.c_str());
+    }
+    for (const std::string &line : r.lines)
+      printf("%s,%s,%s\n", jobs[r.job].label.c_str(), r.stand.c_str(),
+             line.c_str());
+  }
+
+  fprintf(stderr, "\n%-16s %6s %7s %7s %8s\n", "stand", "jobs", "stolen",
+          "failed", "busy, s");
+  for (Stand *stand : stands)
+    fprintf(stderr, "%-16s %6u %7u %7u %8.2f\n", stand->port.c_str(),
+            stand->done, stand->stolen, stand->failed, stand->busySeconds);
+  fprintf(stderr, "%zu/%zu jobs in %.2f s, %zu with errors, %zu not run\n",
+          results.size(), jobs.size(), wall, failedJobs, (size_t)remaining);
+
+  for (pid_t pid : children) {
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+  }
+  return results.size() == jobs.size() && failedJobs == 0 ? 0 : 1;
+}
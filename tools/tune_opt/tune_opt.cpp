@@ -0,0 +1,219 @@
+/*
+ * Register-space tuning with src/TuneOptimizer.h, off the stand or for it.
+ *
+ *   ./tune_opt [--noise 0.02] [--runs 20]
+ *   ./tune_opt --port /dev/ttyACM0 --measure ./measure_peak.sh
+ *
+ * Without --port the objective is a toy response model of an LRA: peak
+ * acceleration from RATED_VOLTAGE/OD_CLAMP/A_CAL_COMP, ring-down from
+ * FB_BRAKE_FACTOR/LOOP_GAIN with an unstable corner, small optima in the
+ * CONTROL2 timing fields, and a heating penalty for a high clamp. The model
+ * is not a motor, it only gives the search a landscape of the right shape.
+ * The optimiser runs from every factory-like start point and is compared
+ * with a grid sweep of the same space.
+ *
+ * With --port the search runs on the stand (key O) and the host only
+ * measures: for every `O,n,values...` line the stand prints, the --measure
+ * command runs with the values as arguments, and the number it prints goes
+ * back to the stand as the score.
+ */
+#include <TuneOptimizer.h>
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <random>
+#include <string>
+
+// Same fields and order as tuneFields[] in main.cpp
+static const char *names[] = {"RATED_VOLTAGE", "OD_CLAMP",      "A_CAL_COMP",
+                              "FB_BRAKE_FACTOR", "LOOP_GAIN",   "SAMPLE_TIME",
+                              "BLANKING_TIME",   "IDISS_TIME"};
+static const int16_t maxima[] = {255, 255, 255, 7, 3, 3, 3, 3};
+static const uint8_t dims = 8;
+
+struct Response {
+  double peakG;
+  double ringMs;
+};
+
+static Response model(const int16_t *x) {
+  double rated = x[0] * 5.3 / 255;  // V, as RATED_VOLTAGE scales for an LRA
+  double clamp = x[1] * 5.6 / 255;  // V
+  double comp = 1 + (x[2] - 24) / 255.0 * 0.5;
+
+  // Sustained level follows rated voltage up to the clamp; overdrive
+  // headroom above it shortens start-up and lifts the first peak
+  double sustain = fmin(rated, clamp);
+  double boost = 1 + 0.35 * fmin(fmax(clamp - rated, 0), 2) / 2;
+  double raw = 0.9 * sustain * boost * comp;
+  double peak = 3.2 * tanh(raw / 3.2);
+
+  // BLANKING/IDISS mistuned: the back-EMF reading suffers, so does drive
+  peak *= 1 - 0.04 * fabs(x[6] - 1) - 0.03 * fabs(x[7] - 1) -
+          0.02 * fabs(x[5] - 2);
+
+  // FB_BRAKE_FACTOR 7 disables braking; stronger brake and loop gain damp
+  // faster until the loop rings
+  double ring = 40;
+  if (x[3] < 7)
+    ring = 40 / (1 + 0.6 * (x[3] + 1) * (0.6 + 0.3 * x[4]));
+  if (x[3] >= 5 && x[4] >= 2)
+    ring += 12 * (x[3] - 4) * (x[4] - 1);
+  return {peak, ring};
+}
+
+static double score(const int16_t *x) {
+  Response r = model(x);
+  double clamp = x[1] * 5.6 / 255;
+  double heat = clamp > 4.6 ? (clamp - 4.6) * 2.5 : 0;
+  return r.peakG - 0.03 * r.ringMs - heat;
+}
+
+static void printPoint(const int16_t *x) {
+  for (uint8_t i = 0; i < dims; i++)
+    printf(" %s=%d", names[i], x[i]);
+  printf("\n");
+}
+
+// ------------------------------------------------------------------ offload
+
+static int measureOnStand(const char *port, const char *measure) {
+  int fd = open(port, O_RDWR | O_NOCTTY);
+  struct termios tio;
+  if (fd < 0 || tcgetattr(fd, &tio) != 0) {
+    perror(port);
+    return 1;
+  }
+  cfmakeraw(&tio);
+  cfsetspeed(&tio, B115200);
+  tcsetattr(fd, TCSANOW, &tio);
+  FILE *in = fdopen(fd, "r");
+
+  if (write(fd, "O", 1) != 1)
+    return 1;
+  char line[512];
+  while (fgets(line, sizeof(line), in)) {
+    line[strcspn(line, "\r\n")] = 0;
+    if (!strncmp(line, "Подбор", strlen("Подбор"))) {
+      printf("%s\n", line);
+      return 0;
+    }
+    if (strncmp(line, "O,", 2) != 0)
+      continue;
+
+    // O,n,v1,...: the values become arguments of the measure command
+    std::string cmd = measure;
+    const char *values = strchr(line + 2, ',');
+    for (const char *p = values ? values : ""; *p; p++)
+      cmd += *p == ',' ? ' ' : *p;
+    FILE *m = popen(cmd.c_str(), "r");
+    double value;
+    if (!m || fscanf(m, "%lf", &value) != 1) {
+      fprintf(stderr, "%s: no number\n", cmd.c_str());
+      write(fd, "{", 1);
+      return 1;
+    }
+    pclose(m);
+
+    char reply[32];
+    int n = snprintf(reply, sizeof(reply), "%.4f\n", value);
+    printf("%s -> %s", line, reply);
+    fflush(stdout);
+    if (write(fd, reply, n) != n)
+      return 1;
+  }
+  return 1;
+}
+
+// --------------------------------------------------------------- benchmark
+
+int main(int argc, char **argv) {
+  const char *port = nullptr, *measure = nullptr;
+  double noise = 0.02;
+  int runs = 20;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--port") && i + 1 < argc)
+      port = argv[++i];
+    else if (!strcmp(argv[i], "--measure") && i + 1 < argc)
+      measure = argv[++i];
+    else if (!strcmp(argv[i], "--noise") && i + 1 < argc)
+      noise = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--runs") && i + 1 < argc)
+      runs = atoi(argv[++i]);
+  }
+  if (port) {
+    if (!measure) {
+      fprintf(stderr, "--port needs --measure\n");
+      return 2;
+    }
+    return measureOnStand(port, measure);
+  }
+
+  // Grid: every 16th value of the bytes, every value of the narrow fields
+  int16_t x[dims], best[dims];
+  double gridBest = -1e9;
+  uint64_t gridPoints = 0;
+  for (x[0] = 0; x[0] <= 255; x[0] += 17)
+    for (x[1] = 0; x[1] <= 255; x[1] += 17)
+      for (x[2] = 0; x[2] <= 255; x[2] += 17)
+        for (x[3] = 0; x[3] <= 7; x[3]++)
+          for (x[4] = 0; x[4] <= 3; x[4]++)
+            for (x[5] = 0; x[5] <= 3; x[5]++)
+              for (x[6] = 0; x[6] <= 3; x[6]++)
+                for (x[7] = 0; x[7] <= 3; x[7]++) {
+                  gridPoints++;
+                  double s = score(x);
+                  if (s > gridBest) {
+                    gridBest = s;
+                    memcpy(best, x, sizeof(x));
+                  }
+                }
+  printf("grid: %llu plays, best score %.3f\n",
+         (unsigned long long)gridPoints, gridBest);
+  printPoint(best);
+
+  // Optimiser from starts like the stand presets, measured with noise
+  static const int16_t starts[][dims] = {
+      {40, 60, 12, 7, 1, 0, 0, 0},    // soft, no braking
+      {90, 110, 24, 3, 2, 2, 1, 1},   // medium
+      {150, 200, 40, 6, 3, 3, 3, 3},  // strong, ringing corner
+  };
+  std::mt19937 rng(1);
+  std::normal_distribution<double> gauss(0, noise);
+
+  for (const int16_t *start : starts) {
+    double sumScore = 0, worst = 1e9;
+    uint32_t sumEvals = 0;
+    int16_t lastBest[dims];
+    for (int run = 0; run < runs; run++) {
+      int16_t lo[dims] = {0}, step[dims];
+      for (uint8_t i = 0; i < dims; i++)
+        step[i] = (maxima[i] + 1) / 16;
+      TuneOptimizer opt;
+      opt.begin(dims, start, lo, maxima, step, 60);
+
+      int16_t point[dims];
+      while (opt.next(point))
+        opt.report(score(point) + gauss(rng));
+
+      double truth = score(opt.best());
+      sumScore += truth;
+      worst = fmin(worst, truth);
+      sumEvals += opt.evaluations();
+      memcpy(lastBest, opt.best(), sizeof(lastBest));
+    }
+    printf("\nstart score %.3f:", score(start));
+    printPoint(start);
+    printf("optimiser: %.1f plays, true score mean %.3f, worst %.3f "
+           "(noise %.3f, %d runs)\n",
+           (double)sumEvals / runs, sumScore / runs, worst, noise, runs);
+    printPoint(lastBest);
+  }
+  return 0;
+}